@@ -0,0 +1,90 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Digest credential lookups per second :
+ * parsing the htdigest file per request (previous digest_auth_cb())
+ * versus the in-memory credential_store.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "http-server-credential.h"
+
+#define LOOKUP_COUNT 200000
+
+static const char htdigest[] =
+	"# realm\n"
+	"[default]\n"
+	"\n"
+	"# user name and md5 hash for combining name, realm, and password(See RFC 2617)\n"
+	"admin=69513414b7e70f6153f0ce0ee7ebc6d9\n";
+
+static char *lookup_from_file(const char *path, const char *realm, const char *user)
+{
+	GKeyFile *key_file = g_key_file_new();
+	char *password = NULL;
+
+	if (g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, NULL))
+		password = g_key_file_get_string(key_file, realm, user, NULL);
+	g_key_file_unref(key_file);
+
+	return password;
+}
+
+static void report(const char *name, gint64 elapsed_us, int count)
+{
+	printf("%-12s : %10.0f lookups/sec (%.2f us/lookup)\n", name,
+		(double)count * G_USEC_PER_SEC / elapsed_us,
+		(double)elapsed_us / count);
+}
+
+int main(int argc, char *argv[])
+{
+	credential_store *store = NULL;
+	char *path = NULL;
+	gint64 start = 0;
+	int fd = 0;
+	int i = 0;
+
+	fd = g_file_open_tmp("htdigest-XXXXXX", &path, NULL);
+	if (fd < 0)
+		return 1;
+	close(fd);
+	g_file_set_contents(path, htdigest, -1, NULL);
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < LOOKUP_COUNT / 10; i++)
+		g_free(lookup_from_file(path, "default", "admin"));
+	report("file parse", g_get_monotonic_time() - start, LOOKUP_COUNT / 10);
+
+	store = credential_store_new(path);
+	if (!store)
+		return 1;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < LOOKUP_COUNT; i++)
+		g_free(credential_store_lookup(store, "default", "admin"));
+	report("cache", g_get_monotonic_time() - start, LOOKUP_COUNT);
+
+	credential_store_free(store);
+	g_unlink(path);
+	g_free(path);
+
+	return 0;
+}
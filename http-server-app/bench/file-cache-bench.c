@@ -0,0 +1,208 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Static file serving cost per request for bootstrap.min.css and
+ * chart.min.js : the previous hs-route-root.c path (stat, map, copy into
+ * the body, unmap, guess the MIME type) versus a file_cache lookup
+ * whose mapping is handed to the body without a copy.
+ * Then the bytes on the wire for index.html and the assets it loads,
+ * identity against the best content-coding the cache has for each.
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "http-server-file-cache.h"
+
+#define REQUEST_COUNT 20000
+
+static const char *files[] = {
+	"/css/bootstrap.min.css",
+	"/js/chart.min.js",
+};
+
+/* what serve_file() and get_static_contents() did per request */
+static gsize serve_uncached(const char *res_path, const char *path)
+{
+	GMappedFile *map_file = NULL;
+	struct stat st;
+	char *file = NULL;
+	char *body = NULL;
+	char *content_type = NULL;
+	gsize len = 0;
+
+	file = g_strdup_printf("%spublic%s", res_path, path);
+	if (stat(file, &st) == -1) {
+		g_free(file);
+		return 0;
+	}
+
+	map_file = g_mapped_file_new(file, FALSE, NULL);
+	if (map_file) {
+		len = g_mapped_file_get_length(map_file);
+		/* SOUP_MEMORY_COPY */
+		body = g_malloc(len);
+		memcpy(body, g_mapped_file_get_contents(map_file), len);
+		g_mapped_file_unref(map_file);
+	}
+
+	content_type = g_content_type_guess(file, NULL, 0, NULL);
+	if (content_type)
+		g_free(g_content_type_get_mime_type(content_type));
+	g_free(content_type);
+
+	g_free(body);
+	g_free(file);
+
+	return len;
+}
+
+/* what index.html loads before its first paint, in document order */
+static const char *page_assets[] = {
+	"/index.html",
+	"/images/favicon.ico",
+	"/css/bootstrap.min.css",
+	"/css/chart.min.css",
+	"/css/style.css",
+	"/images/tizen-brand.png",
+	"/js/jquery-slim.min.js",
+	"/js/bootstrap.min.js",
+	"/js/feather.min.js",
+	"/js/chart.min.js",
+	"/js/script.js",
+};
+
+/* link rates to turn bytes into transfer time, in kbit/s */
+static const guint link_kbps[] = { 1000, 5000, 20000 };
+
+static gsize serve_cached(file_cache *cache, const char *path)
+{
+	file_cache_entry *entry = NULL;
+	file_cache_entry *owner = NULL;
+	gsize len = 0;
+
+	if (file_cache_lookup(cache, path, &entry))
+		return 0;
+
+	/* soup_buffer_new_with_owner() and its release */
+	file_cache_entry_get_data(entry, &len);
+	owner = file_cache_entry_ref(entry);
+	file_cache_entry_get_mime_type(entry);
+	file_cache_entry_unref(owner);
+	file_cache_entry_unref(entry);
+
+	return len;
+}
+
+static void report(const char *name, const char *path, gint64 elapsed_us, gsize bytes)
+{
+	printf("%-8s %-24s : %8.2f us/request, %8.1f MB/s\n", name, path,
+		(double)elapsed_us / REQUEST_COUNT,
+		(double)bytes / elapsed_us);
+}
+
+static void report_page_assets(file_cache *cache)
+{
+	gsize identity_total = 0;
+	gsize encoded_total = 0;
+	guint i = 0;
+
+	printf("\n%-24s %10s %10s %6s\n", "asset", "identity", "encoded", "coding");
+	for (i = 0; i < G_N_ELEMENTS(page_assets); i++) {
+		file_cache_entry *entry = NULL;
+		const char *coding = "-";
+		gsize identity = 0;
+		gsize encoded = 0;
+		int e = 0;
+
+		if (file_cache_lookup(cache, page_assets[i], &entry)) {
+			fprintf(stderr, "missing %s\n", page_assets[i]);
+			continue;
+		}
+
+		file_cache_entry_get_data(entry, &identity);
+		encoded = identity;
+		for (e = FILE_CACHE_ENCODING_IDENTITY + 1; e < FILE_CACHE_ENCODING_MAX; e++) {
+			gsize len = 0;
+
+			if (file_cache_entry_get_encoded_data(entry, e, &len) && len < encoded) {
+				encoded = len;
+				coding = file_cache_encoding_to_string(e);
+			}
+		}
+		file_cache_entry_unref(entry);
+
+		printf("%-24s %10zu %10zu %6s\n", page_assets[i], identity, encoded, coding);
+		identity_total += identity;
+		encoded_total += encoded;
+	}
+
+	printf("%-24s %10zu %10zu %5.1f%%\n", "total", identity_total, encoded_total,
+		100.0 * (identity_total - encoded_total) / identity_total);
+
+	/* first paint waits for every asset above, bandwidth bound on the link */
+	for (i = 0; i < G_N_ELEMENTS(link_kbps); i++)
+		printf("first paint transfer at %5u kbit/s : %7.1f ms -> %7.1f ms\n",
+			link_kbps[i], identity_total * 8.0 / link_kbps[i],
+			encoded_total * 8.0 / link_kbps[i]);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *res_path = g_getenv("HS_RES_PATH");
+	file_cache *cache = NULL;
+	char *root = NULL;
+	guint i = 0;
+	int j = 0;
+
+	if (!res_path)
+		res_path = "../res/";
+
+	root = g_strdup_printf("%spublic", res_path);
+	cache = file_cache_new(root);
+	g_free(root);
+
+	for (i = 0; i < G_N_ELEMENTS(files); i++) {
+		gint64 start = 0;
+		gsize bytes = 0;
+
+		if (!serve_uncached(res_path, files[i])) {
+			fprintf(stderr, "missing %spublic%s\n", res_path, files[i]);
+			file_cache_free(cache);
+			return 1;
+		}
+
+		start = g_get_monotonic_time();
+		for (j = 0; j < REQUEST_COUNT; j++)
+			bytes += serve_uncached(res_path, files[i]);
+		report("uncached", files[i], g_get_monotonic_time() - start, bytes);
+
+		bytes = 0;
+		start = g_get_monotonic_time();
+		for (j = 0; j < REQUEST_COUNT; j++)
+			bytes += serve_cached(cache, files[i]);
+		report("cached", files[i], g_get_monotonic_time() - start, bytes);
+	}
+
+	report_page_assets(cache);
+
+	file_cache_free(cache);
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The http-server-app routes on a Linux host, with Tizen stand-ins from
+ * stub/, as the target for loadgen.
+ *
+ *   HS_RES_PATH=../res/ ./host-server [-p port] [-n]
+ *
+ * -n disables the session cookie so every request is digest authenticated.
+ * The peak RSS is printed on exit.
+ */
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "http-server-log-private.h"
+#include "http-server-common.h"
+#include "hs-route-root.h"
+#include "hs-route-api-connection.h"
+#include "hs-route-api-applist.h"
+#include "hs-route-api-sysinfo.h"
+#include "hs-route-api-storage.h"
+#include "hs-route-api-image-upload.h"
+#include "hs-route-api-metrics.h"
+#include "hs-route-api-ws.h"
+
+#define SERVER_NAME "http-server-app"
+#define SERVER_PORT 8080
+#define SESSION_TTL (60 * 60)
+
+static gboolean quit_cb(gpointer user_data)
+{
+	g_main_loop_quit(user_data);
+
+	return G_SOURCE_REMOVE;
+}
+
+static int route_modules_init(connection_h connection)
+{
+	retv_if(hs_route_root_init(), -1);
+	retv_if(hs_route_api_connection_init(connection), -1);
+	retv_if(hs_route_api_applist_init(), -1);
+	retv_if(hs_route_api_sysinfo_init(), -1);
+	retv_if(hs_route_api_storage_init(), -1);
+	retv_if(hs_route_api_image_upload_init(), -1);
+	retv_if(hs_route_api_metrics_init(), -1);
+	retv_if(hs_route_api_ws_init(), -1);
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	GMainLoop *loop = NULL;
+	connection_h connection = NULL;
+	struct rusage usage;
+	unsigned int port = SERVER_PORT;
+	gboolean session = TRUE;
+	int opt = 0;
+
+	while ((opt = getopt(argc, argv, "p:n")) != -1) {
+		switch (opt) {
+		case 'p':
+			port = atoi(optarg);
+			break;
+		case 'n':
+			session = FALSE;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-p port] [-n]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (session && http_server_session_enable(NULL, SESSION_TTL))
+		return 1;
+
+	if (connection_create(&connection))
+		return 1;
+
+	if (http_server_create(SERVER_NAME, port) || route_modules_init(connection)
+		|| http_server_start()) {
+		fprintf(stderr, "failed to start server, check HS_RES_PATH\n");
+		hs_route_api_connection_fini();
+		http_server_destroy();
+		connection_destroy(connection);
+		return 1;
+	}
+
+	printf("listening on port %u%s\n", port, session ? "" : " (no session)");
+	fflush(stdout);
+
+	loop = g_main_loop_new(NULL, FALSE);
+	g_unix_signal_add(SIGINT, quit_cb, loop);
+	g_unix_signal_add(SIGTERM, quit_cb, loop);
+	g_main_loop_run(loop);
+
+	hs_route_api_connection_fini();
+	http_server_destroy();
+	connection_destroy(connection);
+	g_main_loop_unref(loop);
+
+	if (!getrusage(RUSAGE_SELF, &usage))
+		printf("peak RSS %ld kB\n", usage.ru_maxrss);
+
+	return 0;
+}
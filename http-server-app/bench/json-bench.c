@@ -0,0 +1,204 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Building the /api/applicationList body for APP_COUNT apps : the previous
+ * JsonBuilder tree plus JsonGenerator string plus the copy into the body,
+ * versus util_json_writer appending into one buffer the body takes over.
+ * Both outputs are parsed back to check they hold the same document.
+ */
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "hs-util-json.h"
+
+#define APP_COUNT 200
+#define BUILD_COUNT 2000
+
+struct app {
+	char *app_id;
+	const char *state;
+	int pid;
+};
+
+static struct app apps[APP_COUNT];
+
+static void apps_init(void)
+{
+	static const char *states[] = { "Installed", "Running", "Service" };
+	int i = 0;
+
+	for (i = 0; i < APP_COUNT; i++) {
+		apps[i].app_id = g_strdup_printf("org.tizen.example.app%03d", i);
+		apps[i].state = states[i % G_N_ELEMENTS(states)];
+		apps[i].pid = (i % 3) ? 1000 + i : 0;
+	}
+	/* something for the escaping to do */
+	g_free(apps[0].app_id);
+	apps[0].app_id = g_strdup("org.tizen.\"quoted\"\\path\ttab");
+}
+
+static void apps_fini(void)
+{
+	int i = 0;
+
+	for (i = 0; i < APP_COUNT; i++)
+		g_free(apps[i].app_id);
+}
+
+/* what the handler did with json-glib, SOUP_MEMORY_COPY included */
+static char *build_json_glib(gsize *len)
+{
+	JsonBuilder *builder = json_builder_new();
+	JsonGenerator *generator = NULL;
+	JsonNode *root = NULL;
+	char *str = NULL;
+	char *body = NULL;
+	int i = 0;
+
+	json_builder_begin_object(builder);
+	json_builder_set_member_name(builder, "installedAppList");
+	json_builder_begin_array(builder);
+	for (i = 0; i < APP_COUNT; i++) {
+		json_builder_begin_object(builder);
+		json_builder_set_member_name(builder, "appId");
+		json_builder_add_string_value(builder, apps[i].app_id);
+		json_builder_set_member_name(builder, "appState");
+		json_builder_add_string_value(builder, apps[i].state);
+		if (apps[i].pid > 0) {
+			json_builder_set_member_name(builder, "appPid");
+			json_builder_add_int_value(builder, apps[i].pid);
+		}
+		json_builder_end_object(builder);
+	}
+	json_builder_end_array(builder);
+	json_builder_set_member_name(builder, "total");
+	json_builder_add_int_value(builder, APP_COUNT);
+	json_builder_end_object(builder);
+
+	root = json_builder_get_root(builder);
+	generator = json_generator_new();
+	json_generator_set_root(generator, root);
+	str = json_generator_to_data(generator, len);
+	g_object_unref(generator);
+	json_node_unref(root);
+	g_object_unref(builder);
+
+	body = g_memdup(str, *len);
+	g_free(str);
+
+	return body;
+}
+
+static char *build_writer(gsize *len)
+{
+	util_json_writer *writer = util_json_writer_new(16 * 1024);
+	int i = 0;
+
+	util_json_begin_object(writer, NULL);
+	util_json_begin_array(writer, "installedAppList");
+	for (i = 0; i < APP_COUNT; i++) {
+		util_json_begin_object(writer, NULL);
+		util_json_add_str(writer, "appId", apps[i].app_id);
+		util_json_add_str(writer, "appState", apps[i].state);
+		if (apps[i].pid > 0)
+			util_json_add_int(writer, "appPid", apps[i].pid);
+		util_json_end_object(writer);
+	}
+	util_json_end_array(writer);
+	util_json_add_int(writer, "total", APP_COUNT);
+	util_json_end_object(writer);
+
+	return util_json_writer_free_to_str(writer, len);
+}
+
+/* re-generated through json-glib, so formatting differences do not count */
+static char *normalize(const char *json, gsize len)
+{
+	JsonParser *parser = json_parser_new();
+	JsonGenerator *generator = NULL;
+	char *str = NULL;
+
+	if (!json_parser_load_from_data(parser, json, len, NULL)) {
+		g_object_unref(parser);
+		return NULL;
+	}
+
+	generator = json_generator_new();
+	json_generator_set_root(generator, json_parser_get_root(parser));
+	str = json_generator_to_data(generator, NULL);
+	g_object_unref(generator);
+	g_object_unref(parser);
+
+	return str;
+}
+
+static double bench(char *(*build)(gsize *), gsize *len)
+{
+	gint64 start = g_get_monotonic_time();
+	int i = 0;
+
+	for (i = 0; i < BUILD_COUNT; i++)
+		g_free(build(len));
+
+	return (double)(g_get_monotonic_time() - start) / BUILD_COUNT;
+}
+
+int main(int argc, char *argv[])
+{
+	char *expected = NULL;
+	char *actual = NULL;
+	char *body = NULL;
+	gsize len = 0;
+	gsize glib_len = 0;
+	gsize writer_len = 0;
+	double glib_us = 0;
+	double writer_us = 0;
+	int ret = 0;
+
+	apps_init();
+
+	body = build_json_glib(&len);
+	expected = normalize(body, len);
+	g_free(body);
+
+	body = build_writer(&len);
+	actual = normalize(body, len);
+	g_free(body);
+
+	if (!expected || !actual || strcmp(expected, actual)) {
+		fprintf(stderr, "writer output differs from json-glib\n");
+		ret = 1;
+		goto out;
+	}
+
+	glib_us = bench(build_json_glib, &glib_len);
+	writer_us = bench(build_writer, &writer_len);
+
+	printf("%d apps, %zu bytes\n", APP_COUNT, writer_len);
+	printf("json-glib : %8.1f us/response (%zu bytes)\n", glib_us, glib_len);
+	printf("writer    : %8.1f us/response (%.1fx)\n", writer_us,
+		writer_us > 0 ? glib_us / writer_us : 0);
+
+out:
+	g_free(expected);
+	g_free(actual);
+	apps_fini();
+
+	return ret;
+}
@@ -0,0 +1,653 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Closed-loop HTTP load generator for host-server (or a device).
+ * Each connection is a keep-alive socket on its own thread, cycling
+ * through the endpoints and answering the digest challenge with the
+ * HA1 from the htdigest file, so no password is needed.
+ *
+ *   ./loadgen [-h host] [-p port] [-c conns] [-d sec] [-a htdigest] [-n] [path...]
+ *
+ * -n never sends the session cookie, every request is digest authenticated.
+ * Reports requests/sec and p50/p99/p999 latency per endpoint.
+ */
+
+#include <glib.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define DEFAULT_HOST "127.0.0.1"
+#define DEFAULT_PORT "8080"
+#define DEFAULT_CONNECTIONS 8
+#define DEFAULT_DURATION 10
+#define DEFAULT_HTDIGEST "../res/auth-data/auth-passwd.dat"
+#define SESSION_COOKIE_NAME "hs_session"
+#define CONN_BUF_SIZE (64 * 1024)
+
+static const char *default_paths[] = {
+	"/index.html",
+	"/css/bootstrap.min.css",
+	"/js/chart.min.js",
+	"/images/tizen-brand.png",
+	"/api/systemInfo",
+	"/api/storage",
+	"/api/applicationList",
+	"/api/connection",
+	"/api/metrics",
+};
+
+static struct {
+	const char *host;
+	const char *port;
+	int connections;
+	int duration;
+	gboolean no_cookie;
+	char *realm;
+	char *user;
+	char *ha1;
+	const char **paths;
+	int path_count;
+	gint64 deadline;
+} g_conf;
+
+struct response {
+	int status;
+	gint64 content_length; /* -1 if not given */
+	gboolean chunked;
+	gboolean close;
+	char *challenge; /* WWW-Authenticate */
+	char *cookie; /* hs_session=... from Set-Cookie */
+};
+
+struct conn {
+	int id;
+	int fd;
+	char *buf;
+	gsize start;
+	gsize end;
+
+	char *nonce;
+	char *opaque;
+	guint nc;
+	char *cookie;
+
+	GArray **latency; /* per path, guint32 usec of successful requests */
+	guint64 *errors; /* per path */
+};
+
+static int conn_connect(struct conn *c)
+{
+	struct addrinfo hints;
+	struct addrinfo *res = NULL;
+	struct addrinfo *ai = NULL;
+	int one = 1;
+	int fd = -1;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if (getaddrinfo(g_conf.host, g_conf.port, &hints, &res))
+		return -1;
+
+	for (ai = res; ai; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (fd < 0)
+			continue;
+		if (!connect(fd, ai->ai_addr, ai->ai_addrlen))
+			break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+
+	if (fd < 0)
+		return -1;
+
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	c->fd = fd;
+	c->start = c->end = 0;
+
+	return 0;
+}
+
+static void conn_close(struct conn *c)
+{
+	if (c->fd >= 0)
+		close(c->fd);
+	c->fd = -1;
+	c->start = c->end = 0;
+}
+
+static int conn_send_all(struct conn *c, const char *data, gsize len)
+{
+	while (len) {
+		ssize_t n = send(c->fd, data, len, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		data += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/* appends at least one byte to the buffer */
+static int conn_fill(struct conn *c)
+{
+	ssize_t n = 0;
+
+	if (c->start == c->end) {
+		c->start = c->end = 0;
+	} else if (c->end == CONN_BUF_SIZE) {
+		if (!c->start)
+			return -1; /* a header block larger than the buffer */
+		memmove(c->buf, c->buf + c->start, c->end - c->start);
+		c->end -= c->start;
+		c->start = 0;
+	}
+
+	do {
+		n = recv(c->fd, c->buf + c->end, CONN_BUF_SIZE - c->end, 0);
+	} while (n < 0 && errno == EINTR);
+
+	if (n <= 0)
+		return -1;
+	c->end += n;
+
+	return 0;
+}
+
+/* returns a pointer to the next line in the buffer, NUL terminated without CRLF */
+static char *conn_read_line(struct conn *c)
+{
+	char *line = NULL;
+	char *eol = NULL;
+
+	while (!(eol = memchr(c->buf + c->start, '\n', c->end - c->start))) {
+		if (conn_fill(c))
+			return NULL;
+	}
+
+	line = c->buf + c->start;
+	c->start = eol - c->buf + 1;
+	if (eol > line && eol[-1] == '\r')
+		eol--;
+	*eol = '\0';
+
+	return line;
+}
+
+static int conn_skip(struct conn *c, gint64 len)
+{
+	while (len > 0) {
+		gsize avail = c->end - c->start;
+
+		if (!avail) {
+			if (conn_fill(c))
+				return -1;
+			continue;
+		}
+		if ((gint64)avail > len)
+			avail = len;
+		c->start += avail;
+		len -= avail;
+	}
+
+	return 0;
+}
+
+static int conn_skip_chunked(struct conn *c)
+{
+	char *line = NULL;
+	gint64 size = 0;
+
+	do {
+		line = conn_read_line(c);
+		if (!line)
+			return -1;
+		size = g_ascii_strtoll(line, NULL, 16);
+		if (size < 0 || conn_skip(c, size))
+			return -1;
+		/* CRLF after the chunk, or the end of the (empty) trailer */
+		if (!conn_read_line(c))
+			return -1;
+	} while (size > 0);
+
+	return 0;
+}
+
+static void response_clear(struct response *resp)
+{
+	g_free(resp->challenge);
+	g_free(resp->cookie);
+	memset(resp, 0, sizeof(*resp));
+}
+
+static int conn_read_response(struct conn *c, struct response *resp)
+{
+	char *line = NULL;
+
+	memset(resp, 0, sizeof(*resp));
+	resp->content_length = -1;
+
+	line = conn_read_line(c);
+	if (!line || strncmp(line, "HTTP/1.", 7))
+		return -1;
+	resp->status = atoi(line + 9);
+	resp->close = (line[7] == '0');
+
+	while ((line = conn_read_line(c)) && *line) {
+		char *value = strchr(line, ':');
+
+		if (!value)
+			continue;
+		*value++ = '\0';
+		while (*value == ' ')
+			value++;
+
+		if (!g_ascii_strcasecmp(line, "Content-Length")) {
+			resp->content_length = g_ascii_strtoll(value, NULL, 10);
+		} else if (!g_ascii_strcasecmp(line, "Transfer-Encoding")) {
+			resp->chunked = !g_ascii_strcasecmp(value, "chunked");
+		} else if (!g_ascii_strcasecmp(line, "Connection")) {
+			if (!g_ascii_strcasecmp(value, "close"))
+				resp->close = TRUE;
+		} else if (!g_ascii_strcasecmp(line, "WWW-Authenticate")) {
+			if (!resp->challenge && !g_ascii_strncasecmp(value, "Digest ", 7))
+				resp->challenge = g_strdup(value + 7);
+		} else if (!g_ascii_strcasecmp(line, "Set-Cookie")) {
+			if (g_str_has_prefix(value, SESSION_COOKIE_NAME "=")) {
+				g_free(resp->cookie);
+				resp->cookie = g_strndup(value, strcspn(value, ";"));
+			}
+		}
+	}
+	if (!line)
+		return -1;
+
+	if (resp->status == 204 || resp->status == 304)
+		return 0;
+	if (resp->chunked)
+		return conn_skip_chunked(c);
+	if (resp->content_length >= 0)
+		return conn_skip(c, resp->content_length);
+
+	/* body until the server closes the connection */
+	while (!conn_fill(c))
+		c->start = c->end;
+	resp->close = TRUE;
+
+	return 0;
+}
+
+/* value of name="..." or name=token in a digest challenge */
+static char *challenge_param(const char *challenge, const char *name)
+{
+	gsize name_len = strlen(name);
+	const char *p = challenge;
+
+	while (p && *p) {
+		while (*p == ' ' || *p == ',')
+			p++;
+
+		if (!g_ascii_strncasecmp(p, name, name_len) && p[name_len] == '=') {
+			p += name_len + 1;
+			if (*p == '"')
+				return g_strndup(p + 1, strcspn(p + 1, "\""));
+			return g_strndup(p, strcspn(p, ", "));
+		}
+
+		/* skip to the next parameter, quoted values may contain commas */
+		while (*p && *p != ',') {
+			if (*p == '"') {
+				p = strchr(p + 1, '"');
+				if (!p)
+					return NULL;
+			}
+			p++;
+		}
+	}
+
+	return NULL;
+}
+
+static void conn_set_challenge(struct conn *c, const char *challenge)
+{
+	g_free(c->nonce);
+	g_free(c->opaque);
+	c->nonce = challenge_param(challenge, "nonce");
+	c->opaque = challenge_param(challenge, "opaque");
+	c->nc = 0;
+}
+
+static void conn_append_digest(struct conn *c, GString *req, const char *path)
+{
+	char cnonce[17];
+	char nc[9];
+	char *a2 = NULL;
+	char *ha2 = NULL;
+	char *kd = NULL;
+	char *response = NULL;
+
+	g_snprintf(nc, sizeof(nc), "%08x", ++c->nc);
+	g_snprintf(cnonce, sizeof(cnonce), "%08x%08x", g_random_int(), g_random_int());
+
+	a2 = g_strconcat("GET:", path, NULL);
+	ha2 = g_compute_checksum_for_string(G_CHECKSUM_MD5, a2, -1);
+	kd = g_strjoin(":", g_conf.ha1, c->nonce, nc, cnonce, "auth", ha2, NULL);
+	response = g_compute_checksum_for_string(G_CHECKSUM_MD5, kd, -1);
+
+	g_string_append_printf(req,
+		"Authorization: Digest username=\"%s\", realm=\"%s\", nonce=\"%s\", "
+		"uri=\"%s\", response=\"%s\", qop=auth, nc=%s, cnonce=\"%s\", algorithm=MD5",
+		g_conf.user, g_conf.realm, c->nonce, path, response, nc, cnonce);
+	if (c->opaque)
+		g_string_append_printf(req, ", opaque=\"%s\"", c->opaque);
+	g_string_append(req, "\r\n");
+
+	g_free(response);
+	g_free(kd);
+	g_free(ha2);
+	g_free(a2);
+}
+
+/* one GET including a digest challenge round trip, returns the status or -1 */
+static int conn_request(struct conn *c, GString *req, const char *path)
+{
+	struct response resp = { 0, };
+	int attempt = 0;
+	int status = -1;
+
+	for (attempt = 0; attempt < 2; attempt++) {
+		if (c->fd < 0 && conn_connect(c))
+			return -1;
+
+		g_string_printf(req, "GET %s HTTP/1.1\r\nHost: %s:%s\r\n",
+				path, g_conf.host, g_conf.port);
+		if (c->cookie)
+			g_string_append_printf(req, "Cookie: %s\r\n", c->cookie);
+		else if (c->nonce)
+			conn_append_digest(c, req, path);
+		g_string_append(req, "\r\n");
+
+		if (conn_send_all(c, req->str, req->len)
+			|| conn_read_response(c, &resp)) {
+			response_clear(&resp);
+			conn_close(c);
+			return -1;
+		}
+
+		status = resp.status;
+		if (resp.cookie && !g_conf.no_cookie) {
+			g_free(c->cookie);
+			c->cookie = g_steal_pointer(&resp.cookie);
+		}
+		if (resp.close)
+			conn_close(c);
+
+		if (status != 401 || !resp.challenge) {
+			response_clear(&resp);
+			break;
+		}
+
+		/* expired session or stale nonce, authenticate again */
+		g_clear_pointer(&c->cookie, g_free);
+		conn_set_challenge(c, resp.challenge);
+		response_clear(&resp);
+	}
+
+	return status;
+}
+
+static gpointer conn_thread(gpointer data)
+{
+	struct conn *c = data;
+	GString *req = g_string_sized_new(512);
+	guint i = c->id;
+
+	while (g_get_monotonic_time() < g_conf.deadline) {
+		int index = i++ % g_conf.path_count;
+		gint64 start = g_get_monotonic_time();
+		int status = conn_request(c, req, g_conf.paths[index]);
+		guint32 elapsed = g_get_monotonic_time() - start;
+
+		if (status >= 200 && status < 400)
+			g_array_append_val(c->latency[index], elapsed);
+		else
+			c->errors[index]++;
+	}
+
+	conn_close(c);
+	g_string_free(req, TRUE);
+
+	return NULL;
+}
+
+static int htdigest_load(const char *path)
+{
+	GKeyFile *key_file = g_key_file_new();
+	GError *error = NULL;
+	char **keys = NULL;
+
+	if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, &error)) {
+		fprintf(stderr, "failed to load %s - %s\n", path, error->message);
+		g_error_free(error);
+		g_key_file_unref(key_file);
+		return -1;
+	}
+
+	/* the first user of the first realm */
+	g_conf.realm = g_key_file_get_start_group(key_file);
+	if (g_conf.realm)
+		keys = g_key_file_get_keys(key_file, g_conf.realm, NULL, NULL);
+	if (keys && keys[0]) {
+		g_conf.user = g_strdup(keys[0]);
+		g_conf.ha1 = g_key_file_get_string(key_file, g_conf.realm, keys[0], NULL);
+	}
+	g_strfreev(keys);
+	g_key_file_unref(key_file);
+
+	if (!g_conf.ha1) {
+		fprintf(stderr, "no user in %s\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+static gint latency_cmp(gconstpointer a, gconstpointer b)
+{
+	guint32 x = *(const guint32 *)a;
+	guint32 y = *(const guint32 *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* nearest rank, in msec */
+static double percentile(GArray *sorted, double p)
+{
+	guint rank = 0;
+
+	if (!sorted->len)
+		return 0.0;
+
+	rank = (guint)(p * sorted->len + 0.999999);
+	if (rank < 1)
+		rank = 1;
+	if (rank > sorted->len)
+		rank = sorted->len;
+
+	return g_array_index(sorted, guint32, rank - 1) / 1000.0;
+}
+
+static void report_line(const char *name, GArray *sorted, guint64 errors, double elapsed)
+{
+	printf("%-28s %9u %7" G_GUINT64_FORMAT " %10.1f %8.2f %8.2f %8.2f\n",
+		name, sorted->len, errors, sorted->len / elapsed,
+		percentile(sorted, 0.50), percentile(sorted, 0.99),
+		percentile(sorted, 0.999));
+}
+
+static void report(struct conn *conns, double elapsed)
+{
+	GArray *total = g_array_new(FALSE, FALSE, sizeof(guint32));
+	guint64 total_errors = 0;
+	int i = 0;
+	int j = 0;
+
+	printf("%d connections, %.1f sec, %s@%s:%s\n\n", g_conf.connections,
+		elapsed, g_conf.user, g_conf.host, g_conf.port);
+	printf("%-28s %9s %7s %10s %8s %8s %8s\n", "endpoint", "requests",
+		"errors", "req/s", "p50 ms", "p99 ms", "p999 ms");
+
+	for (i = 0; i < g_conf.path_count; i++) {
+		GArray *sorted = g_array_new(FALSE, FALSE, sizeof(guint32));
+		guint64 errors = 0;
+
+		for (j = 0; j < g_conf.connections; j++) {
+			GArray *lat = conns[j].latency[i];
+
+			g_array_append_vals(sorted, lat->data, lat->len);
+			errors += conns[j].errors[i];
+		}
+		g_array_append_vals(total, sorted->data, sorted->len);
+		total_errors += errors;
+
+		g_array_sort(sorted, latency_cmp);
+		report_line(g_conf.paths[i], sorted, errors, elapsed);
+		g_array_free(sorted, TRUE);
+	}
+
+	g_array_sort(total, latency_cmp);
+	printf("\n");
+	report_line("total", total, total_errors, elapsed);
+	g_array_free(total, TRUE);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *htdigest = DEFAULT_HTDIGEST;
+	struct conn *conns = NULL;
+	GThread **threads = NULL;
+	gint64 start = 0;
+	int opt = 0;
+	int i = 0;
+	int j = 0;
+
+	g_conf.host = DEFAULT_HOST;
+	g_conf.port = DEFAULT_PORT;
+	g_conf.connections = DEFAULT_CONNECTIONS;
+	g_conf.duration = DEFAULT_DURATION;
+
+	while ((opt = getopt(argc, argv, "h:p:c:d:a:n")) != -1) {
+		switch (opt) {
+		case 'h':
+			g_conf.host = optarg;
+			break;
+		case 'p':
+			g_conf.port = optarg;
+			break;
+		case 'c':
+			g_conf.connections = atoi(optarg);
+			break;
+		case 'd':
+			g_conf.duration = atoi(optarg);
+			break;
+		case 'a':
+			htdigest = optarg;
+			break;
+		case 'n':
+			g_conf.no_cookie = TRUE;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-h host] [-p port] [-c conns] [-d sec] "
+				"[-a htdigest] [-n] [path...]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (g_conf.connections < 1 || g_conf.duration < 1) {
+		fprintf(stderr, "connections and duration must be positive\n");
+		return 1;
+	}
+
+	if (optind < argc) {
+		g_conf.paths = (const char **)&argv[optind];
+		g_conf.path_count = argc - optind;
+	} else {
+		g_conf.paths = default_paths;
+		g_conf.path_count = G_N_ELEMENTS(default_paths);
+	}
+
+	if (htdigest_load(htdigest))
+		return 1;
+
+	conns = g_new0(struct conn, g_conf.connections);
+	threads = g_new0(GThread *, g_conf.connections);
+
+	start = g_get_monotonic_time();
+	g_conf.deadline = start + (gint64)g_conf.duration * G_USEC_PER_SEC;
+
+	for (i = 0; i < g_conf.connections; i++) {
+		struct conn *c = &conns[i];
+
+		c->id = i;
+		c->fd = -1;
+		c->buf = g_malloc(CONN_BUF_SIZE);
+		c->latency = g_new0(GArray *, g_conf.path_count);
+		c->errors = g_new0(guint64, g_conf.path_count);
+		for (j = 0; j < g_conf.path_count; j++)
+			c->latency[j] = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+		threads[i] = g_thread_new("loadgen", conn_thread, c);
+	}
+
+	for (i = 0; i < g_conf.connections; i++)
+		g_thread_join(threads[i]);
+
+	report(conns, (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC);
+
+	for (i = 0; i < g_conf.connections; i++) {
+		struct conn *c = &conns[i];
+
+		for (j = 0; j < g_conf.path_count; j++)
+			g_array_free(c->latency[j], TRUE);
+		g_free(c->latency);
+		g_free(c->errors);
+		g_free(c->buf);
+		g_free(c->nonce);
+		g_free(c->opaque);
+		g_free(c->cookie);
+	}
+	g_free(threads);
+	g_free(conns);
+	g_free(g_conf.realm);
+	g_free(g_conf.user);
+	g_free(g_conf.ha1);
+
+	return 0;
+}
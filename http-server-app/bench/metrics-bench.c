@@ -0,0 +1,60 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of recording one request into the route metrics,
+ * to check it is cheap enough to stay enabled.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "http-server-metrics.h"
+
+#define RECORD_COUNT 10000000
+
+static const char *routes[] = {
+	"/*", "/api/storage", "/api/systemInfo", "/api/applicationList",
+	"/api/connection", "/api/connection/wifiScan", "/api/faceDetect",
+};
+
+int main(int argc, char *argv[])
+{
+	route_metrics *metrics[G_N_ELEMENTS(routes)];
+	gint64 start = 0;
+	gint64 elapsed = 0;
+	char *dump = NULL;
+	guint i = 0;
+
+	for (i = 0; i < G_N_ELEMENTS(routes); i++)
+		metrics[i] = route_metrics_get("GET", routes[i]);
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < RECORD_COUNT; i++)
+		route_metrics_record(metrics[i % G_N_ELEMENTS(routes)],
+			(i & 0xff) ? 200 : 404, 1024, (i * 37) & 0xfffff);
+	elapsed = g_get_monotonic_time() - start;
+
+	printf("record : %.1f ns/request\n", (double)elapsed * 1000.0 / RECORD_COUNT);
+
+	start = g_get_monotonic_time();
+	dump = route_metrics_dump();
+	printf("dump   : %" G_GINT64_FORMAT " us, %zu bytes\n",
+		g_get_monotonic_time() - start, strlen(dump));
+	g_free(dump);
+
+	return 0;
+}
@@ -0,0 +1,296 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The camera to relay pipeline (usb-camera.c, face-detect.c,
+ * face-recognize.c and resource_relay.c) on the simulation runtime in sim/.
+ *
+ *   HS_RES_PATH=../res/ ./pipeline-sim [-i input] [-f fps] [-d sec]
+ *                                      [-D detect_ms] [-R recognize_ms] [-l face_luma]
+ *                                      [-I interval_ms] [-F] [-n cameras] [-S slots]
+ *
+ * input is an I420 file, a PNG file or a directory of PNG files
+ * (see sim/sim.h), a synthetic frame with a face when not given.
+ * Detection runs on motion and every interval_ms on a still scene,
+ * -F samples only every interval_ms, without the motion gate.
+ * -n runs that many cameras on the same input, their detection workers
+ * share -S detection slots.
+ * Reports frames/sec, detections, CPU use and the latency from a camera
+ * frame to the relay write it caused, then fps and detection latency
+ * per camera.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "app.h"
+#include "http-server-metrics.h"
+#include "usb-camera.h"
+#include "face-detect.h"
+#include "face-recognize.h"
+#include "resource_relay.h"
+#include "resource_relay_internal.h"
+#include "sim.h"
+
+#define RELAY_PIN 19
+#define DEFAULT_FPS 30
+#define DEFAULT_DURATION 20
+#define DEFAULT_DETECT_MS 40
+#define DEFAULT_RECOGNIZE_MS 15
+#define DEFAULT_INTERVAL_MS 3000
+#define DEFAULT_CAMERAS 1
+#define MAX_CAMERAS 10
+
+static gboolean quit_cb(gpointer user_data)
+{
+	g_main_loop_quit(user_data);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gint64 cpu_time(void)
+{
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	return (gint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * G_USEC_PER_SEC
+		+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static gint latency_cmp(gconstpointer a, gconstpointer b)
+{
+	gint64 x = *(const gint64 *)a;
+	gint64 y = *(const gint64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* nearest rank, in msec */
+static double percentile(GArray *sorted, double p)
+{
+	guint rank = 0;
+
+	if (!sorted->len)
+		return 0.0;
+
+	rank = (guint)(p * sorted->len + 0.999999);
+	if (rank < 1)
+		rank = 1;
+	if (rank > sorted->len)
+		rank = sorted->len;
+
+	return g_array_index(sorted, gint64, rank - 1) / 1000.0;
+}
+
+static guint64 camera_counter(const char *name, int camera)
+{
+	char label[16];
+
+	snprintf(label, sizeof(label), "%d", camera);
+
+	return metrics_counter_value(metrics_counter_get_labeled(name, "camera", label, NULL));
+}
+
+/* over all cameras */
+static guint64 counter_sum(const char *name, int cameras)
+{
+	guint64 sum = 0;
+	int i = 0;
+
+	for (i = 0; i < cameras; i++)
+		sum += camera_counter(name, i);
+
+	return sum;
+}
+
+static void report(double elapsed, gint64 cpu_us, GArray *events, int cameras)
+{
+	GArray *latency = g_array_new(FALSE, FALSE, sizeof(gint64));
+	guint frames = sim_camera_frame_count();
+	guint detections = 0;
+	guint faces = 0;
+	guint recognitions = 0;
+	guint on = 0;
+	guint off = 0;
+	guint i = 0;
+
+	sim_vision_get_counts(&detections, &faces, &recognitions);
+
+	for (i = 0; i < events->len; i++) {
+		sim_gpio_event *event = &g_array_index(events, sim_gpio_event, i);
+
+		if (event->pin != RELAY_PIN)
+			continue;
+		if (event->value)
+			on++;
+		else
+			off++;
+		if (event->latency >= 0)
+			g_array_append_val(latency, event->latency);
+	}
+	g_array_sort(latency, latency_cmp);
+
+	printf("frames        : %u (%.1f fps)\n", frames, frames / elapsed);
+	printf("detections    : %u (%.2f/sec), faces %u, recognitions %u\n",
+		detections, detections / elapsed, faces, recognitions);
+	printf("relay writes  : %u on, %u off, thingspark sends %u\n",
+		on, off, sim_tp_send_count());
+	printf("face results  : %u passed to the stream\n",
+		sim_face_notify_count());
+	printf("frames gated  : %" G_GUINT64_FORMAT " still, %" G_GUINT64_FORMAT " to detection\n",
+		counter_sum("camera_frames_still_total", cameras),
+		counter_sum("camera_frames_total", cameras));
+	printf("detect worker : %" G_GUINT64_FORMAT " detected, %" G_GUINT64_FORMAT " replaced in the mailbox\n",
+		counter_sum("face_detect_frames_total", cameras),
+		counter_sum("face_detect_frames_replaced_total", cameras));
+	printf("frame pool    : %" G_GUINT64_FORMAT " dropped, %" G_GUINT64_FORMAT
+		" allocs, %" G_GUINT64_FORMAT " bytes copied\n",
+		counter_sum("camera_frames_dropped_total", cameras),
+		metrics_counter_value(metrics_counter_get("frame_pool_allocs_total", NULL)),
+		metrics_counter_value(metrics_counter_get("frame_pool_copy_bytes_total", NULL)));
+	printf("cpu           : %.2f sec, %.1f%% of one core\n",
+		cpu_us / (double)G_USEC_PER_SEC,
+		cpu_us * 100.0 / (elapsed * G_USEC_PER_SEC));
+	printf("frame to relay: p50 %.2f ms, p99 %.2f ms, max %.2f ms (%u writes)\n",
+		percentile(latency, 0.50), percentile(latency, 0.99),
+		percentile(latency, 1.0), latency->len);
+
+	for (i = 0; i < cameras; i++) {
+		guint64 detected = camera_counter("face_detect_frames_total", i);
+		guint64 latency_us = camera_counter("face_detect_latency_usec_total", i);
+
+		printf("camera %u      : %.1f fps, %.2f detections/sec, mean detect latency %.2f ms\n",
+			i, camera_counter("camera_preview_frames_total", i) / elapsed,
+			detected / elapsed, detected ? latency_us / 1000.0 / detected : 0.0);
+	}
+
+	g_array_free(latency, TRUE);
+}
+
+int main(int argc, char *argv[])
+{
+	app_data ad = {0, };
+	usb_camera *cameras[MAX_CAMERAS] = { NULL, };
+	int n_cameras = DEFAULT_CAMERAS;
+	unsigned int slots = 1;
+	GMainLoop *loop = NULL;
+	GArray *events = NULL;
+	const char *input = NULL;
+	unsigned int fps = DEFAULT_FPS;
+	unsigned int detect_ms = DEFAULT_DETECT_MS;
+	unsigned int recognize_ms = DEFAULT_RECOGNIZE_MS;
+	int duration = DEFAULT_DURATION;
+	unsigned int interval_ms = DEFAULT_INTERVAL_MS;
+	bool motion = true;
+	gint64 start = 0;
+	gint64 cpu_start = 0;
+	int opt = 0;
+	int i = 0;
+
+	while ((opt = getopt(argc, argv, "i:f:d:D:R:l:I:Fn:S:")) != -1) {
+		switch (opt) {
+		case 'i':
+			input = optarg;
+			break;
+		case 'f':
+			fps = atoi(optarg);
+			break;
+		case 'd':
+			duration = atoi(optarg);
+			break;
+		case 'D':
+			detect_ms = atoi(optarg);
+			break;
+		case 'R':
+			recognize_ms = atoi(optarg);
+			break;
+		case 'l':
+			sim_vision_set_face_luma(atoi(optarg));
+			break;
+		case 'I':
+			interval_ms = atoi(optarg);
+			break;
+		case 'F':
+			motion = false;
+			break;
+		case 'n':
+			n_cameras = atoi(optarg);
+			break;
+		case 'S':
+			slots = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-i input] [-f fps] [-d sec] "
+				"[-D detect_ms] [-R recognize_ms] [-l face_luma] "
+				"[-I interval_ms] [-F] [-n cameras] [-S slots]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (duration < 1 || sim_camera_set_input(input, fps)) {
+		fprintf(stderr, "duration and fps must be positive\n");
+		return 1;
+	}
+	if (n_cameras < 1 || n_cameras > MAX_CAMERAS || !slots) {
+		fprintf(stderr, "cameras must be 1 to %d, slots positive\n", MAX_CAMERAS);
+		return 1;
+	}
+	sim_vision_set_latency(detect_ms, recognize_ms);
+	usb_camera_set_detect_policy(motion, interval_ms);
+	face_detect_set_budget(slots);
+
+	/* trains or loads the face model, as on the first run on the device */
+	if (face_recognize())
+		fprintf(stderr, "no face model, check HS_RES_PATH and HS_DATA_PATH\n");
+	g_array_unref(sim_gpio_take_events());
+
+	loop = g_main_loop_new(NULL, FALSE);
+
+	for (i = 0; i < n_cameras; i++) {
+		cameras[i] = usb_camera_prepare(CAMERA_DEVICE_CAMERA0 + i, &ad);
+		if (!cameras[i] || usb_camera_preview(cameras[i])) {
+			fprintf(stderr, "failed to start the camera, check the input\n");
+			for (i = 0; i < n_cameras; i++)
+				usb_camera_unprepare(cameras[i]);
+			g_main_loop_unref(loop);
+			return 1;
+		}
+	}
+
+	start = g_get_monotonic_time();
+	cpu_start = cpu_time();
+
+	g_timeout_add_seconds(duration, quit_cb, loop);
+	g_main_loop_run(loop);
+
+	for (i = 0; i < n_cameras; i++)
+		usb_camera_unprepare(cameras[i]);
+	/* let the detection in flight reach the relay */
+	g_usleep((detect_ms + recognize_ms) * 2000);
+
+	events = sim_gpio_take_events();
+	report((g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC,
+		cpu_time() - cpu_start, events, n_cameras);
+	g_array_unref(events);
+
+	resource_close_relay(RELAY_PIN);
+	g_main_loop_unref(loop);
+
+	return 0;
+}
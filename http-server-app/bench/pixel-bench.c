@@ -0,0 +1,227 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The pixel kernels on 320x240, 640x480 and 1280x720 planes, once per
+ * instruction set the CPU runs: GB/s of plane read per call. A kernel
+ * without a version for an instruction set runs the narrower one there.
+ * Each result is checked against the scalar kernel, also on an odd size
+ * that leaves columns for the scalar tail.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pixel-kernels.h"
+
+#define BENCH_USEC 200000 /* per kernel and instruction set */
+
+struct planes {
+	unsigned int width;
+	unsigned int height;
+	unsigned char *a;
+	unsigned char *b;
+	unsigned char *dst; /* width / 2 x height / 2 */
+	guint64 result[2];
+	unsigned int hist[256];
+};
+
+struct kernel {
+	const char *name;
+	unsigned int reads; /* planes read per call */
+	void (*run)(struct planes *p);
+	gboolean scalar_only; /* no vector version to compare */
+};
+
+static const struct {
+	unsigned int width;
+	unsigned int height;
+} sizes[] = {
+	{ 320, 240 },
+	{ 640, 480 },
+	{ 1280, 720 },
+};
+
+static void run_sad(struct planes *p)
+{
+	p->result[0] = pixel_sad(p->a, p->width, p->b, p->width, p->width, p->height);
+}
+
+static void run_downscale_2x(struct planes *p)
+{
+	pixel_downscale_2x(p->a, p->width, p->width, p->height, p->dst, p->width / 2);
+}
+
+static void run_downscale_4x(struct planes *p)
+{
+	pixel_downscale_4x(p->a, p->width, p->width, p->height, p->dst, p->width / 4);
+}
+
+static void run_mean_variance(struct planes *p)
+{
+	double mean = 0.0;
+	double variance = 0.0;
+
+	pixel_mean_variance(p->a, p->width, p->width, p->height, &mean, &variance);
+	memcpy(&p->result[0], &mean, sizeof(mean));
+	memcpy(&p->result[1], &variance, sizeof(variance));
+}
+
+static void run_histogram(struct planes *p)
+{
+	pixel_histogram(p->a, p->width, p->width, p->height, p->hist);
+}
+
+static const struct kernel kernels[] = {
+	{ "sad", 2, run_sad, FALSE },
+	{ "downscale 2x", 1, run_downscale_2x, FALSE },
+	{ "downscale 4x", 1, run_downscale_4x, FALSE },
+	{ "mean/variance", 1, run_mean_variance, FALSE },
+	{ "histogram", 1, run_histogram, TRUE },
+};
+
+static void planes_init(struct planes *p, unsigned int width, unsigned int height)
+{
+	guint32 seed = 0x9e3779b9;
+	unsigned int i = 0;
+
+	p->width = width;
+	p->height = height;
+	p->a = g_malloc(width * height);
+	p->b = g_malloc(width * height);
+	p->dst = g_malloc(width * height / 4);
+
+	/* a gradient with noise, and a second frame close to it */
+	for (i = 0; i < width * height; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		p->a[i] = (i % width) * 160 / width + (seed & 63);
+		p->b[i] = MIN(p->a[i] + ((seed >> 8) & 15), 255);
+	}
+}
+
+static void planes_fini(struct planes *p)
+{
+	g_free(p->a);
+	g_free(p->b);
+	g_free(p->dst);
+}
+
+/* runs the kernel on clean outputs and hashes what it wrote */
+static guint64 digest(const struct kernel *k, struct planes *p)
+{
+	guint64 hash = 14695981039346656037ULL;
+	const unsigned char *bytes = NULL;
+	gsize len = 0;
+	gsize i = 0;
+
+	memset(p->result, 0, sizeof(p->result));
+	memset(p->hist, 0, sizeof(p->hist));
+	memset(p->dst, 0, p->width * p->height / 4);
+	k->run(p);
+
+#define HASH(data, size) \
+	for (bytes = (const unsigned char *)(data), len = (size), i = 0; i < len; i++) \
+		hash = (hash ^ bytes[i]) * 1099511628211ULL
+
+	HASH(p->result, sizeof(p->result));
+	HASH(p->hist, sizeof(p->hist));
+	HASH(p->dst, p->width * p->height / 4);
+#undef HASH
+
+	return hash;
+}
+
+/* every instruction set against the scalar result, 0 when they agree */
+static int check(const struct kernel *k, struct planes *p)
+{
+	guint64 expected = 0;
+	int isa = 0;
+
+	pixel_kernels_set_isa(PIXEL_ISA_SCALAR);
+	expected = digest(k, p);
+
+	for (isa = PIXEL_ISA_SCALAR + 1; isa < PIXEL_ISA_MAX; isa++) {
+		if (pixel_kernels_set_isa(isa))
+			continue;
+		if (digest(k, p) != expected) {
+			fprintf(stderr, "%s on %s differs from scalar at %ux%u\n",
+				k->name, pixel_kernels_isa_name(isa), p->width, p->height);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static double gbps(const struct kernel *k, struct planes *p)
+{
+	guint64 calls = 0;
+	gint64 start = g_get_monotonic_time();
+	gint64 elapsed = 0;
+	int i = 0;
+
+	do {
+		for (i = 0; i < 16; i++)
+			k->run(p);
+		calls += 16;
+		elapsed = g_get_monotonic_time() - start;
+	} while (elapsed < BENCH_USEC);
+
+	return (double)calls * k->reads * p->width * p->height / (elapsed * 1000.0);
+}
+
+int main(void)
+{
+	pixel_isa_e best = pixel_kernels_get_isa();
+	struct planes p;
+	unsigned int s = 0;
+	unsigned int k = 0;
+	int isa = 0;
+	int ret = 0;
+
+	printf("best isa : %s\n", pixel_kernels_isa_name(best));
+
+	planes_init(&p, 322, 246);
+	for (k = 0; k < G_N_ELEMENTS(kernels); k++)
+		ret |= check(&kernels[k], &p);
+	planes_fini(&p);
+
+	for (s = 0; s < G_N_ELEMENTS(sizes); s++) {
+		planes_init(&p, sizes[s].width, sizes[s].height);
+		printf("%ux%u\n", p.width, p.height);
+
+		for (k = 0; k < G_N_ELEMENTS(kernels); k++) {
+			ret |= check(&kernels[k], &p);
+
+			printf("  %-14s", kernels[k].name);
+			for (isa = PIXEL_ISA_SCALAR; isa < PIXEL_ISA_MAX; isa++) {
+				if (kernels[k].scalar_only && isa != PIXEL_ISA_SCALAR)
+					break;
+				if (pixel_kernels_set_isa(isa))
+					continue;
+				printf(" %s %6.2f GB/s", pixel_kernels_isa_name(isa), gbps(&kernels[k], &p));
+			}
+			printf("\n");
+		}
+		planes_fini(&p);
+	}
+
+	pixel_kernels_set_isa(best);
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Dispatch cost of the route table as the number of routes grows,
+ * compared with a linear prefix scan over registered paths.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "http-server-route-table.h"
+
+#define LOOKUP_COUNT 2000000
+
+static const int route_counts[] = { 7, 16, 64, 256, 1024, 4096 };
+
+struct linear_route {
+	char *prefix;
+	gsize len;
+	const char *method;
+};
+
+static const struct linear_route *
+linear_lookup(GArray *routes, const char *method, const char *path)
+{
+	const struct linear_route *best = NULL;
+	guint i = 0;
+
+	for (i = 0; i < routes->len; i++) {
+		const struct linear_route *r =
+			&g_array_index(routes, struct linear_route, i);
+
+		if (r->method != method)
+			continue;
+		if (strncmp(path, r->prefix, r->len))
+			continue;
+		if (path[r->len] != '\0' && path[r->len] != '/')
+			continue;
+		if (!best || r->len > best->len)
+			best = r;
+	}
+
+	return best;
+}
+
+static void bench_routes(int count)
+{
+	const char *get = g_intern_static_string("GET");
+	route_table *table = route_table_new(NULL);
+	GArray *linear = g_array_new(FALSE, FALSE, sizeof(struct linear_route));
+	GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+	route_match match;
+	gint64 start = 0;
+	gint64 trie_us = 0;
+	gint64 linear_us = 0;
+	guint hits = 0;
+	int i = 0;
+
+	route_table_insert(table, get, "/*", GINT_TO_POINTER(1));
+	for (i = 0; i < count; i++) {
+		struct linear_route r;
+		char *pattern = g_strdup_printf("/api/module%d/item/:id", i);
+
+		route_table_insert(table, get, pattern, GINT_TO_POINTER(i + 2));
+		g_free(pattern);
+
+		r.prefix = g_strdup_printf("/api/module%d/item", i);
+		r.len = strlen(r.prefix);
+		r.method = get;
+		g_array_append_val(linear, r);
+
+		g_ptr_array_add(paths, g_strdup_printf("/api/module%d/item/%d", i, i * 7));
+	}
+	g_ptr_array_add(paths, g_strdup("/css/bootstrap.min.css"));
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < LOOKUP_COUNT; i++) {
+		const char *path = g_ptr_array_index(paths, i % paths->len);
+		if (route_table_lookup(table, get, path, &match) == ROUTE_MATCH_OK)
+			hits++;
+	}
+	trie_us = g_get_monotonic_time() - start;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < LOOKUP_COUNT; i++) {
+		const char *path = g_ptr_array_index(paths, i % paths->len);
+		if (linear_lookup(linear, get, path))
+			hits++;
+	}
+	linear_us = g_get_monotonic_time() - start;
+
+	printf("%6d routes : trie %8.1f ns/lookup, linear prefix %8.1f ns/lookup (%u hits)\n",
+		count,
+		(double)trie_us * 1000.0 / LOOKUP_COUNT,
+		(double)linear_us * 1000.0 / LOOKUP_COUNT,
+		hits);
+
+	for (i = 0; i < (int)linear->len; i++)
+		g_free(g_array_index(linear, struct linear_route, i).prefix);
+	g_array_free(linear, TRUE);
+	g_ptr_array_free(paths, TRUE);
+	route_table_free(table);
+}
+
+int main(int argc, char *argv[])
+{
+	guint i = 0;
+
+	for (i = 0; i < G_N_ELEMENTS(route_counts); i++)
+		bench_routes(route_counts[i]);
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Cost of issuing and verifying session tokens */
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include "http-server-session.h"
+
+#define TOKEN_COUNT 200000
+
+int main(int argc, char *argv[])
+{
+	session_key *skey = session_key_new(NULL);
+	gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+	char *token = NULL;
+	gint64 start = 0;
+	gint64 elapsed = 0;
+	guint valid = 0;
+	int i = 0;
+
+	if (!skey)
+		return 1;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < TOKEN_COUNT; i++)
+		g_free(session_token_issue(skey, "admin", now + 3600));
+	elapsed = g_get_monotonic_time() - start;
+	printf("issue  : %.2f us/token\n", (double)elapsed / TOKEN_COUNT);
+
+	token = session_token_issue(skey, "admin", now + 3600);
+	start = g_get_monotonic_time();
+	for (i = 0; i < TOKEN_COUNT; i++)
+		valid += session_token_verify(skey, token, strlen(token), now, NULL);
+	elapsed = g_get_monotonic_time() - start;
+	printf("verify : %.2f us/token (%u valid)\n", (double)elapsed / TOKEN_COUNT, valid);
+
+	/* a tampered token must fail */
+	token[strlen(token) - 1] ^= 1;
+	if (session_token_verify(skey, token, strlen(token), now, NULL)) {
+		printf("tampered token is accepted\n");
+		return 1;
+	}
+
+	g_free(token);
+	session_key_free(skey);
+
+	return 0;
+}
@@ -0,0 +1,465 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Simulated camera : a preview thread delivers I420 frames to the preview
+ * callback at the configured fps, like the camera's own preview thread.
+ * A frame that is late is delivered at once and the schedule restarts,
+ * frames are never queued.
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <camera.h>
+#include "http-server-log-private.h"
+#include "sim.h"
+
+#define SIM_DEFAULT_FPS 15
+#define SIM_DEFAULT_WIDTH 320
+#define SIM_DEFAULT_HEIGHT 240
+#define SIM_SYNTHETIC_LUMA 128
+
+struct camera_s {
+	camera_state_e state;
+	int width;
+	int height;
+
+	camera_state_changed_cb state_cb;
+	void *state_data;
+
+	GMutex preview_lock; /* held while a frame is in the preview callback */
+	camera_preview_cb preview_cb;
+	void *preview_data;
+
+	GPtrArray *frames; /* I420 buffers of width x height */
+	GThread *thread;
+	gint running;
+
+	camera_capturing_cb capturing_cb;
+	camera_capture_completed_cb completed_cb;
+	void *capture_data;
+};
+
+static struct {
+	char *path;
+	unsigned int fps;
+} sim_input = { NULL, SIM_DEFAULT_FPS };
+
+static gint frame_count;
+static __thread gint64 current_frame_time;
+
+int sim_camera_set_input(const char *path, unsigned int fps)
+{
+	retv_if(!fps, -1);
+
+	g_free(sim_input.path);
+	sim_input.path = g_strdup(path);
+	sim_input.fps = fps;
+
+	return 0;
+}
+
+guint sim_camera_frame_count(void)
+{
+	return g_atomic_int_get(&frame_count);
+}
+
+gint64 sim_camera_current_frame_time(void)
+{
+	return current_frame_time;
+}
+
+static void camera_state_set(camera_h camera, camera_state_e state)
+{
+	camera_state_e previous = camera->state;
+
+	camera->state = state;
+	if (camera->state_cb && previous != state)
+		camera->state_cb(previous, state, false, camera->state_data);
+}
+
+/* BT.601, nearest neighbour scaling */
+static unsigned char *
+rgba_to_i420(const unsigned char *rgba, unsigned int src_w, unsigned int src_h,
+	int width, int height)
+{
+	unsigned char *frame = g_malloc(width * height * 3 / 2);
+	unsigned char *u = frame + width * height;
+	unsigned char *v = u + width * height / 4;
+	int x = 0;
+	int y = 0;
+
+	for (y = 0; y < height; y++) {
+		const unsigned char *row = rgba + (gsize)(y * src_h / height) * src_w * 4;
+
+		for (x = 0; x < width; x++) {
+			const unsigned char *p = row + (gsize)(x * src_w / width) * 4;
+			int r = p[0];
+			int g = p[1];
+			int b = p[2];
+
+			frame[y * width + x] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+			if (!(x & 1) && !(y & 1)) {
+				int i = (y / 2) * (width / 2) + x / 2;
+
+				u[i] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+				v[i] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+			}
+		}
+	}
+
+	return frame;
+}
+
+static void frames_add_png(GPtrArray *frames, const char *path, int width, int height)
+{
+	unsigned char *rgba = NULL;
+	unsigned int w = 0;
+	unsigned int h = 0;
+
+	rgba = sim_png_load(path, &w, &h);
+	retm_if(!rgba, "failed to load [%s]", path);
+
+	g_ptr_array_add(frames, rgba_to_i420(rgba, w, h, width, height));
+	free(rgba);
+}
+
+static void frames_add_i420(GPtrArray *frames, const char *path, int width, int height)
+{
+	gsize frame_size = width * height * 3 / 2;
+	gchar *contents = NULL;
+	gsize length = 0;
+	gsize offset = 0;
+
+	retm_if(!g_file_get_contents(path, &contents, &length, NULL),
+		"failed to read [%s]", path);
+
+	for (offset = 0; offset + frame_size <= length; offset += frame_size) {
+		unsigned char *frame = g_malloc(frame_size);
+
+		memcpy(frame, contents + offset, frame_size);
+		g_ptr_array_add(frames, frame);
+	}
+
+	if (!offset)
+		_E("[%s] is smaller than a %dx%d I420 frame", path, width, height);
+	g_free(contents);
+}
+
+static gint path_cmp(gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0(*(char * const *)a, *(char * const *)b);
+}
+
+static GPtrArray *frames_load(int width, int height)
+{
+	GPtrArray *frames = g_ptr_array_new_with_free_func(g_free);
+	const char *path = sim_input.path;
+
+	if (!path) {
+		unsigned char *frame = g_malloc(width * height * 3 / 2);
+
+		memset(frame, SIM_SYNTHETIC_LUMA, width * height);
+		memset(frame + width * height, 128, width * height / 2);
+		g_ptr_array_add(frames, frame);
+	} else if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+		GDir *dir = g_dir_open(path, 0, NULL);
+		GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+		const char *name = NULL;
+		guint i = 0;
+
+		while (dir && (name = g_dir_read_name(dir))) {
+			if (g_str_has_suffix(name, ".png"))
+				g_ptr_array_add(names, g_build_filename(path, name, NULL));
+		}
+		if (dir)
+			g_dir_close(dir);
+
+		g_ptr_array_sort(names, path_cmp);
+		for (i = 0; i < names->len; i++)
+			frames_add_png(frames, g_ptr_array_index(names, i), width, height);
+		g_ptr_array_free(names, TRUE);
+	} else if (g_str_has_suffix(path, ".png")) {
+		frames_add_png(frames, path, width, height);
+	} else {
+		frames_add_i420(frames, path, width, height);
+	}
+
+	if (!frames->len) {
+		g_ptr_array_free(frames, TRUE);
+		return NULL;
+	}
+
+	return frames;
+}
+
+static gpointer preview_thread(gpointer data)
+{
+	camera_h camera = data;
+	camera_preview_data_s frame;
+	gint64 interval = G_USEC_PER_SEC / sim_input.fps;
+	gint64 next = g_get_monotonic_time();
+	gint64 now = 0;
+	guint i = 0;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.format = CAMERA_PIXEL_FORMAT_I420;
+	frame.width = camera->width;
+	frame.height = camera->height;
+	frame.num_of_planes = 3;
+	frame.data.triple_plane.y_size = camera->width * camera->height;
+	frame.data.triple_plane.u_size = frame.data.triple_plane.y_size / 4;
+	frame.data.triple_plane.v_size = frame.data.triple_plane.y_size / 4;
+
+	for (i = 0; g_atomic_int_get(&camera->running); i++) {
+		unsigned char *y = g_ptr_array_index(camera->frames, i % camera->frames->len);
+
+		frame.data.triple_plane.y = y;
+		frame.data.triple_plane.u = y + frame.data.triple_plane.y_size;
+		frame.data.triple_plane.v = frame.data.triple_plane.u + frame.data.triple_plane.u_size;
+
+		now = g_get_monotonic_time();
+		frame.timestamp = now / 1000;
+
+		g_mutex_lock(&camera->preview_lock);
+		if (camera->preview_cb) {
+			current_frame_time = now;
+			camera->preview_cb(&frame, camera->preview_data);
+			current_frame_time = 0;
+		}
+		g_mutex_unlock(&camera->preview_lock);
+		g_atomic_int_inc(&frame_count);
+
+		next += interval;
+		now = g_get_monotonic_time();
+		if (next > now)
+			g_usleep(next - now);
+		else
+			next = now;
+	}
+
+	return NULL;
+}
+
+static void preview_thread_stop(camera_h camera)
+{
+	if (!camera->thread)
+		return;
+
+	g_atomic_int_set(&camera->running, 0);
+	g_thread_join(camera->thread);
+	camera->thread = NULL;
+}
+
+int camera_create(camera_device_e device, camera_h *camera)
+{
+	if (!camera)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	*camera = g_new0(struct camera_s, 1);
+	(*camera)->state = CAMERA_STATE_CREATED;
+	(*camera)->width = SIM_DEFAULT_WIDTH;
+	(*camera)->height = SIM_DEFAULT_HEIGHT;
+	g_mutex_init(&(*camera)->preview_lock);
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_destroy(camera_h camera)
+{
+	if (!camera)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	preview_thread_stop(camera);
+	if (camera->frames)
+		g_ptr_array_free(camera->frames, TRUE);
+	g_mutex_clear(&camera->preview_lock);
+	g_free(camera);
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_get_state(camera_h camera, camera_state_e *state)
+{
+	if (!camera || !state)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	*state = camera->state;
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_attr_set_image_quality(camera_h camera, int quality)
+{
+	if (!camera || quality < 1 || quality > 100)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_set_preview_resolution(camera_h camera, int width, int height)
+{
+	if (!camera || width <= 0 || height <= 0 || (width & 1) || (height & 1))
+		return CAMERA_ERROR_INVALID_PARAMETER;
+	if (camera->state != CAMERA_STATE_CREATED)
+		return CAMERA_ERROR_INVALID_STATE;
+
+	camera->width = width;
+	camera->height = height;
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_get_preview_resolution(camera_h camera, int *width, int *height)
+{
+	if (!camera || !width || !height)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	*width = camera->width;
+	*height = camera->height;
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_set_capture_resolution(camera_h camera, int width, int height)
+{
+	if (!camera || width <= 0 || height <= 0)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_set_capture_format(camera_h camera, camera_pixel_format_e format)
+{
+	if (!camera)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_set_state_changed_cb(camera_h camera, camera_state_changed_cb callback, void *user_data)
+{
+	if (!camera || !callback)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	camera->state_cb = callback;
+	camera->state_data = user_data;
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_set_preview_cb(camera_h camera, camera_preview_cb callback, void *user_data)
+{
+	if (!camera || !callback)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	g_mutex_lock(&camera->preview_lock);
+	camera->preview_cb = callback;
+	camera->preview_data = user_data;
+	g_mutex_unlock(&camera->preview_lock);
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_unset_preview_cb(camera_h camera)
+{
+	if (!camera)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+
+	g_mutex_lock(&camera->preview_lock);
+	camera->preview_cb = NULL;
+	camera->preview_data = NULL;
+	g_mutex_unlock(&camera->preview_lock);
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_start_preview(camera_h camera)
+{
+	if (!camera)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+	if (camera->state == CAMERA_STATE_PREVIEW || camera->state == CAMERA_STATE_CAPTURING)
+		return CAMERA_ERROR_INVALID_STATE;
+
+	if (!camera->frames) {
+		camera->frames = frames_load(camera->width, camera->height);
+		if (!camera->frames)
+			return CAMERA_ERROR_DEVICE;
+	}
+
+	g_atomic_int_set(&camera->running, 1);
+	camera->thread = g_thread_new("sim-camera", preview_thread, camera);
+	camera_state_set(camera, CAMERA_STATE_PREVIEW);
+
+	return CAMERA_ERROR_NONE;
+}
+
+int camera_stop_preview(camera_h camera)
+{
+	if (!camera)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+	if (camera->state != CAMERA_STATE_PREVIEW)
+		return CAMERA_ERROR_INVALID_STATE;
+
+	preview_thread_stop(camera);
+	camera_state_set(camera, CAMERA_STATE_CREATED);
+
+	return CAMERA_ERROR_NONE;
+}
+
+static gboolean capture_idle_cb(gpointer data)
+{
+	camera_h camera = data;
+	camera_image_data_s image;
+
+	memset(&image, 0, sizeof(image));
+	image.data = g_ptr_array_index(camera->frames, 0);
+	image.size = camera->width * camera->height * 3 / 2;
+	image.width = camera->width;
+	image.height = camera->height;
+	image.format = CAMERA_PIXEL_FORMAT_I420;
+
+	if (camera->capturing_cb)
+		camera->capturing_cb(&image, NULL, NULL, camera->capture_data);
+
+	camera_state_set(camera, CAMERA_STATE_CAPTURED);
+
+	if (camera->completed_cb)
+		camera->completed_cb(camera->capture_data);
+
+	return G_SOURCE_REMOVE;
+}
+
+int camera_start_capture(camera_h camera, camera_capturing_cb capturing_cb,
+			camera_capture_completed_cb completed_cb, void *user_data)
+{
+	if (!camera)
+		return CAMERA_ERROR_INVALID_PARAMETER;
+	if (camera->state != CAMERA_STATE_PREVIEW)
+		return CAMERA_ERROR_INVALID_STATE;
+
+	/* the preview pauses while capturing, as on the device */
+	preview_thread_stop(camera);
+	camera_state_set(camera, CAMERA_STATE_CAPTURING);
+
+	camera->capturing_cb = capturing_cb;
+	camera->completed_cb = completed_cb;
+	camera->capture_data = user_data;
+	g_idle_add(capture_idle_cb, camera);
+
+	return CAMERA_ERROR_NONE;
+}
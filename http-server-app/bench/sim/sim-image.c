@@ -0,0 +1,167 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Simulated image util : PNG decoding to RGBA with libpng */
+
+#include <glib.h>
+#include <png.h>
+#include <stdlib.h>
+#include <string.h>
+#include <image_util.h>
+#include "http-server-log-private.h"
+#include "sim.h"
+
+struct image_util_decode_s {
+	char *path;
+	unsigned char **output;
+	image_util_colorspace_e colorspace;
+};
+
+/* RGBA, free() the result */
+unsigned char *sim_png_load(const char *path, unsigned int *width, unsigned int *height)
+{
+	png_image image;
+	unsigned char *buffer = NULL;
+
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_file(&image, path)) {
+		_E("failed to read [%s] - %s", path, image.message);
+		return NULL;
+	}
+
+	image.format = PNG_FORMAT_RGBA;
+	buffer = malloc(PNG_IMAGE_SIZE(image));
+	if (!buffer) {
+		png_image_free(&image);
+		return NULL;
+	}
+
+	if (!png_image_finish_read(&image, NULL, buffer, 0, NULL)) {
+		_E("failed to decode [%s] - %s", path, image.message);
+		free(buffer);
+		return NULL;
+	}
+
+	*width = image.width;
+	*height = image.height;
+
+	return buffer;
+}
+
+static bool supported_colorspaces[] = {
+	[IMAGE_UTIL_COLORSPACE_RGBA8888] = true,
+};
+
+int image_util_foreach_supported_colorspace(image_util_type_e image_type,
+			image_util_supported_colorspace_cb callback, void *user_data)
+{
+	guint i = 0;
+
+	if (!callback)
+		return IMAGE_UTIL_ERROR_INVALID_PARAMETER;
+
+	for (i = 0; i < G_N_ELEMENTS(supported_colorspaces); i++) {
+		if (supported_colorspaces[i] && !callback(i, user_data))
+			break;
+	}
+
+	return IMAGE_UTIL_ERROR_NONE;
+}
+
+int image_util_decode_create(image_util_decode_h *handle)
+{
+	if (!handle)
+		return IMAGE_UTIL_ERROR_INVALID_PARAMETER;
+
+	*handle = g_new0(struct image_util_decode_s, 1);
+	(*handle)->colorspace = IMAGE_UTIL_COLORSPACE_RGBA8888;
+
+	return IMAGE_UTIL_ERROR_NONE;
+}
+
+int image_util_decode_destroy(image_util_decode_h handle)
+{
+	if (!handle)
+		return IMAGE_UTIL_ERROR_INVALID_PARAMETER;
+
+	g_free(handle->path);
+	g_free(handle);
+
+	return IMAGE_UTIL_ERROR_NONE;
+}
+
+int image_util_decode_set_input_path(image_util_decode_h handle, const char *path)
+{
+	if (!handle || !path)
+		return IMAGE_UTIL_ERROR_INVALID_PARAMETER;
+	if (!g_file_test(path, G_FILE_TEST_EXISTS))
+		return IMAGE_UTIL_ERROR_NO_SUCH_FILE;
+
+	g_free(handle->path);
+	handle->path = g_strdup(path);
+
+	return IMAGE_UTIL_ERROR_NONE;
+}
+
+int image_util_decode_set_output_buffer(image_util_decode_h handle, unsigned char **dst_buffer)
+{
+	if (!handle || !dst_buffer)
+		return IMAGE_UTIL_ERROR_INVALID_PARAMETER;
+
+	handle->output = dst_buffer;
+
+	return IMAGE_UTIL_ERROR_NONE;
+}
+
+int image_util_decode_set_colorspace(image_util_decode_h handle, image_util_colorspace_e colorspace)
+{
+	if (!handle)
+		return IMAGE_UTIL_ERROR_INVALID_PARAMETER;
+	if (colorspace != IMAGE_UTIL_COLORSPACE_RGBA8888)
+		return IMAGE_UTIL_ERROR_NOT_SUPPORTED_FORMAT;
+
+	handle->colorspace = colorspace;
+
+	return IMAGE_UTIL_ERROR_NONE;
+}
+
+int image_util_decode_run(image_util_decode_h handle, unsigned long *width,
+			unsigned long *height, unsigned long long *size)
+{
+	unsigned int w = 0;
+	unsigned int h = 0;
+
+	if (!handle || !handle->path || !handle->output)
+		return IMAGE_UTIL_ERROR_INVALID_PARAMETER;
+
+	if (!g_str_has_suffix(handle->path, ".png"))
+		return IMAGE_UTIL_ERROR_NOT_SUPPORTED_FORMAT;
+
+	*handle->output = sim_png_load(handle->path, &w, &h);
+	if (!*handle->output)
+		return IMAGE_UTIL_ERROR_INVALID_OPERATION;
+
+	if (width)
+		*width = w;
+	if (height)
+		*height = h;
+	if (size)
+		*size = (unsigned long long)w * h * 4;
+
+	return IMAGE_UTIL_ERROR_NONE;
+}
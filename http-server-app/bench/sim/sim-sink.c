@@ -0,0 +1,163 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Recording sinks for the pipeline outputs : the relay GPIO, ThingsPark
+ * and the dashboard face result stream.
+ * Each GPIO write keeps the time from the camera frame that caused it.
+ */
+
+#include <glib.h>
+#include <peripheral_io.h>
+#include "http-server-log-private.h"
+#include "thingspark_api.h"
+#include "hs-route-api-face-detect.h"
+#include "sim.h"
+
+struct _peripheral_gpio_s {
+	int pin;
+	peripheral_gpio_direction_e direction;
+};
+
+struct tp_handle_s {
+	int fields;
+};
+
+static GMutex events_lock;
+static GArray *events;
+static gint tp_sends;
+static gint face_notifies;
+
+GArray *sim_gpio_take_events(void)
+{
+	GArray *taken = NULL;
+
+	g_mutex_lock(&events_lock);
+	taken = events;
+	events = NULL;
+	g_mutex_unlock(&events_lock);
+
+	if (!taken)
+		taken = g_array_new(FALSE, FALSE, sizeof(sim_gpio_event));
+
+	return taken;
+}
+
+guint sim_tp_send_count(void)
+{
+	return g_atomic_int_get(&tp_sends);
+}
+
+int peripheral_gpio_open(int gpio_pin, peripheral_gpio_h *gpio)
+{
+	if (gpio_pin < 0 || !gpio)
+		return PERIPHERAL_ERROR_INVALID_PARAMETER;
+
+	*gpio = g_new0(struct _peripheral_gpio_s, 1);
+	(*gpio)->pin = gpio_pin;
+	(*gpio)->direction = PERIPHERAL_GPIO_DIRECTION_IN;
+
+	return PERIPHERAL_ERROR_NONE;
+}
+
+int peripheral_gpio_close(peripheral_gpio_h gpio)
+{
+	if (!gpio)
+		return PERIPHERAL_ERROR_INVALID_PARAMETER;
+
+	g_free(gpio);
+
+	return PERIPHERAL_ERROR_NONE;
+}
+
+int peripheral_gpio_set_direction(peripheral_gpio_h gpio, peripheral_gpio_direction_e direction)
+{
+	if (!gpio)
+		return PERIPHERAL_ERROR_INVALID_PARAMETER;
+
+	gpio->direction = direction;
+
+	return PERIPHERAL_ERROR_NONE;
+}
+
+int peripheral_gpio_write(peripheral_gpio_h gpio, unsigned int value)
+{
+	sim_gpio_event event;
+	gint64 frame_time = sim_vision_frame_time();
+
+	if (!gpio || value > 1)
+		return PERIPHERAL_ERROR_INVALID_PARAMETER;
+	if (gpio->direction == PERIPHERAL_GPIO_DIRECTION_IN)
+		return PERIPHERAL_ERROR_IO_ERROR;
+
+	event.pin = gpio->pin;
+	event.value = value;
+	event.time = g_get_monotonic_time();
+	event.latency = frame_time ? event.time - frame_time : -1;
+
+	g_mutex_lock(&events_lock);
+	if (!events)
+		events = g_array_new(FALSE, FALSE, sizeof(sim_gpio_event));
+	g_array_append_val(events, event);
+	g_mutex_unlock(&events_lock);
+
+	return PERIPHERAL_ERROR_NONE;
+}
+
+int tp_initialize(const char *api_key, tp_handle_h *handle)
+{
+	retv_if(!api_key || !handle, -1);
+
+	*handle = g_new0(struct tp_handle_s, 1);
+
+	return 0;
+}
+
+int tp_set_field_value(tp_handle_h handle, int field, const char *value)
+{
+	retv_if(!handle || !value, -1);
+
+	handle->fields++;
+
+	return 0;
+}
+
+int tp_send_data(tp_handle_h handle)
+{
+	retv_if(!handle || !handle->fields, -1);
+
+	g_atomic_int_inc(&tp_sends);
+
+	return 0;
+}
+
+int tp_finalize(tp_handle_h handle)
+{
+	g_free(handle);
+
+	return 0;
+}
+
+guint sim_face_notify_count(void)
+{
+	return g_atomic_int_get(&face_notifies);
+}
+
+/* no server in the simulation, only count what would be streamed */
+void hs_route_api_face_detect_notify(void *data)
+{
+	g_atomic_int_inc(&face_notifies);
+}
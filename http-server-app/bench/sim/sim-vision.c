@@ -0,0 +1,430 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Simulated Media Vision : sources are plain buffers, detection and
+ * recognition are deterministic functions of the luma with a fixed latency,
+ * so runs over the same frames are repeatable.
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mv_common.h>
+#include <mv_face.h>
+#include "http-server-log-private.h"
+#include "sim.h"
+
+#define SIM_DEFAULT_DETECT_MS 40
+#define SIM_DEFAULT_RECOGNIZE_MS 15
+#define SIM_DEFAULT_FACE_LUMA 100
+#define SIM_RECOGNIZE_CONFIDENCE 0.97
+#define SIM_MODEL_GROUP "sim-face-model"
+
+struct mv_source_s {
+	unsigned char *buffer;
+	unsigned int size;
+	unsigned int width;
+	unsigned int height;
+	mv_colorspace_e colorspace;
+	gint64 frame_time;
+};
+
+struct mv_engine_config_s {
+	char *detection_model;
+};
+
+struct mv_face_recognition_model_s {
+	GArray *labels; /* int */
+};
+
+static struct {
+	unsigned int detect_ms;
+	unsigned int recognize_ms;
+	unsigned int face_luma;
+} sim_conf = { SIM_DEFAULT_DETECT_MS, SIM_DEFAULT_RECOGNIZE_MS, SIM_DEFAULT_FACE_LUMA };
+
+static GMutex stats_lock;
+static guint detections;
+static guint faces;
+static guint recognitions;
+static __thread gint64 detect_frame_time; /* each detection worker has its own */
+
+void sim_vision_set_latency(unsigned int detect_ms, unsigned int recognize_ms)
+{
+	sim_conf.detect_ms = detect_ms;
+	sim_conf.recognize_ms = recognize_ms;
+}
+
+void sim_vision_set_face_luma(unsigned int face_luma)
+{
+	sim_conf.face_luma = face_luma;
+}
+
+void sim_vision_get_counts(guint *detect_count, guint *face_count, guint *recognize_count)
+{
+	g_mutex_lock(&stats_lock);
+	if (detect_count)
+		*detect_count = detections;
+	if (face_count)
+		*face_count = faces;
+	if (recognize_count)
+		*recognize_count = recognitions;
+	g_mutex_unlock(&stats_lock);
+}
+
+gint64 sim_vision_frame_time(void)
+{
+	return detect_frame_time;
+}
+
+int mv_create_source(mv_source_h *source)
+{
+	if (!source)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	*source = g_new0(struct mv_source_s, 1);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_destroy_source(mv_source_h source)
+{
+	if (!source)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	g_free(source->buffer);
+	g_free(source);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_source_clear(mv_source_h source)
+{
+	if (!source)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	/* Media Vision frees the buffer, the next fill allocates a new one */
+	g_free(source->buffer);
+	source->buffer = NULL;
+	source->size = 0;
+	source->width = 0;
+	source->height = 0;
+	source->colorspace = MEDIA_VISION_COLORSPACE_INVALID;
+	source->frame_time = 0;
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_source_fill_by_buffer(mv_source_h source, unsigned char *data_buffer,
+			unsigned int buffer_size, unsigned int image_width,
+			unsigned int image_height, mv_colorspace_e image_colorspace)
+{
+	if (!source || !data_buffer || !buffer_size || !image_width || !image_height)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+	if (buffer_size < image_width * image_height)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	/* a fill without a clear replaces the buffer too */
+	g_free(source->buffer);
+	source->buffer = g_malloc(buffer_size);
+	memcpy(source->buffer, data_buffer, buffer_size);
+
+	source->size = buffer_size;
+	source->width = image_width;
+	source->height = image_height;
+	source->colorspace = image_colorspace;
+	source->frame_time = sim_camera_current_frame_time();
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_source_get_buffer(mv_source_h source, unsigned char **data_buffer, unsigned int *buffer_size)
+{
+	if (!source || !data_buffer || !buffer_size)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+	if (!source->size)
+		return MEDIA_VISION_ERROR_NO_DATA;
+
+	*data_buffer = source->buffer;
+	*buffer_size = source->size;
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_source_get_width(mv_source_h source, unsigned int *image_width)
+{
+	if (!source || !image_width)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	*image_width = source->width;
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_source_get_height(mv_source_h source, unsigned int *image_height)
+{
+	if (!source || !image_height)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	*image_height = source->height;
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_source_get_colorspace(mv_source_h source, mv_colorspace_e *image_colorspace)
+{
+	if (!source || !image_colorspace)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	*image_colorspace = source->colorspace;
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_create_engine_config(mv_engine_config_h *engine_cfg)
+{
+	if (!engine_cfg)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	*engine_cfg = g_new0(struct mv_engine_config_s, 1);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_destroy_engine_config(mv_engine_config_h engine_cfg)
+{
+	if (!engine_cfg)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	g_free(engine_cfg->detection_model);
+	g_free(engine_cfg);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_engine_config_set_string_attribute(mv_engine_config_h engine_cfg,
+			const char *name, const char *value)
+{
+	if (!engine_cfg || !name || !value)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	/* the model itself is never read on the host */
+	if (!strcmp(name, MV_FACE_DETECTION_MODEL_FILE_PATH)) {
+		g_free(engine_cfg->detection_model);
+		engine_cfg->detection_model = g_strdup(value);
+	}
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+/* mean luma of the centre quarter of the image */
+static unsigned int centre_luma(mv_source_h source)
+{
+	unsigned int x0 = source->width / 4;
+	unsigned int y0 = source->height / 4;
+	unsigned int w = source->width / 2;
+	unsigned int h = source->height / 2;
+	unsigned int bpp = 1;
+	unsigned int x = 0;
+	unsigned int y = 0;
+	guint64 sum = 0;
+
+	/* packed RGB, green is close enough to luma here */
+	if (source->colorspace == MEDIA_VISION_COLORSPACE_RGBA)
+		bpp = 4;
+	else if (source->colorspace == MEDIA_VISION_COLORSPACE_RGB888)
+		bpp = 3;
+
+	if (!w || !h || source->size < source->width * source->height * bpp)
+		return 0;
+
+	for (y = y0; y < y0 + h; y++) {
+		const unsigned char *row = source->buffer + (y * source->width + x0) * bpp;
+
+		for (x = 0; x < w; x++)
+			sum += row[x * bpp + (bpp > 1)];
+	}
+
+	return sum / (w * h);
+}
+
+int mv_face_detect(mv_source_h source, mv_engine_config_h engine_cfg,
+			mv_face_detected_cb detected_cb, void *user_data)
+{
+	mv_rectangle_s location;
+	int number_of_faces = 0;
+
+	if (!source || !detected_cb)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+	if (!source->size)
+		return MEDIA_VISION_ERROR_NO_DATA;
+
+	g_usleep(sim_conf.detect_ms * 1000);
+
+	if (centre_luma(source) >= sim_conf.face_luma) {
+		location.point.x = source->width / 4;
+		location.point.y = source->height / 4;
+		location.width = source->width / 2;
+		location.height = source->height / 2;
+		number_of_faces = 1;
+	}
+
+	g_mutex_lock(&stats_lock);
+	detections++;
+	faces += number_of_faces;
+	g_mutex_unlock(&stats_lock);
+
+	detect_frame_time = source->frame_time;
+
+	detected_cb(source, engine_cfg, number_of_faces ? &location : NULL,
+		number_of_faces, user_data);
+
+	detect_frame_time = 0;
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_face_recognize(mv_source_h source, mv_face_recognition_model_h recognition_model,
+			mv_engine_config_h engine_cfg, mv_rectangle_s *face_location,
+			mv_face_recognized_cb recognized_cb, void *user_data)
+{
+	mv_rectangle_s location;
+	const int *label = NULL;
+
+	if (!source || !recognition_model || !recognized_cb)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+	if (!source->size)
+		return MEDIA_VISION_ERROR_NO_DATA;
+
+	g_usleep(sim_conf.recognize_ms * 1000);
+
+	if (face_location) {
+		location = *face_location;
+	} else {
+		location.point.x = 0;
+		location.point.y = 0;
+		location.width = source->width;
+		location.height = source->height;
+	}
+
+	/* every face is the first person learned */
+	if (recognition_model->labels->len)
+		label = &g_array_index(recognition_model->labels, int, 0);
+
+	g_mutex_lock(&stats_lock);
+	recognitions++;
+	g_mutex_unlock(&stats_lock);
+
+	recognized_cb(source, recognition_model, engine_cfg, &location, label,
+		label ? SIM_RECOGNIZE_CONFIDENCE : 0.0, user_data);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_face_recognition_model_create(mv_face_recognition_model_h *recognition_model)
+{
+	if (!recognition_model)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	*recognition_model = g_new0(struct mv_face_recognition_model_s, 1);
+	(*recognition_model)->labels = g_array_new(FALSE, FALSE, sizeof(int));
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_face_recognition_model_destroy(mv_face_recognition_model_h recognition_model)
+{
+	if (!recognition_model)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	g_array_free(recognition_model->labels, TRUE);
+	g_free(recognition_model);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_face_recognition_model_add(const mv_source_h source,
+			mv_face_recognition_model_h recognition_model,
+			const mv_rectangle_s *example_location, int face_label)
+{
+	guint i = 0;
+
+	if (!source || !recognition_model)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	for (i = 0; i < recognition_model->labels->len; i++) {
+		if (g_array_index(recognition_model->labels, int, i) == face_label)
+			return MEDIA_VISION_ERROR_NONE;
+	}
+	g_array_append_val(recognition_model->labels, face_label);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_face_recognition_model_learn(mv_engine_config_h engine_cfg,
+			mv_face_recognition_model_h recognition_model)
+{
+	if (!recognition_model)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+	if (!recognition_model->labels->len)
+		return MEDIA_VISION_ERROR_NO_DATA;
+
+	return MEDIA_VISION_ERROR_NONE;
+}
+
+int mv_face_recognition_model_save(const char *recognition_model_path,
+			mv_face_recognition_model_h recognition_model)
+{
+	GKeyFile *key_file = NULL;
+	gboolean saved = FALSE;
+
+	if (!recognition_model_path || !recognition_model)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	key_file = g_key_file_new();
+	g_key_file_set_integer_list(key_file, SIM_MODEL_GROUP, "labels",
+		(gint *)recognition_model->labels->data, recognition_model->labels->len);
+	saved = g_key_file_save_to_file(key_file, recognition_model_path, NULL);
+	g_key_file_unref(key_file);
+
+	return saved ? MEDIA_VISION_ERROR_NONE : MEDIA_VISION_ERROR_INVALID_PATH;
+}
+
+int mv_face_recognition_model_load(const char *recognition_model_path,
+			mv_face_recognition_model_h *recognition_model)
+{
+	GKeyFile *key_file = NULL;
+	gint *labels = NULL;
+	gsize length = 0;
+
+	if (!recognition_model_path || !recognition_model)
+		return MEDIA_VISION_ERROR_INVALID_PARAMETER;
+
+	key_file = g_key_file_new();
+	if (g_key_file_load_from_file(key_file, recognition_model_path, G_KEY_FILE_NONE, NULL))
+		labels = g_key_file_get_integer_list(key_file, SIM_MODEL_GROUP, "labels", &length, NULL);
+	g_key_file_unref(key_file);
+
+	if (!labels)
+		return MEDIA_VISION_ERROR_INVALID_PATH;
+
+	mv_face_recognition_model_create(recognition_model);
+	g_array_append_vals((*recognition_model)->labels, labels, length);
+	g_free(labels);
+
+	return MEDIA_VISION_ERROR_NONE;
+}
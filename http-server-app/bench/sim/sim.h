@@ -0,0 +1,63 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Simulation runtime behind the camera, Media Vision and peripheral I/O
+ * stand-ins in bench/stub/, so usb-camera.c, face-detect.c,
+ * face-recognize.c and resource_relay.c run unchanged on a Linux host.
+ */
+
+#ifndef __BENCH_SIM_H__
+#define __BENCH_SIM_H__
+
+#include <glib.h>
+
+/*
+ * Preview frames are read once when the preview starts and looped at fps.
+ * path is a raw I420 file (frames of the preview resolution back to back),
+ * a PNG file or a directory of PNG files, which are scaled to the preview
+ * resolution. NULL gives a synthetic frame, bright enough to hold a face.
+ */
+int sim_camera_set_input(const char *path, unsigned int fps);
+guint sim_camera_frame_count(void);
+
+/*
+ * A face is found when the mean luma of the centre of the image reaches
+ * face_luma, the detector and recognizer then sleep for their latency.
+ */
+void sim_vision_set_latency(unsigned int detect_ms, unsigned int recognize_ms);
+void sim_vision_set_face_luma(unsigned int face_luma);
+void sim_vision_get_counts(guint *detections, guint *faces, guint *recognitions);
+/* usec of the frame in the detection in flight on the calling thread, 0 if none */
+gint64 sim_vision_frame_time(void);
+
+typedef struct {
+	int pin;
+	unsigned int value;
+	gint64 time; /* monotonic usec */
+	gint64 latency; /* usec from the camera frame to this write, -1 if unknown */
+} sim_gpio_event;
+
+/* recorded writes since the last call, free with g_array_unref() */
+GArray *sim_gpio_take_events(void);
+guint sim_tp_send_count(void);
+guint sim_face_notify_count(void);
+
+/* shared inside the runtime */
+gint64 sim_camera_current_frame_time(void);
+unsigned char *sim_png_load(const char *path, unsigned int *width, unsigned int *height);
+
+#endif /* __BENCH_SIM_H__ */
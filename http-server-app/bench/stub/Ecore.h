@@ -0,0 +1,26 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in, only the timer handle held in app_data is needed */
+
+#ifndef __BENCH_STUB_ECORE_H__
+#define __BENCH_STUB_ECORE_H__
+
+typedef struct _Ecore_Timer Ecore_Timer;
+
+void *ecore_timer_del(Ecore_Timer *timer);
+
+#endif /* __BENCH_STUB_ECORE_H__ */
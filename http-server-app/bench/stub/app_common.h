@@ -0,0 +1,28 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host stand-in, the resource path comes from $HS_RES_PATH (default "../res/")
+ * and the data path from $HS_DATA_PATH (default "/tmp/").
+ */
+
+#ifndef __BENCH_STUB_APP_COMMON_H__
+#define __BENCH_STUB_APP_COMMON_H__
+
+char *app_get_resource_path(void);
+char *app_get_data_path(void);
+
+#endif /* __BENCH_STUB_APP_COMMON_H__ */
@@ -0,0 +1,104 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen app manager, a fixed list of fake applications */
+
+#ifndef __BENCH_STUB_APP_MANAGER_H__
+#define __BENCH_STUB_APP_MANAGER_H__
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+typedef struct app_info_s *app_info_h;
+typedef struct app_context_s *app_context_h;
+typedef struct app_manager_event_s *app_manager_event_h;
+
+typedef enum {
+	APP_MANAGER_ERROR_NONE = 0,
+	APP_MANAGER_ERROR_INVALID_PARAMETER = -22,
+	APP_MANAGER_ERROR_OUT_OF_MEMORY = -12,
+	APP_MANAGER_ERROR_IO_ERROR = -5,
+	APP_MANAGER_ERROR_NO_SUCH_APP = -0x01110000 | 0x01,
+} app_manager_error_e;
+
+typedef enum {
+	APP_STATE_UNDEFINED,
+	APP_STATE_FOREGROUND,
+	APP_STATE_BACKGROUND,
+	APP_STATE_SERVICE,
+	APP_STATE_TERMINATED,
+} app_state_e;
+
+typedef enum {
+	APP_CONTEXT_STATUS_LAUNCHED,
+	APP_CONTEXT_STATUS_TERMINATED,
+} app_context_status_e;
+
+typedef enum {
+	APP_MANAGER_EVENT_STATUS_TYPE_ALL = 0x00,
+	APP_MANAGER_EVENT_STATUS_TYPE_ENABLE = 0x01,
+	APP_MANAGER_EVENT_STATUS_TYPE_DISABLE = 0x02,
+} app_manager_event_status_type_e;
+
+typedef enum {
+	APP_MANAGER_EVENT_ENABLE_APP = 0,
+	APP_MANAGER_EVENT_DISABLE_APP,
+	APP_MANAGER_EVENT_INSTALL,
+	APP_MANAGER_EVENT_UNINSTALL,
+	APP_MANAGER_EVENT_UPDATE,
+} app_manager_event_type_e;
+
+typedef enum {
+	APP_MANAGER_EVENT_STATE_STARTED = 0,
+	APP_MANAGER_EVENT_STATE_PROCESSING,
+	APP_MANAGER_EVENT_STATE_COMPLETED,
+	APP_MANAGER_EVENT_STATE_FAILED,
+} app_manager_event_state_e;
+
+typedef bool (*app_manager_app_info_cb)(app_info_h app_info, void *user_data);
+typedef bool (*app_manager_app_context_cb)(app_context_h app_context, void *user_data);
+typedef void (*app_manager_app_context_status_cb)(app_context_h app_context,
+				app_context_status_e status, void *user_data);
+typedef void (*app_manager_event_cb)(const char *type, const char *app_id,
+				app_manager_event_type_e event_type,
+				app_manager_event_state_e event_state,
+				app_manager_event_h handle, void *user_data);
+
+int app_manager_foreach_app_info(app_manager_app_info_cb callback, void *user_data);
+int app_manager_get_app_context(const char *app_id, app_context_h *app_context);
+int app_manager_foreach_app_context(app_manager_app_context_cb callback, void *user_data);
+
+/* never called back on the host, the fake applications do not change */
+int app_manager_set_app_context_status_cb(app_manager_app_context_status_cb callback,
+				const char *appid, void *user_data);
+int app_manager_unset_app_context_status_cb(app_manager_app_context_status_cb callback,
+				const char *appid);
+
+int app_manager_event_create(app_manager_event_h *handle);
+int app_manager_event_set_status(app_manager_event_h handle, int status_type);
+int app_manager_set_event_cb(app_manager_event_h handle,
+				app_manager_event_cb callback, void *user_data);
+int app_manager_unset_event_cb(app_manager_event_h handle);
+int app_manager_event_destroy(app_manager_event_h handle);
+
+int app_info_get_app_id(app_info_h app_info, char **app_id);
+
+int app_context_get_app_id(app_context_h app_context, char **app_id);
+int app_context_get_pid(app_context_h app_context, pid_t *pid);
+int app_context_get_app_state(app_context_h app_context, app_state_e *state);
+int app_context_destroy(app_context_h app_context);
+
+#endif /* __BENCH_STUB_APP_MANAGER_H__ */
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen Bluetooth API, there is no adapter */
+
+#ifndef __BENCH_STUB_BLUETOOTH_H__
+#define __BENCH_STUB_BLUETOOTH_H__
+
+typedef enum {
+	BT_ERROR_NONE = 0,
+	BT_ERROR_INVALID_PARAMETER = -22,
+	BT_ERROR_NOT_SUPPORTED = -1073741822,
+} bt_error_e;
+
+typedef enum {
+	BT_ADAPTER_DISABLED = 0,
+	BT_ADAPTER_ENABLED = 1,
+} bt_adapter_state_e;
+
+typedef void (*bt_adapter_state_changed_cb)(int result,
+			bt_adapter_state_e adapter_state, void *user_data);
+
+int bt_initialize(void);
+int bt_deinitialize(void);
+int bt_adapter_set_state_changed_cb(bt_adapter_state_changed_cb callback, void *user_data);
+int bt_adapter_unset_state_changed_cb(void);
+
+#endif /* __BENCH_STUB_BLUETOOTH_H__ */
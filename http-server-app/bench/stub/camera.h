@@ -0,0 +1,143 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen camera API, frames come from the simulation runtime (bench/sim/) */
+
+#ifndef __BENCH_STUB_CAMERA_H__
+#define __BENCH_STUB_CAMERA_H__
+
+#include <stdbool.h>
+
+typedef struct camera_s *camera_h;
+
+typedef enum {
+	CAMERA_ERROR_NONE = 0,
+	CAMERA_ERROR_INVALID_PARAMETER = -22,
+	CAMERA_ERROR_INVALID_STATE = -0x01A10000 | 0x02,
+	CAMERA_ERROR_OUT_OF_MEMORY = -12,
+	CAMERA_ERROR_DEVICE = -0x01A10000 | 0x04,
+	CAMERA_ERROR_INVALID_OPERATION = -38,
+	CAMERA_ERROR_SECURITY_RESTRICTED = -0x01A10000 | 0x07,
+	CAMERA_ERROR_DEVICE_BUSY = -0x01A10000 | 0x08,
+	CAMERA_ERROR_DEVICE_NOT_FOUND = -0x01A10000 | 0x09,
+	CAMERA_ERROR_ESD = -0x01A10000 | 0x0c,
+	CAMERA_ERROR_PERMISSION_DENIED = -13,
+	CAMERA_ERROR_NOT_SUPPORTED = -1073741822,
+	CAMERA_ERROR_RESOURCE_CONFLICT = -0x01A10000 | 0x0d,
+	CAMERA_ERROR_SERVICE_DISCONNECTED = -0x01A10000 | 0x0e,
+} camera_error_e;
+
+typedef enum {
+	CAMERA_STATE_NONE,
+	CAMERA_STATE_CREATED,
+	CAMERA_STATE_PREVIEW,
+	CAMERA_STATE_CAPTURING,
+	CAMERA_STATE_CAPTURED,
+} camera_state_e;
+
+typedef enum {
+	CAMERA_DEVICE_CAMERA0 = 0,
+	CAMERA_DEVICE_CAMERA1,
+	CAMERA_DEVICE_CAMERA2,
+	CAMERA_DEVICE_CAMERA3,
+	CAMERA_DEVICE_CAMERA4,
+	CAMERA_DEVICE_CAMERA5,
+	CAMERA_DEVICE_CAMERA6,
+	CAMERA_DEVICE_CAMERA7,
+	CAMERA_DEVICE_CAMERA8,
+	CAMERA_DEVICE_CAMERA9,
+} camera_device_e;
+
+typedef enum {
+	CAMERA_PIXEL_FORMAT_INVALID = -1,
+	CAMERA_PIXEL_FORMAT_NV12,
+	CAMERA_PIXEL_FORMAT_NV12T,
+	CAMERA_PIXEL_FORMAT_NV16,
+	CAMERA_PIXEL_FORMAT_NV21,
+	CAMERA_PIXEL_FORMAT_YUYV,
+	CAMERA_PIXEL_FORMAT_UYVY,
+	CAMERA_PIXEL_FORMAT_422P,
+	CAMERA_PIXEL_FORMAT_I420,
+	CAMERA_PIXEL_FORMAT_YV12,
+	CAMERA_PIXEL_FORMAT_RGB565,
+	CAMERA_PIXEL_FORMAT_RGB888,
+	CAMERA_PIXEL_FORMAT_RGBA,
+	CAMERA_PIXEL_FORMAT_ARGB,
+	CAMERA_PIXEL_FORMAT_JPEG,
+} camera_pixel_format_e;
+
+typedef struct {
+	camera_pixel_format_e format;
+	int width;
+	int height;
+	int num_of_planes;
+	unsigned int timestamp;
+	union {
+		struct {
+			unsigned char *yuv;
+			unsigned int size;
+		} single_plane;
+		struct {
+			unsigned char *y;
+			unsigned char *uv;
+			unsigned int y_size;
+			unsigned int uv_size;
+		} double_plane;
+		struct {
+			unsigned char *y;
+			unsigned char *u;
+			unsigned char *v;
+			unsigned int y_size;
+			unsigned int u_size;
+			unsigned int v_size;
+		} triple_plane;
+	} data;
+} camera_preview_data_s;
+
+typedef struct {
+	unsigned char *data;
+	unsigned int size;
+	int width;
+	int height;
+	camera_pixel_format_e format;
+	unsigned char *exif;
+	unsigned int exif_size;
+} camera_image_data_s;
+
+typedef void (*camera_state_changed_cb)(camera_state_e previous, camera_state_e current,
+				bool by_policy, void *user_data);
+typedef void (*camera_preview_cb)(camera_preview_data_s *frame, void *user_data);
+typedef void (*camera_capturing_cb)(camera_image_data_s *image, camera_image_data_s *postview,
+				camera_image_data_s *thumbnail, void *user_data);
+typedef void (*camera_capture_completed_cb)(void *user_data);
+
+int camera_create(camera_device_e device, camera_h *camera);
+int camera_destroy(camera_h camera);
+int camera_get_state(camera_h camera, camera_state_e *state);
+int camera_attr_set_image_quality(camera_h camera, int quality);
+int camera_set_preview_resolution(camera_h camera, int width, int height);
+int camera_get_preview_resolution(camera_h camera, int *width, int *height);
+int camera_set_capture_resolution(camera_h camera, int width, int height);
+int camera_set_capture_format(camera_h camera, camera_pixel_format_e format);
+int camera_set_state_changed_cb(camera_h camera, camera_state_changed_cb callback, void *user_data);
+int camera_set_preview_cb(camera_h camera, camera_preview_cb callback, void *user_data);
+int camera_unset_preview_cb(camera_h camera);
+int camera_start_preview(camera_h camera);
+int camera_stop_preview(camera_h camera);
+int camera_start_capture(camera_h camera, camera_capturing_cb capturing_cb,
+			camera_capture_completed_cb completed_cb, void *user_data);
+
+#endif /* __BENCH_STUB_CAMERA_H__ */
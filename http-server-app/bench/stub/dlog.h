@@ -0,0 +1,39 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen dlog, only errors and warnings are printed */
+
+#ifndef __BENCH_STUB_DLOG_H__
+#define __BENCH_STUB_DLOG_H__
+
+#include <stdio.h>
+
+typedef enum {
+	DLOG_UNKNOWN = 0,
+	DLOG_DEFAULT,
+	DLOG_VERBOSE,
+	DLOG_DEBUG,
+	DLOG_INFO,
+	DLOG_WARN,
+	DLOG_ERROR,
+	DLOG_FATAL,
+	DLOG_SILENT,
+} log_priority;
+
+#define dlog_print(prio, tag, fmt, arg...) \
+	((void)((prio) >= DLOG_WARN ? fprintf(stderr, "%s " fmt, tag, ##arg) : 0))
+
+#endif /* __BENCH_STUB_DLOG_H__ */
@@ -0,0 +1,74 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen image util decoder, PNG only */
+
+#ifndef __BENCH_STUB_IMAGE_UTIL_H__
+#define __BENCH_STUB_IMAGE_UTIL_H__
+
+#include <stdbool.h>
+
+typedef struct image_util_decode_s *image_util_decode_h;
+
+typedef enum {
+	IMAGE_UTIL_ERROR_NONE = 0,
+	IMAGE_UTIL_ERROR_INVALID_PARAMETER = -22,
+	IMAGE_UTIL_ERROR_OUT_OF_MEMORY = -12,
+	IMAGE_UTIL_ERROR_NO_SUCH_FILE = -2,
+	IMAGE_UTIL_ERROR_INVALID_OPERATION = -38,
+	IMAGE_UTIL_ERROR_NOT_SUPPORTED_FORMAT = -0x01C30000 | 0x01,
+} image_util_error_e;
+
+typedef enum {
+	IMAGE_UTIL_COLORSPACE_YV12,
+	IMAGE_UTIL_COLORSPACE_YUV422,
+	IMAGE_UTIL_COLORSPACE_I420,
+	IMAGE_UTIL_COLORSPACE_NV12,
+	IMAGE_UTIL_COLORSPACE_UYVY,
+	IMAGE_UTIL_COLORSPACE_YUYV,
+	IMAGE_UTIL_COLORSPACE_RGB565,
+	IMAGE_UTIL_COLORSPACE_RGB888,
+	IMAGE_UTIL_COLORSPACE_ARGB8888,
+	IMAGE_UTIL_COLORSPACE_BGRA8888,
+	IMAGE_UTIL_COLORSPACE_RGBA8888,
+	IMAGE_UTIL_COLORSPACE_BGRX8888,
+	IMAGE_UTIL_COLORSPACE_NV21,
+	IMAGE_UTIL_COLORSPACE_NV16,
+	IMAGE_UTIL_COLORSPACE_NV61,
+} image_util_colorspace_e;
+
+typedef enum {
+	IMAGE_UTIL_JPEG,
+	IMAGE_UTIL_PNG,
+	IMAGE_UTIL_GIF,
+	IMAGE_UTIL_BMP,
+} image_util_type_e;
+
+typedef bool (*image_util_supported_colorspace_cb)(image_util_colorspace_e colorspace,
+			void *user_data);
+
+int image_util_foreach_supported_colorspace(image_util_type_e image_type,
+			image_util_supported_colorspace_cb callback, void *user_data);
+
+int image_util_decode_create(image_util_decode_h *handle);
+int image_util_decode_destroy(image_util_decode_h handle);
+int image_util_decode_set_input_path(image_util_decode_h handle, const char *path);
+int image_util_decode_set_output_buffer(image_util_decode_h handle, unsigned char **dst_buffer);
+int image_util_decode_set_colorspace(image_util_decode_h handle, image_util_colorspace_e colorspace);
+int image_util_decode_run(image_util_decode_h handle, unsigned long *width,
+			unsigned long *height, unsigned long long *size);
+
+#endif /* __BENCH_STUB_IMAGE_UTIL_H__ */
@@ -0,0 +1,77 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Media Vision common API, sources are plain buffers */
+
+#ifndef __BENCH_STUB_MV_COMMON_H__
+#define __BENCH_STUB_MV_COMMON_H__
+
+typedef struct mv_source_s *mv_source_h;
+typedef struct mv_engine_config_s *mv_engine_config_h;
+
+typedef enum {
+	MEDIA_VISION_ERROR_NONE = 0,
+	MEDIA_VISION_ERROR_NOT_SUPPORTED = -1073741822,
+	MEDIA_VISION_ERROR_OUT_OF_MEMORY = -12,
+	MEDIA_VISION_ERROR_INVALID_PARAMETER = -22,
+	MEDIA_VISION_ERROR_INVALID_OPERATION = -38,
+	MEDIA_VISION_ERROR_INVALID_PATH = -0x019D0000 | 0x05,
+	MEDIA_VISION_ERROR_NO_DATA = -61,
+} mv_error_e;
+
+typedef enum {
+	MEDIA_VISION_COLORSPACE_INVALID,
+	MEDIA_VISION_COLORSPACE_Y800,
+	MEDIA_VISION_COLORSPACE_I420,
+	MEDIA_VISION_COLORSPACE_NV12,
+	MEDIA_VISION_COLORSPACE_YV12,
+	MEDIA_VISION_COLORSPACE_NV21,
+	MEDIA_VISION_COLORSPACE_YUYV,
+	MEDIA_VISION_COLORSPACE_UYVY,
+	MEDIA_VISION_COLORSPACE_422P,
+	MEDIA_VISION_COLORSPACE_RGB565,
+	MEDIA_VISION_COLORSPACE_RGB888,
+	MEDIA_VISION_COLORSPACE_RGBA,
+} mv_colorspace_e;
+
+typedef struct {
+	int x;
+	int y;
+} mv_point_s;
+
+typedef struct {
+	mv_point_s point;
+	int width;
+	int height;
+} mv_rectangle_s;
+
+int mv_create_source(mv_source_h *source);
+int mv_destroy_source(mv_source_h source);
+int mv_source_clear(mv_source_h source);
+int mv_source_fill_by_buffer(mv_source_h source, unsigned char *data_buffer,
+			unsigned int buffer_size, unsigned int image_width,
+			unsigned int image_height, mv_colorspace_e image_colorspace);
+int mv_source_get_buffer(mv_source_h source, unsigned char **data_buffer, unsigned int *buffer_size);
+int mv_source_get_width(mv_source_h source, unsigned int *image_width);
+int mv_source_get_height(mv_source_h source, unsigned int *image_height);
+int mv_source_get_colorspace(mv_source_h source, mv_colorspace_e *image_colorspace);
+
+int mv_create_engine_config(mv_engine_config_h *engine_cfg);
+int mv_destroy_engine_config(mv_engine_config_h engine_cfg);
+int mv_engine_config_set_string_attribute(mv_engine_config_h engine_cfg,
+			const char *name, const char *value);
+
+#endif /* __BENCH_STUB_MV_COMMON_H__ */
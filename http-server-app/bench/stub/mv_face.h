@@ -0,0 +1,56 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host stand-in for the Media Vision face API, detection and recognition
+ * are deterministic functions of the image (see bench/sim/sim-vision.c).
+ */
+
+#ifndef __BENCH_STUB_MV_FACE_H__
+#define __BENCH_STUB_MV_FACE_H__
+
+#include <mv_common.h>
+
+#define MV_FACE_DETECTION_MODEL_FILE_PATH "MV_FACE_DETECTION_MODEL_FILE_PATH"
+
+typedef struct mv_face_recognition_model_s *mv_face_recognition_model_h;
+
+typedef void (*mv_face_detected_cb)(mv_source_h source, mv_engine_config_h engine_cfg,
+			mv_rectangle_s *face_locations, int number_of_faces, void *user_data);
+typedef void (*mv_face_recognized_cb)(mv_source_h source,
+			mv_face_recognition_model_h recognition_model,
+			mv_engine_config_h engine_cfg, mv_rectangle_s *face_location,
+			const int *face_label, double confidence, void *user_data);
+
+int mv_face_detect(mv_source_h source, mv_engine_config_h engine_cfg,
+			mv_face_detected_cb detected_cb, void *user_data);
+int mv_face_recognize(mv_source_h source, mv_face_recognition_model_h recognition_model,
+			mv_engine_config_h engine_cfg, mv_rectangle_s *face_location,
+			mv_face_recognized_cb recognized_cb, void *user_data);
+
+int mv_face_recognition_model_create(mv_face_recognition_model_h *recognition_model);
+int mv_face_recognition_model_destroy(mv_face_recognition_model_h recognition_model);
+int mv_face_recognition_model_add(const mv_source_h source,
+			mv_face_recognition_model_h recognition_model,
+			const mv_rectangle_s *example_location, int face_label);
+int mv_face_recognition_model_learn(mv_engine_config_h engine_cfg,
+			mv_face_recognition_model_h recognition_model);
+int mv_face_recognition_model_save(const char *recognition_model_path,
+			mv_face_recognition_model_h recognition_model);
+int mv_face_recognition_model_load(const char *recognition_model_path,
+			mv_face_recognition_model_h *recognition_model);
+
+#endif /* __BENCH_STUB_MV_FACE_H__ */
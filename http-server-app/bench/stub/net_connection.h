@@ -0,0 +1,83 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen connection API, always wired ethernet */
+
+#ifndef __BENCH_STUB_NET_CONNECTION_H__
+#define __BENCH_STUB_NET_CONNECTION_H__
+
+typedef void *connection_h;
+
+typedef enum {
+	CONNECTION_ERROR_NONE = 0,
+	CONNECTION_ERROR_INVALID_PARAMETER = -22,
+	CONNECTION_ERROR_OUT_OF_MEMORY = -12,
+} connection_error_e;
+
+typedef enum {
+	CONNECTION_TYPE_DISCONNECTED = 0,
+	CONNECTION_TYPE_WIFI = 1,
+	CONNECTION_TYPE_CELLULAR = 2,
+	CONNECTION_TYPE_ETHERNET = 3,
+	CONNECTION_TYPE_BT = 4,
+	CONNECTION_TYPE_NET_PROXY,
+} connection_type_e;
+
+typedef enum {
+	CONNECTION_WIFI_STATE_DEACTIVATED = 0,
+	CONNECTION_WIFI_STATE_DISCONNECTED = 1,
+	CONNECTION_WIFI_STATE_CONNECTED = 2,
+} connection_wifi_state_e;
+
+typedef enum {
+	CONNECTION_ETHERNET_STATE_DEACTIVATED = 0,
+	CONNECTION_ETHERNET_STATE_DISCONNECTED = 1,
+	CONNECTION_ETHERNET_STATE_CONNECTED = 2,
+} connection_ethernet_state_e;
+
+typedef enum {
+	CONNECTION_BT_STATE_DEACTIVATED = 0,
+	CONNECTION_BT_STATE_DISCONNECTED = 1,
+	CONNECTION_BT_STATE_CONNECTED = 2,
+} connection_bt_state_e;
+
+typedef enum {
+	CONNECTION_ETHERNET_CABLE_DETACHED = 0,
+	CONNECTION_ETHERNET_CABLE_ATTACHED = 1,
+} connection_ethernet_cable_state_e;
+
+typedef void (*connection_type_changed_cb)(connection_type_e type, void *user_data);
+typedef void (*connection_ethernet_cable_state_changed_cb)(
+			connection_ethernet_cable_state_e state, void *user_data);
+typedef void (*connection_address_changed_cb)(const char *ipv4_address,
+			const char *ipv6_address, void *user_data);
+
+int connection_create(connection_h *connection);
+int connection_destroy(connection_h connection);
+int connection_get_type(connection_h connection, connection_type_e *type);
+int connection_get_wifi_state(connection_h connection, connection_wifi_state_e *state);
+int connection_get_ethernet_state(connection_h connection, connection_ethernet_state_e *state);
+int connection_get_bt_state(connection_h connection, connection_bt_state_e *state);
+int connection_set_type_changed_cb(connection_h connection,
+			connection_type_changed_cb callback, void *user_data);
+int connection_set_ethernet_cable_state_changed_cb(connection_h connection,
+			connection_ethernet_cable_state_changed_cb callback, void *user_data);
+int connection_unset_ethernet_cable_state_changed_cb(connection_h connection);
+int connection_set_ip_address_changed_cb(connection_h connection,
+			connection_address_changed_cb callback, void *user_data);
+int connection_unset_ip_address_changed_cb(connection_h connection);
+
+#endif /* __BENCH_STUB_NET_CONNECTION_H__ */
@@ -0,0 +1,42 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen peripheral I/O GPIO API, writes are recorded by bench/sim/ */
+
+#ifndef __BENCH_STUB_PERIPHERAL_IO_H__
+#define __BENCH_STUB_PERIPHERAL_IO_H__
+
+typedef struct _peripheral_gpio_s *peripheral_gpio_h;
+
+typedef enum {
+	PERIPHERAL_ERROR_NONE = 0,
+	PERIPHERAL_ERROR_IO_ERROR = -5,
+	PERIPHERAL_ERROR_OUT_OF_MEMORY = -12,
+	PERIPHERAL_ERROR_INVALID_PARAMETER = -22,
+} peripheral_error_e;
+
+typedef enum {
+	PERIPHERAL_GPIO_DIRECTION_IN = 0,
+	PERIPHERAL_GPIO_DIRECTION_OUT_INITIALLY_HIGH,
+	PERIPHERAL_GPIO_DIRECTION_OUT_INITIALLY_LOW,
+} peripheral_gpio_direction_e;
+
+int peripheral_gpio_open(int gpio_pin, peripheral_gpio_h *gpio);
+int peripheral_gpio_close(peripheral_gpio_h gpio);
+int peripheral_gpio_set_direction(peripheral_gpio_h gpio, peripheral_gpio_direction_e direction);
+int peripheral_gpio_write(peripheral_gpio_h gpio, unsigned int value);
+
+#endif /* __BENCH_STUB_PERIPHERAL_IO_H__ */
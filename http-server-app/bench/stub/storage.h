@@ -0,0 +1,65 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen storage API, backed by statvfs() */
+
+#ifndef __BENCH_STUB_STORAGE_H__
+#define __BENCH_STUB_STORAGE_H__
+
+#include <stdbool.h>
+
+typedef enum {
+	STORAGE_ERROR_NONE = 0,
+	STORAGE_ERROR_INVALID_PARAMETER = -22,
+	STORAGE_ERROR_OUT_OF_MEMORY = -12,
+	STORAGE_ERROR_NOT_SUPPORTED = -19,
+	STORAGE_ERROR_OPERATION_FAILED = -1,
+} storage_error_e;
+
+typedef enum {
+	STORAGE_TYPE_INTERNAL,
+	STORAGE_TYPE_EXTERNAL,
+	STORAGE_TYPE_EXTENDED_INTERNAL,
+} storage_type_e;
+
+typedef enum {
+	STORAGE_STATE_UNMOUNTABLE = -2,
+	STORAGE_STATE_REMOVED = -1,
+	STORAGE_STATE_MOUNTED = 0,
+	STORAGE_STATE_MOUNTED_READ_ONLY = 1,
+} storage_state_e;
+
+typedef enum {
+	STORAGE_DEV_EXT_SDCARD = 1001,
+	STORAGE_DEV_EXT_USB_MASS_STORAGE,
+	STORAGE_DEV_EXTENDED_INTERNAL,
+} storage_dev_e;
+
+typedef void (*storage_changed_cb)(int storage_id, storage_dev_e dev,
+				storage_state_e state, const char *fstype, const char *fsuuid,
+				const char *mountpath, bool primary, int flags, void *user_data);
+
+typedef bool (*storage_device_supported_cb)(int storage_id, storage_type_e type,
+				storage_state_e state, const char *path, void *user_data);
+
+int storage_foreach_device_supported(storage_device_supported_cb callback, void *user_data);
+int storage_get_total_space(int storage_id, unsigned long long *bytes);
+int storage_get_available_space(int storage_id, unsigned long long *bytes);
+/* never called back on the host, the devices do not change */
+int storage_set_changed_cb(storage_type_e type, storage_changed_cb callback, void *user_data);
+int storage_unset_changed_cb(storage_type_e type, storage_changed_cb callback);
+
+#endif /* __BENCH_STUB_STORAGE_H__ */
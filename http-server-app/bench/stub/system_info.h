@@ -0,0 +1,37 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen system-info API */
+
+#ifndef __BENCH_STUB_SYSTEM_INFO_H__
+#define __BENCH_STUB_SYSTEM_INFO_H__
+
+#include <stdbool.h>
+
+typedef enum {
+	SYSTEM_INFO_ERROR_NONE = 0,
+	SYSTEM_INFO_ERROR_INVALID_PARAMETER = -22,
+	SYSTEM_INFO_ERROR_OUT_OF_MEMORY = -12,
+	SYSTEM_INFO_ERROR_IO_ERROR = -5,
+	SYSTEM_INFO_ERROR_PERMISSION_DENIED = -13,
+	SYSTEM_INFO_ERROR_NOT_SUPPORTED = -1073741822,
+} system_info_error_e;
+
+int system_info_get_platform_bool(const char *key, bool *value);
+int system_info_get_platform_int(const char *key, int *value);
+int system_info_get_platform_string(const char *key, char **value);
+
+#endif /* __BENCH_STUB_SYSTEM_INFO_H__ */
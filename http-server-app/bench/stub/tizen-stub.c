@@ -0,0 +1,508 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host implementations of the Tizen stand-ins used by the server sources.
+ * They return fixed but realistic data, so request cost on the host is
+ * dominated by the server itself rather than by platform calls.
+ */
+
+#include <glib.h>
+#include <libsoup/soup.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/statvfs.h>
+#include "app_common.h"
+#include "service_app.h"
+#include "system_info.h"
+#include "storage.h"
+#include "app_manager.h"
+#include "net_connection.h"
+#include "wifi-manager.h"
+#include "bluetooth.h"
+
+#define STUB_APP_COUNT 40
+
+struct app_context_s {
+	int index;
+};
+
+char *app_get_resource_path(void)
+{
+	const char *path = g_getenv("HS_RES_PATH");
+
+	return g_strdup(path ? path : "../res/");
+}
+
+char *app_get_data_path(void)
+{
+	const char *path = g_getenv("HS_DATA_PATH");
+
+	return g_strdup(path ? path : "/tmp/");
+}
+
+void service_app_exit(void)
+{
+	exit(0);
+}
+
+static const struct {
+	const char *key;
+	const char *value;
+} sysinfo_strings[] = {
+	{ "http://tizen.org/system/manufacturer", "Tizen" },
+	{ "http://tizen.org/feature/profile", "iot-headed" },
+	{ "http://tizen.org/feature/platform.version", "5.5" },
+	{ "http://tizen.org/system/build.string", "tizen-iot-headed_host-bench" },
+	{ "http://tizen.org/system/build.release", "host" },
+	{ "http://tizen.org/system/build.type", "bench" },
+	{ "http://tizen.org/system/build.date", "2019.11.24" },
+	{ "http://tizen.org/system/model_name", "host" },
+	{ "http://tizen.org/system/platform.processor", "x86_64" },
+};
+
+int system_info_get_platform_bool(const char *key, bool *value)
+{
+	if (!key || !value)
+		return SYSTEM_INFO_ERROR_INVALID_PARAMETER;
+
+	*value = true;
+
+	return SYSTEM_INFO_ERROR_NONE;
+}
+
+int system_info_get_platform_int(const char *key, int *value)
+{
+	if (!key || !value)
+		return SYSTEM_INFO_ERROR_INVALID_PARAMETER;
+
+	*value = 0;
+
+	return SYSTEM_INFO_ERROR_NONE;
+}
+
+int system_info_get_platform_string(const char *key, char **value)
+{
+	guint i = 0;
+
+	if (!key || !value)
+		return SYSTEM_INFO_ERROR_INVALID_PARAMETER;
+
+	for (i = 0; i < G_N_ELEMENTS(sysinfo_strings); i++) {
+		if (!strcmp(key, sysinfo_strings[i].key)) {
+			*value = strdup(sysinfo_strings[i].value);
+			return SYSTEM_INFO_ERROR_NONE;
+		}
+	}
+
+	return SYSTEM_INFO_ERROR_NOT_SUPPORTED;
+}
+
+static const char *storage_paths[] = { "/", "/tmp" };
+
+int storage_foreach_device_supported(storage_device_supported_cb callback, void *user_data)
+{
+	guint i = 0;
+
+	if (!callback)
+		return STORAGE_ERROR_INVALID_PARAMETER;
+
+	for (i = 0; i < G_N_ELEMENTS(storage_paths); i++) {
+		if (!callback(i, i ? STORAGE_TYPE_EXTERNAL : STORAGE_TYPE_INTERNAL,
+				STORAGE_STATE_MOUNTED, storage_paths[i], user_data))
+			break;
+	}
+
+	return STORAGE_ERROR_NONE;
+}
+
+static int storage_statvfs(int storage_id, struct statvfs *st)
+{
+	if (storage_id < 0 || storage_id >= (int)G_N_ELEMENTS(storage_paths))
+		return STORAGE_ERROR_NOT_SUPPORTED;
+
+	if (statvfs(storage_paths[storage_id], st))
+		return STORAGE_ERROR_OPERATION_FAILED;
+
+	return STORAGE_ERROR_NONE;
+}
+
+int storage_get_total_space(int storage_id, unsigned long long *bytes)
+{
+	struct statvfs st;
+	int ret = 0;
+
+	if (!bytes)
+		return STORAGE_ERROR_INVALID_PARAMETER;
+
+	ret = storage_statvfs(storage_id, &st);
+	if (ret)
+		return ret;
+
+	*bytes = (unsigned long long)st.f_frsize * st.f_blocks;
+
+	return STORAGE_ERROR_NONE;
+}
+
+int storage_get_available_space(int storage_id, unsigned long long *bytes)
+{
+	struct statvfs st;
+	int ret = 0;
+
+	if (!bytes)
+		return STORAGE_ERROR_INVALID_PARAMETER;
+
+	ret = storage_statvfs(storage_id, &st);
+	if (ret)
+		return ret;
+
+	*bytes = (unsigned long long)st.f_bsize * st.f_bavail;
+
+	return STORAGE_ERROR_NONE;
+}
+
+int storage_set_changed_cb(storage_type_e type, storage_changed_cb callback, void *user_data)
+{
+	if (!callback)
+		return STORAGE_ERROR_INVALID_PARAMETER;
+
+	return STORAGE_ERROR_NONE;
+}
+
+int storage_unset_changed_cb(storage_type_e type, storage_changed_cb callback)
+{
+	if (!callback)
+		return STORAGE_ERROR_INVALID_PARAMETER;
+
+	return STORAGE_ERROR_NONE;
+}
+
+int app_manager_foreach_app_info(app_manager_app_info_cb callback, void *user_data)
+{
+	int i = 0;
+
+	if (!callback)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	for (i = 0; i < STUB_APP_COUNT; i++) {
+		if (!callback((app_info_h)GINT_TO_POINTER(i + 1), user_data))
+			break;
+	}
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_info_get_app_id(app_info_h app_info, char **app_id)
+{
+	if (!app_info || !app_id)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	*app_id = g_strdup_printf("org.tizen.bench.app%02d",
+			GPOINTER_TO_INT(app_info) - 1);
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_manager_get_app_context(const char *app_id, app_context_h *app_context)
+{
+	const char *num = NULL;
+	int index = 0;
+
+	if (!app_id || !app_context)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	num = strrchr(app_id, 'p');
+	index = num ? atoi(num + 1) : 0;
+
+	/* every third app is running */
+	if (index % 3)
+		return APP_MANAGER_ERROR_NO_SUCH_APP;
+
+	*app_context = g_new0(struct app_context_s, 1);
+	(*app_context)->index = index;
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+/* every third app is running, as app_manager_get_app_context() reports */
+int app_manager_foreach_app_context(app_manager_app_context_cb callback, void *user_data)
+{
+	struct app_context_s context;
+	int i = 0;
+
+	if (!callback)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	for (i = 0; i < STUB_APP_COUNT; i += 3) {
+		context.index = i;
+		if (!callback(&context, user_data))
+			break;
+	}
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_manager_set_app_context_status_cb(app_manager_app_context_status_cb callback,
+				const char *appid, void *user_data)
+{
+	if (!callback || !appid)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_manager_unset_app_context_status_cb(app_manager_app_context_status_cb callback,
+				const char *appid)
+{
+	if (!callback || !appid)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_manager_event_create(app_manager_event_h *handle)
+{
+	if (!handle)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	*handle = (app_manager_event_h)g_malloc0(1);
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_manager_event_set_status(app_manager_event_h handle, int status_type)
+{
+	return handle ? APP_MANAGER_ERROR_NONE : APP_MANAGER_ERROR_INVALID_PARAMETER;
+}
+
+int app_manager_set_event_cb(app_manager_event_h handle,
+				app_manager_event_cb callback, void *user_data)
+{
+	if (!handle || !callback)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_manager_unset_event_cb(app_manager_event_h handle)
+{
+	return handle ? APP_MANAGER_ERROR_NONE : APP_MANAGER_ERROR_INVALID_PARAMETER;
+}
+
+int app_manager_event_destroy(app_manager_event_h handle)
+{
+	if (!handle)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	g_free(handle);
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_context_get_app_id(app_context_h app_context, char **app_id)
+{
+	if (!app_context || !app_id)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	*app_id = g_strdup_printf("org.tizen.bench.app%02d", app_context->index);
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_context_get_pid(app_context_h app_context, pid_t *pid)
+{
+	if (!app_context || !pid)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	*pid = 1000 + app_context->index;
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_context_get_app_state(app_context_h app_context, app_state_e *state)
+{
+	if (!app_context || !state)
+		return APP_MANAGER_ERROR_INVALID_PARAMETER;
+
+	*state = app_context->index ? APP_STATE_BACKGROUND : APP_STATE_SERVICE;
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int app_context_destroy(app_context_h app_context)
+{
+	g_free(app_context);
+
+	return APP_MANAGER_ERROR_NONE;
+}
+
+int connection_create(connection_h *connection)
+{
+	if (!connection)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	*connection = g_new0(int, 1);
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_destroy(connection_h connection)
+{
+	g_free(connection);
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_get_type(connection_h connection, connection_type_e *type)
+{
+	if (!connection || !type)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	*type = CONNECTION_TYPE_ETHERNET;
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_get_wifi_state(connection_h connection, connection_wifi_state_e *state)
+{
+	if (!connection || !state)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	*state = CONNECTION_WIFI_STATE_DEACTIVATED;
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_get_ethernet_state(connection_h connection, connection_ethernet_state_e *state)
+{
+	if (!connection || !state)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	*state = CONNECTION_ETHERNET_STATE_CONNECTED;
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_get_bt_state(connection_h connection, connection_bt_state_e *state)
+{
+	if (!connection || !state)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	*state = CONNECTION_BT_STATE_DEACTIVATED;
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_set_type_changed_cb(connection_h connection,
+			connection_type_changed_cb callback, void *user_data)
+{
+	if (!connection || !callback)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	return CONNECTION_ERROR_NONE;
+}
+
+/* the stand-in never changes, the callbacks are accepted and never called */
+int connection_set_ethernet_cable_state_changed_cb(connection_h connection,
+			connection_ethernet_cable_state_changed_cb callback, void *user_data)
+{
+	if (!connection || !callback)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_unset_ethernet_cable_state_changed_cb(connection_h connection)
+{
+	return connection ? CONNECTION_ERROR_NONE : CONNECTION_ERROR_INVALID_PARAMETER;
+}
+
+int connection_set_ip_address_changed_cb(connection_h connection,
+			connection_address_changed_cb callback, void *user_data)
+{
+	if (!connection || !callback)
+		return CONNECTION_ERROR_INVALID_PARAMETER;
+
+	return CONNECTION_ERROR_NONE;
+}
+
+int connection_unset_ip_address_changed_cb(connection_h connection)
+{
+	return connection ? CONNECTION_ERROR_NONE : CONNECTION_ERROR_INVALID_PARAMETER;
+}
+
+/* no radio on the host, the state watchers are skipped with a warning */
+int wifi_manager_initialize(wifi_manager_h *wifi)
+{
+	return WIFI_MANAGER_ERROR_NOT_SUPPORTED;
+}
+
+int wifi_manager_deinitialize(wifi_manager_h wifi)
+{
+	return WIFI_MANAGER_ERROR_NOT_SUPPORTED;
+}
+
+int wifi_manager_set_device_state_changed_cb(wifi_manager_h wifi,
+			wifi_manager_device_state_changed_cb callback, void *user_data)
+{
+	return WIFI_MANAGER_ERROR_NOT_SUPPORTED;
+}
+
+int wifi_manager_unset_device_state_changed_cb(wifi_manager_h wifi)
+{
+	return WIFI_MANAGER_ERROR_NOT_SUPPORTED;
+}
+
+int wifi_manager_set_connection_state_changed_cb(wifi_manager_h wifi,
+			wifi_manager_connection_state_changed_cb callback, void *user_data)
+{
+	return WIFI_MANAGER_ERROR_NOT_SUPPORTED;
+}
+
+int wifi_manager_unset_connection_state_changed_cb(wifi_manager_h wifi)
+{
+	return WIFI_MANAGER_ERROR_NOT_SUPPORTED;
+}
+
+int bt_initialize(void)
+{
+	return BT_ERROR_NOT_SUPPORTED;
+}
+
+int bt_deinitialize(void)
+{
+	return BT_ERROR_NOT_SUPPORTED;
+}
+
+int bt_adapter_set_state_changed_cb(bt_adapter_state_changed_cb callback, void *user_data)
+{
+	return BT_ERROR_NOT_SUPPORTED;
+}
+
+int bt_adapter_unset_state_changed_cb(void)
+{
+	return BT_ERROR_NOT_SUPPORTED;
+}
+
+/* the Wi-Fi scan needs a real radio, hs-route-api-connection-wifi.c is not built */
+void handle_connection_wifi(SoupMessage *msg, GHashTable *query)
+{
+	soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
+}
+
+void handle_connection_wifi_fini(void)
+{
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host stand-in for the Tizen Wi-Fi manager API, there is no radio */
+
+#ifndef __BENCH_STUB_WIFI_MANAGER_H__
+#define __BENCH_STUB_WIFI_MANAGER_H__
+
+typedef void *wifi_manager_h;
+typedef void *wifi_manager_ap_h;
+
+typedef enum {
+	WIFI_MANAGER_ERROR_NONE = 0,
+	WIFI_MANAGER_ERROR_INVALID_PARAMETER = -22,
+	WIFI_MANAGER_ERROR_NOT_SUPPORTED = -1073741822,
+} wifi_manager_error_e;
+
+typedef enum {
+	WIFI_MANAGER_DEVICE_STATE_DEACTIVATED = 0,
+	WIFI_MANAGER_DEVICE_STATE_ACTIVATED = 1,
+} wifi_manager_device_state_e;
+
+typedef enum {
+	WIFI_MANAGER_CONNECTION_STATE_FAILURE = -1,
+	WIFI_MANAGER_CONNECTION_STATE_DISCONNECTED = 0,
+	WIFI_MANAGER_CONNECTION_STATE_ASSOCIATION = 1,
+	WIFI_MANAGER_CONNECTION_STATE_CONFIGURATION = 2,
+	WIFI_MANAGER_CONNECTION_STATE_CONNECTED = 3,
+} wifi_manager_connection_state_e;
+
+typedef void (*wifi_manager_device_state_changed_cb)(
+			wifi_manager_device_state_e state, void *user_data);
+typedef void (*wifi_manager_connection_state_changed_cb)(
+			wifi_manager_connection_state_e state, wifi_manager_ap_h ap, void *user_data);
+
+int wifi_manager_initialize(wifi_manager_h *wifi);
+int wifi_manager_deinitialize(wifi_manager_h wifi);
+int wifi_manager_set_device_state_changed_cb(wifi_manager_h wifi,
+			wifi_manager_device_state_changed_cb callback, void *user_data);
+int wifi_manager_unset_device_state_changed_cb(wifi_manager_h wifi);
+int wifi_manager_set_connection_state_changed_cb(wifi_manager_h wifi,
+			wifi_manager_connection_state_changed_cb callback, void *user_data);
+int wifi_manager_unset_connection_state_changed_cb(wifi_manager_h wifi);
+
+#endif /* __BENCH_STUB_WIFI_MANAGER_H__ */
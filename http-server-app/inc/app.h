@@ -22,13 +22,16 @@
 #include <Ecore.h>
 
 #include "thingspark_api.h"
+#include "usb-camera.h"
+
+#define APP_CAMERA_MAX 2 /* CAMERA_DEVICE_CAMERA0 and 1 */
 
 struct app_data_s {
 	connection_h conn_h;
 	connection_type_e cur_conn_type;
 
 	/* Private */
-	mv_source_h *source;
+	int recognize_camera; /* device of the last result */
 	int recognize_label;
 	double recognize_percent;
 	int recognize_x;
@@ -36,6 +39,9 @@ struct app_data_s {
 	int recognize_width;
 	int recognize_height;
 
+	usb_camera *cameras[APP_CAMERA_MAX]; /* by device, NULL if not running */
+	int n_cameras;
+
 	tp_handle_h handle;
 	Ecore_Timer *tp_timer;
 };
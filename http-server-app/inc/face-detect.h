@@ -17,9 +17,24 @@
 #ifndef __FACE_DETECT_H__
 #define __FACE_DETECT_H__
 
-#include <mv_common.h>
+#include "frame-pool.h"
+#include "face-recognize.h"
 
-int face_detect_with_source(mv_source_h source, void *data);
+/*
+ * One detection thread per camera takes the latest frame from a single
+ * slot mailbox. label names the camera in the metrics, result_cb gets
+ * each recognized face on the detection thread.
+ */
+typedef struct _face_detector face_detector;
+
+face_detector *face_detect_start(const char *label, face_recognize_cb result_cb, void *result_data);
+void face_detect_stop(face_detector *detector);
+
+/* never blocks, a frame still waiting in the mailbox is replaced */
+int face_detect_with_frame(face_detector *detector, frame_buffer *frame);
+
+/* detections running at once over all cameras, 1 by default */
+void face_detect_set_budget(unsigned int slots);
 
 #endif /* __FACE_DETECT_H__ */
 
@@ -19,8 +19,23 @@
 
 #include <mv_common.h>
 
+typedef struct {
+	int label;
+	double confidence;
+	int x;
+	int y;
+	int width;
+	int height;
+} face_recognize_result;
+
+/* called on the thread that recognizes, before face_recognize_with_source() returns */
+typedef void (*face_recognize_cb)(const face_recognize_result *result, void *user_data);
+
 int face_recognize(void);
-int face_recognize_with_source(mv_source_h source, void *data);
+int face_recognize_with_source(mv_source_h source, face_recognize_cb result_cb, void *user_data);
+
+/* hands the result of camera to the app data on the main context, from any thread */
+void face_recognize_notify(void *data, int camera, const face_recognize_result *result);
 
 #endif /* __FACE_RECOGNIZE_H__ */
 
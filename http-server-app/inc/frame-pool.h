@@ -0,0 +1,50 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FRAME_POOL_H__
+#define __FRAME_POOL_H__
+
+#include <glib.h>
+#include <mv_common.h>
+
+/*
+ * Fixed set of Media Vision sources for one camera. A camera frame is
+ * copied once into a free slot, the later stages take references to the
+ * slot instead of copying it again. A slot goes back to the pool when
+ * its last reference is dropped, from any thread.
+ * Media Vision allocates a new source buffer on every fill, so each frame
+ * still costs one allocation. The pool bounds the frames in flight, and
+ * a frame dropped for lack of a slot is never copied.
+ */
+typedef struct _frame_pool frame_pool;
+typedef struct _frame_buffer frame_buffer;
+
+frame_pool *frame_pool_new(unsigned int n_slots, unsigned int width, unsigned int height);
+/* slots still referenced keep the pool alive until they are released */
+void frame_pool_free(frame_pool *pool);
+
+/* NULL when every slot is in use, the frame should be dropped */
+frame_buffer *frame_pool_acquire(frame_pool *pool);
+frame_buffer *frame_buffer_ref(frame_buffer *frame);
+void frame_buffer_unref(frame_buffer *frame);
+
+int frame_buffer_fill(frame_buffer *frame, unsigned char *data, unsigned int size,
+		unsigned int width, unsigned int height, mv_colorspace_e colorspace);
+mv_source_h frame_buffer_get_source(frame_buffer *frame);
+/* monotonic usec when the frame was filled from the camera */
+gint64 frame_buffer_get_time(frame_buffer *frame);
+
+#endif /* __FRAME_POOL_H__ */
@@ -17,7 +17,14 @@
 #ifndef __HTTP_SERVER_ROUTE_API_CONNECTION_H__
 #define __HTTP_SERVER_ROUTE_API_CONNECTION_H__
 
-int hs_route_api_connection_init(void);
+#include <net_connection.h>
+
+/* connection is owned by the app and must outlive the routes */
+int hs_route_api_connection_init(connection_h connection);
+void hs_route_api_connection_fini(void);
+
+/* re-reads the states, call it from the connection type changed callback */
+void hs_route_api_connection_refresh(void);
 
 #endif /* __HTTP_SERVER_ROUTE_API_CONNECTION_H__ */
 
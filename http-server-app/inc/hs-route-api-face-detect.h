@@ -19,4 +19,7 @@
 
 int hs_route_api_face_detect_init(void *data);
 
+/* call on the main context after the recognition result in data is updated */
+void hs_route_api_face_detect_notify(void *data);
+
 #endif /* __HTTP_SERVER_ROUTE_API_FACE_DETECT_H__ */
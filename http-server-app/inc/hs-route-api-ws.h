@@ -0,0 +1,39 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HTTP_SERVER_ROUTE_API_WS_H__
+#define __HTTP_SERVER_ROUTE_API_WS_H__
+
+typedef enum {
+	WS_TOPIC_FACE,
+	WS_TOPIC_STORAGE,
+	WS_TOPIC_CONNECTION,
+	WS_TOPIC_METRICS,
+	WS_TOPIC_MAX,
+} ws_topic_e;
+
+int hs_route_api_ws_init(void);
+
+/*
+ * Sends data, a JSON value, to the subscribers of topic.
+ * snapshot is the whole state, for new subscribers and for a send the
+ * rate limit held back, NULL when data is the whole state already.
+ * Main context only.
+ */
+void hs_route_api_ws_publish(ws_topic_e topic, const char *data,
+			const char *snapshot);
+
+#endif /* __HTTP_SERVER_ROUTE_API_WS_H__ */
@@ -18,15 +18,28 @@
 #define __HTTP_SERVER_UTIL_JSON_H__
 
 #include <glib.h>
-#include <json-glib/json-glib.h>
 
-void util_json_add_int(JsonBuilder *builder, const gchar *name, gint64 value);
-void util_json_add_double(JsonBuilder *builder, const gchar *name, gdouble value);
-void util_json_add_bool(JsonBuilder *builder, const gchar *name, gboolean value);
-void util_json_add_str(JsonBuilder *builder, const gchar *name, const gchar *value);
-void util_json_add_null(JsonBuilder *builder, const gchar *name);
+/*
+ * Writes compact JSON straight into one growing buffer, no node tree.
+ * name is the member name inside an object and NULL inside an array
+ * or for the root value.
+ */
+typedef struct _util_json_writer util_json_writer;
 
-char *util_json_generate_str(JsonBuilder *builder, gsize *len);
+util_json_writer *util_json_writer_new(gsize reserved_size);
 
-#endif /* __HTTP_SERVER_UTIL_JSON_H__ */
+void util_json_begin_object(util_json_writer *writer, const gchar *name);
+void util_json_end_object(util_json_writer *writer);
+void util_json_begin_array(util_json_writer *writer, const gchar *name);
+void util_json_end_array(util_json_writer *writer);
+
+void util_json_add_int(util_json_writer *writer, const gchar *name, gint64 value);
+void util_json_add_double(util_json_writer *writer, const gchar *name, gdouble value);
+void util_json_add_bool(util_json_writer *writer, const gchar *name, gboolean value);
+void util_json_add_str(util_json_writer *writer, const gchar *name, const gchar *value);
+void util_json_add_null(util_json_writer *writer, const gchar *name);
 
+/* frees the writer, the caller owns the returned text, NULL if unbalanced */
+char *util_json_writer_free_to_str(util_json_writer *writer, gsize *len);
+
+#endif /* __HTTP_SERVER_UTIL_JSON_H__ */
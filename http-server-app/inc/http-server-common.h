@@ -17,6 +17,8 @@
 #ifndef __HTTP_SERVER_H__
 #define __HTTP_SERVER_H__
 
+#include <glib.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -27,6 +29,26 @@ void http_server_destroy(void);
 int http_server_start(void);
 int http_server_stop(void);
 
+/*
+ * Call on a network change instead of restarting the server.
+ * Routes and the listener are kept, clients whose local address
+ * is gone are disconnected.
+ */
+int http_server_network_changed(void);
+/* usec from the last network change to the next successful response, -1 if none */
+gint64 http_server_handover_time_to_serve(void);
+
+/* per route counters and latency histograms in Prometheus text format */
+char *http_server_metrics_dump(void);
+
+/*
+ * After a digest login, clients get a signed session cookie
+ * (or may send it as "Authorization: Bearer <token>") and skip the
+ * digest challenge until ttl_sec expires. key NULL uses a random key.
+ */
+int http_server_session_enable(const char *key, unsigned int ttl_sec);
+void http_server_session_disable(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,45 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HTTP_SERVER_CREDENTIAL_H__
+#define __HTTP_SERVER_CREDENTIAL_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * In-memory copy of an htdigest key file ([realm] user=HA1).
+ * The file is monitored and the table is swapped only after a successful
+ * reparse, so a broken edit keeps the previous credentials.
+ */
+typedef struct _credential_store credential_store;
+
+credential_store *credential_store_new(const char *path);
+void credential_store_free(credential_store *store);
+
+int credential_store_reload(credential_store *store);
+
+/* returns a newly allocated HA1 hex digest, or NULL for an unknown user */
+char *credential_store_lookup(credential_store *store,
+				const char *realm, const char *username);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HTTP_SERVER_CREDENTIAL_H__ */
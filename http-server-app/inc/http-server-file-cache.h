@@ -0,0 +1,85 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HTTP_SERVER_FILE_CACHE_H__
+#define __HTTP_SERVER_FILE_CACHE_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Resident cache of the files below a root directory.
+ * An entry keeps the mapped file (or, above 1 MiB, the open file to be
+ * read in pieces), its MIME type and validators, and is
+ * dropped from the cache when the file changes; entries already handed
+ * out stay valid until unreferenced. Files must be replaced, not
+ * rewritten in place, while they are served.
+ * Use the cache on the server's main context only.
+ */
+typedef struct _file_cache file_cache;
+typedef struct _file_cache_entry file_cache_entry;
+
+typedef enum {
+	FILE_CACHE_ENCODING_IDENTITY = 0,
+	FILE_CACHE_ENCODING_GZIP,
+	FILE_CACHE_ENCODING_BR,
+	FILE_CACHE_ENCODING_MAX,
+} file_cache_encoding;
+
+file_cache *file_cache_new(const char *root);
+void file_cache_free(file_cache *cache);
+
+/*
+ * path is below root and starts with "/".
+ * Returns 0 with a new reference in entry, -ENOENT when path is not
+ * a regular file, or another negative errno when it cannot be read.
+ */
+int file_cache_lookup(file_cache *cache, const char *path, file_cache_entry **entry);
+
+file_cache_entry *file_cache_entry_ref(file_cache_entry *entry);
+void file_cache_entry_unref(file_cache_entry *entry);
+
+/* whole content, NULL for large files which must be read */
+const char *file_cache_entry_get_data(file_cache_entry *entry, gsize *len);
+goffset file_cache_entry_get_size(file_cache_entry *entry);
+/* like pread(), returns the bytes copied, 0 at the end or a negative errno */
+gssize file_cache_entry_read(file_cache_entry *entry, goffset offset,
+			void *buf, gsize count);
+
+/*
+ * Content-coding of the file, NULL when it has none.
+ * A "<file>.gz" or "<file>.br" next to the file, not older than it, is used
+ * as is. Without one, gzip is compressed in memory on first use for
+ * textual MIME types. The result, also a missing one, is kept in the entry.
+ * Large files have no coding.
+ */
+const char *file_cache_entry_get_encoded_data(file_cache_entry *entry,
+			file_cache_encoding encoding, gsize *len);
+/* Content-Encoding token of encoding, NULL for identity */
+const char *file_cache_encoding_to_string(file_cache_encoding encoding);
+const char *file_cache_entry_get_mime_type(file_cache_entry *entry);
+/* strong validator from inode, size and mtime, quoted, one per coding */
+const char *file_cache_entry_get_etag(file_cache_entry *entry,
+			file_cache_encoding encoding);
+gint64 file_cache_entry_get_mtime(file_cache_entry *entry);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HTTP_SERVER_FILE_CACHE_H__ */
@@ -0,0 +1,60 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HTTP_SERVER_METRICS_H__
+#define __HTTP_SERVER_METRICS_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per route request counters and latency histograms.
+ * Entries live for the whole process, so counts survive a server restart
+ * and a pointer from route_metrics_get() never dangles.
+ * Not thread safe, record from the main context only.
+ */
+typedef struct _route_metrics route_metrics;
+
+/* method NULL means any method, route NULL collects unrouted requests */
+route_metrics *route_metrics_get(const char *method, const char *route);
+
+void route_metrics_record(route_metrics *metrics,
+			guint status, gsize bytes_out, gint64 elapsed_us);
+
+/*
+ * Process wide counters outside the request path, such as the camera
+ * pipeline. Unlike route metrics they may be added from any thread.
+ * name may carry labels, e.g. camera_frames_total{camera="0"}.
+ */
+typedef struct _metrics_counter metrics_counter;
+
+metrics_counter *metrics_counter_get(const char *name, const char *help);
+/* name{label="value"}, the value is not escaped */
+metrics_counter *metrics_counter_get_labeled(const char *name,
+			const char *label, const char *value, const char *help);
+void metrics_counter_add(metrics_counter *counter, guint64 value);
+guint64 metrics_counter_value(metrics_counter *counter);
+
+/* Prometheus text exposition format, newly allocated */
+char *route_metrics_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HTTP_SERVER_METRICS_H__ */
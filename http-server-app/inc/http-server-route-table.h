@@ -0,0 +1,78 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HTTP_SERVER_ROUTE_TABLE_H__
+#define __HTTP_SERVER_ROUTE_TABLE_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ROUTE_PARAM_MAX 8
+
+/*
+ * Prefix trie keyed on path segments.
+ * Pattern segments are literals, ":name" parameters or a trailing "*"
+ * which also matches every deeper path (soup_server_add_handler() semantics).
+ * Methods are compared as interned strings, so pass msg->method or SOUP_METHOD_*.
+ */
+typedef struct _route_table route_table;
+
+typedef struct {
+	const char *name;
+	const char *value; /* points into the looked up path, NOT nul-terminated */
+	gsize len;
+} route_param;
+
+typedef struct {
+	gpointer handler;
+	route_param params[ROUTE_PARAM_MAX];
+	unsigned int n_params;
+
+	/* Private */
+	gconstpointer node;
+} route_match;
+
+typedef enum {
+	ROUTE_MATCH_OK,
+	ROUTE_MATCH_NOT_FOUND,
+	ROUTE_MATCH_METHOD_NOT_ALLOWED,
+} route_match_result;
+
+route_table *route_table_new(GDestroyNotify handler_free);
+void route_table_free(route_table *table);
+
+/* method NULL registers the handler for any method */
+int route_table_insert(route_table *table, const char *method,
+				const char *pattern, gpointer handler);
+int route_table_remove(route_table *table, const char *method,
+				const char *pattern);
+
+route_match_result route_table_lookup(route_table *table, const char *method,
+				const char *path, route_match *match);
+
+/* comma separated methods of a matched node, for the "Allow" header */
+char *route_table_match_allowed_methods(const route_match *match);
+
+const char *route_match_param_get(const route_match *match,
+				const char *name, gsize *len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HTTP_SERVER_ROUTE_TABLE_H__ */
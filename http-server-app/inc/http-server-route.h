@@ -35,9 +35,78 @@ int http_server_route_handler_add(const char *route_path,
 
 int http_server_route_handler_remove(const char *path);
 
+/*
+ * route_path segments may be ":name" parameters, read them with
+ * http_server_route_param_get() inside the callback.
+ * A trailing "*" segment also matches every path below route_path.
+ * HEAD falls back to the GET route.
+ */
+int http_server_route_add(const char *method, const char *route_path,
+							http_server_route_callback callback,
+							gpointer user_data,
+							GDestroyNotify destroy);
+int http_server_route_remove(const char *method, const char *route_path);
+
+/*
+ * A GET route whose 200 responses are kept, per path, and per query too
+ * if by_query, and replayed without calling callback. Only the status,
+ * Content-Type and body are kept, so callback must not depend on the
+ * request otherwise. Pass by_query FALSE if callback ignores the query.
+ * ttl_sec 0 keeps a response until http_server_route_cache_invalidate()
+ * is called with cache_key, NULL cache_key means route_path.
+ * When the cache is full, expired responses and then the least recently
+ * used one make room.
+ */
+int http_server_route_add_cached(const char *route_path,
+							unsigned int ttl_sec, const char *cache_key,
+							gboolean by_query,
+							http_server_route_callback callback,
+							gpointer user_data,
+							GDestroyNotify destroy);
+/* drops the kept responses of the routes added with cache_key */
+void http_server_route_cache_invalidate(const char *cache_key);
+
+/* Returned value is NOT nul-terminated and valid only in the route callback */
+const char *http_server_route_param_get(SoupMessage *msg,
+							const char *name, gsize *len);
+
+/*
+ * A WebSocket endpoint, the upgrade request is authenticated like any route.
+ * callback must take a reference to connection to keep it open.
+ */
+typedef void (*http_server_websocket_callback) (SoupWebsocketConnection *connection,
+						const char *path, SoupClientContext *client,
+						gpointer user_data);
+
+int http_server_websocket_add(const char *path,
+							http_server_websocket_callback callback,
+							gpointer user_data,
+							GDestroyNotify destroy);
+
 int http_server_pause_message(SoupMessage *msg);
 int http_server_unpause_message(SoupMessage *msg);
 
+/*
+ * Runs func on the shared worker pool with msg paused.
+ * func must not touch msg, it fills resp which is applied to msg
+ * on the server's main context before it is unpaused.
+ * When the queue is full msg gets 503 and -1 is returned.
+ */
+typedef struct _http_server_response http_server_response;
+typedef void (*http_server_worker_func) (http_server_response *resp,
+						gpointer user_data);
+
+int http_server_defer_to_worker(SoupMessage *msg,
+							http_server_worker_func func,
+							gpointer user_data,
+							GDestroyNotify destroy);
+
+void http_server_response_set_status(http_server_response *resp, guint status);
+/* takes body, which must be allocated with g_malloc() */
+void http_server_response_take_body(http_server_response *resp,
+							const char *content_type,
+							char *body, gsize len);
+
 int http_server_auth_default_realm_path_add(const char *path);
 int http_server_auth_default_realm_path_remove(const char *path);
 
@@ -0,0 +1,52 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HTTP_SERVER_SESSION_H__
+#define __HTTP_SERVER_SESSION_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Session token : "<user>:<expiry>:<HMAC-SHA256(user:expiry) in hex>"
+ * expiry is in seconds of g_get_real_time().
+ */
+typedef struct _session_key session_key;
+
+/*
+ * key NULL generates a random key from /dev/urandom, tokens then die with
+ * the process. NULL when no random key could be read.
+ */
+session_key *session_key_new(const char *key);
+void session_key_free(session_key *skey);
+
+char *session_token_issue(const session_key *skey,
+				const char *user, gint64 expiry);
+
+/*
+ * token does not need to be nul-terminated. user, when not NULL, is set
+ * to a newly allocated copy of the signed user on success.
+ */
+gboolean session_token_verify(const session_key *skey,
+				const char *token, gsize len, gint64 now, char **user);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HTTP_SERVER_SESSION_H__ */
@@ -0,0 +1,41 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MOTION_GATE_H__
+#define __MOTION_GATE_H__
+
+#include <stdbool.h>
+
+/*
+ * Cheap per frame motion test on a luma plane: the plane is box
+ * downscaled and compared with a running background of earlier frames.
+ */
+typedef struct _motion_gate motion_gate;
+
+motion_gate *motion_gate_new(unsigned int width, unsigned int height);
+void motion_gate_free(motion_gate *gate);
+
+/*
+ * pixel is the luma change of a downscaled cell that counts as moving,
+ * area_permille the share of moving cells that makes the frame move.
+ */
+void motion_gate_set_threshold(motion_gate *gate, unsigned int pixel, unsigned int area_permille);
+
+/* true when the frame moved, and on the first frame or an unexpected size */
+bool motion_gate_check(motion_gate *gate, const unsigned char *plane,
+		unsigned int width, unsigned int height);
+
+#endif /* __MOTION_GATE_H__ */
@@ -0,0 +1,61 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PIXEL_KERNELS_INTERNAL_H__
+#define __PIXEL_KERNELS_INTERNAL_H__
+
+#include <glib.h>
+#include "pixel-kernels.h"
+
+/*
+ * A kernel left NULL is no faster than on the narrower instruction sets,
+ * the dispatch takes it from the widest one below that has it.
+ */
+typedef struct _pixel_kernels {
+	pixel_isa_e isa;
+	unsigned int (*sad)(const unsigned char *a, unsigned int a_stride,
+			const unsigned char *b, unsigned int b_stride,
+			unsigned int width, unsigned int height);
+	void (*downscale_2x)(const unsigned char *src, unsigned int src_stride,
+			unsigned int width, unsigned int height,
+			unsigned char *dst, unsigned int dst_stride);
+	void (*downscale_4x)(const unsigned char *src, unsigned int src_stride,
+			unsigned int width, unsigned int height,
+			unsigned char *dst, unsigned int dst_stride);
+	void (*sum_sq)(const unsigned char *src, unsigned int stride,
+			unsigned int width, unsigned int height,
+			guint64 *sum, guint64 *sum_sq);
+} pixel_kernels;
+
+/* scalar kernels, the vector ones call them for the columns left over */
+unsigned int pixel_sad_c(const unsigned char *a, unsigned int a_stride,
+		const unsigned char *b, unsigned int b_stride,
+		unsigned int width, unsigned int height);
+void pixel_downscale_2x_c(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride);
+void pixel_downscale_4x_c(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride);
+void pixel_sum_sq_c(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		guint64 *sum, guint64 *sum_sq);
+
+/* NULL when not built for this target or not supported by the CPU */
+const pixel_kernels *pixel_kernels_x86(pixel_isa_e isa);
+const pixel_kernels *pixel_kernels_neon(void);
+
+#endif /* __PIXEL_KERNELS_INTERNAL_H__ */
@@ -0,0 +1,64 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PIXEL_KERNELS_H__
+#define __PIXEL_KERNELS_H__
+
+/*
+ * Kernels over 8 bit planes such as the Y plane of a camera frame.
+ * Each one runs on the fastest version the CPU can run, chosen per kernel
+ * on the first call; widths that are not a multiple of the vector width
+ * are finished by the scalar code.
+ */
+typedef enum {
+	PIXEL_ISA_SCALAR,
+	PIXEL_ISA_SSE2,
+	PIXEL_ISA_AVX2,
+	PIXEL_ISA_NEON,
+	PIXEL_ISA_MAX,
+} pixel_isa_e;
+
+/* sum of absolute differences of two width x height blocks */
+unsigned int pixel_sad(const unsigned char *a, unsigned int a_stride,
+		const unsigned char *b, unsigned int b_stride,
+		unsigned int width, unsigned int height);
+
+/* rounded box average into a width / n x height / n plane */
+void pixel_downscale_2x(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride);
+void pixel_downscale_4x(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride);
+
+void pixel_mean_variance(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		double *mean, double *variance);
+
+/* hist is overwritten, not added to */
+void pixel_histogram(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		unsigned int hist[256]);
+
+pixel_isa_e pixel_kernels_get_isa(void);
+/*
+ * Kernels up to isa, those it has no faster version of stay on a narrower
+ * one. -1 when the instruction set is not built in or the CPU lacks it.
+ */
+int pixel_kernels_set_isa(pixel_isa_e isa);
+const char *pixel_kernels_isa_name(pixel_isa_e isa);
+
+#endif /* __PIXEL_KERNELS_H__ */
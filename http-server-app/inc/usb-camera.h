@@ -17,9 +17,30 @@
 #ifndef __USB_CAMERA_H__
 #define __USB_CAMERA_H__
 
-int usb_camera_prepare(void *data);
-int usb_camera_preview(void *data);
-int usb_camera_capture(void *data);
-void usb_camera_unprepare(void *data);
+#include <stdbool.h>
+#include <camera.h>
+
+#include "face-recognize.h"
+
+/*
+ * One camera device with its own frame pool, motion gate and detection
+ * worker. Recognized faces go to the app data passed to prepare, the
+ * workers of all cameras share the face_detect_set_budget() slots.
+ */
+typedef struct _usb_camera usb_camera;
+
+/*
+ * Face detection runs on frames with motion and at least every interval_ms
+ * on a still scene, or only every interval_ms without motion.
+ * Takes effect on the next usb_camera_prepare().
+ */
+void usb_camera_set_detect_policy(bool motion, unsigned int interval_ms);
+
+usb_camera *usb_camera_prepare(camera_device_e device, void *data);
+int usb_camera_preview(usb_camera *camera);
+int usb_camera_capture(usb_camera *camera);
+/* false until the camera recognized a face */
+bool usb_camera_get_result(usb_camera *camera, face_recognize_result *result);
+void usb_camera_unprepare(usb_camera *camera);
 
 #endif /* __USB_CAMERA_H__ */
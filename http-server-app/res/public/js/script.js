@@ -24,7 +24,10 @@ function httpRequestAsync(httpMethod, path, successCallback, failCallback) {
 
 // Face Info
 function setFaceInfo(jsonStr) {
-	var json = JSON.parse(jsonStr);
+	showFaceInfo(JSON.parse(jsonStr));
+}
+
+function showFaceInfo(json) {
 	var parentElm = document.getElementById("face-information-content");
 
 	var strPreKey = "<div class='col-xl-5 col-lg-5 col-md-10 col-sm-10 col-10 my-3'><div class='card'><div class='card-body'><p class='card-text'>";
@@ -44,6 +47,19 @@ function fetchFaceInfo() {
 	httpRequestAsync("GET", "/api/faceDetect", setFaceInfo);
 }
 
+// pushed by the server when the result changes, polled once without EventSource
+function watchFaceInfo() {
+	if (!window.EventSource) {
+		fetchFaceInfo();
+		return;
+	}
+
+	var source = new EventSource("/api/faceDetect/stream");
+	source.onmessage = function (event) {
+		setFaceInfo(event.data);
+	};
+}
+
 // System Info
 function setSystemInfo(jsonStr) {
 	var json = JSON.parse(jsonStr);
@@ -119,28 +135,54 @@ function storageInfoForeach(value, index, array) {
 	drawStoragePieChart(valueUsed, valueAvailable, 'storage-chart-area-' + (index + 1));
 }
 
-function setStorageInfo(jsonStr) {
+function showStorageInfo(storageInfoList) {
 	var parentElm = document.getElementById("storage-content");
 
 	while (parentElm.hasChildNodes()) {
 		parentElm.removeChild(parentElm.firstChild);
 	}
 
-	var json = JSON.parse(jsonStr);
-	var storageInfoList = json.storageInfoList;
-
 	if (storageInfoList) {
 		storageInfoList.forEach(storageInfoForeach);
 	}
 }
 
+function setStorageInfo(jsonStr) {
+	showStorageInfo(JSON.parse(jsonStr).storageInfoList);
+}
+
 function fetchStorageInfo() {
-	httpRequestAsync("GET", "/api/storageInfo", setStorageInfo);
+	httpRequestAsync("GET", "/api/storage", setStorageInfo);
+}
+
+// the live storage topic only sends the devices that changed
+var storageDevices = {};
+
+function applyStorageDelta(delta) {
+	var list = [];
+
+	if (delta.full)
+		storageDevices = {};
+
+	delta.changed.forEach(function (value) {
+		storageDevices[value.id] = value;
+	});
+	delta.removed.forEach(function (id) {
+		delete storageDevices[id];
+	});
+
+	for (var id in storageDevices) {
+		list.push(storageDevices[id]);
+	}
+	showStorageInfo(list);
 }
 
 // connection status
 function setConnectionInfo(jsonStr) {
-	var json = JSON.parse(jsonStr);
+	showConnectionInfo(JSON.parse(jsonStr));
+}
+
+function showConnectionInfo(json) {
 	// document.getElementById("connection-type-value").innerHTML = json.connection_type;
 	document.getElementById("wifi-value").innerHTML = json.wifi;
 	document.getElementById("eth-value").innerHTML = json.ethernet;
@@ -246,9 +288,54 @@ function fetchApplicationList() {
 	httpRequestAsync("GET", "/api/applicationList", setAppliationList);
 }
 
+// one socket pushes the face, storage and connection panels, polled without it
+var liveSocket = null;
+
+function onLiveMessage(event) {
+	var message = JSON.parse(event.data);
+
+	switch (message.topic) {
+	case "face":
+		showFaceInfo(message.data);
+		break;
+	case "storage":
+		applyStorageDelta(message.data);
+		break;
+	case "connection":
+		showConnectionInfo(message.data);
+		break;
+	}
+}
+
+function watchLive() {
+	var scheme = (location.protocol === "https:") ? "wss://" : "ws://";
+	var socket = null;
+
+	if (!window.WebSocket) {
+		watchFaceInfo();
+		return;
+	}
+
+	socket = new WebSocket(scheme + location.host + "/api/ws");
+	socket.onopen = function () {
+		liveSocket = socket;
+		socket.send(JSON.stringify({ subscribe: ["face", "storage", "connection"] }));
+	};
+	socket.onmessage = onLiveMessage;
+	socket.onclose = function () {
+		var wasOpen = (liveSocket === socket);
+
+		liveSocket = null;
+		if (wasOpen)
+			setTimeout(watchLive, 3000);
+		else
+			watchFaceInfo();
+	};
+}
+
 (() => {
 	document.addEventListener("DOMContentLoaded", function () {
-		fetchFaceInfo();
+		watchLive();
 	});
 
 	document.getElementById("system-tab").addEventListener("click", function () {
@@ -256,11 +343,13 @@ function fetchApplicationList() {
 	});
 
 	document.getElementById("storage-tab").addEventListener("click", function () {
-		fetchStorageInfo();
+		if (!liveSocket)
+			fetchStorageInfo();
 	});
 
 	document.getElementById("connection-tab").addEventListener("click", function () {
-		fetchConnectionStatus();
+		if (!liveSocket)
+			fetchConnectionStatus();
 	});
 
 
@@ -25,7 +25,10 @@
 #include "hs-route-api-storage.h"
 #include "hs-route-api-image-upload.h"
 #include "hs-route-api-face-detect.h"
+#include "hs-route-api-metrics.h"
+#include "hs-route-api-ws.h"
 #include "app.h"
+#include "face-detect.h"
 #include "face-recognize.h"
 #include "usb-camera.h"
 #include "thingspark_api.h"
@@ -34,15 +37,21 @@
 
 #define SERVER_NAME "http-server-app"
 #define SERVER_PORT 8080
+#define SESSION_KEY NULL /* random key per launch */
+#define SESSION_TTL (60 * 60) /* sec */
+#define DETECT_SLOTS 2 /* detections at once over all cameras */
+#define DETECT_MOTION true
+#define DETECT_INTERVAL 3000 /* msec, on a still scene */
 
 static int route_modules_init(void *data)
 {
+	app_data *ad = data;
 	int ret = 0;
 
 	ret = hs_route_root_init();
 	retv_if(ret, -1);
 
-	ret = hs_route_api_connection_init();
+	ret = hs_route_api_connection_init(ad->conn_h);
 	retv_if(ret, -1);
 
 	ret = hs_route_api_applist_init();
@@ -60,6 +69,12 @@ static int route_modules_init(void *data)
 	ret = hs_route_api_face_detect_init(data);
 	retv_if(ret, -1);
 
+	ret = hs_route_api_metrics_init();
+	retv_if(ret, -1);
+
+	ret = hs_route_api_ws_init();
+	retv_if(ret, -1);
+
 	return 0;
 }
 
@@ -92,18 +107,11 @@ static void conn_type_changed_cb(connection_type_e type, void *data)
 
 	_D("connection type is changed [%d] -> [%d]", ad->cur_conn_type, type);
 
-	server_destroy();
-
-	if (type != CONNECTION_TYPE_DISCONNECTED) {
-		int ret = 0;
-		_D("restart server");
-		ret = server_init_n_start(data);
-		if (ret) {
-			_E("failed to start server");
-			service_app_exit();
-		}
-	}
+	/* the server listens on any address, no need to restart it */
+	if (http_server_network_changed())
+		_W("failed to handle network change");
 
+	hs_route_api_connection_refresh();
 	ad->cur_conn_type = type;
 
 	return;
@@ -128,18 +136,60 @@ Eina_Bool _tp_timer_cb(void *data)
 	return ECORE_CALLBACK_RENEW;
 }
 
+/* every camera device that can be opened, a missing one is skipped */
+static int cameras_start(app_data *ad)
+{
+	int device = 0;
+
+	usb_camera_set_detect_policy(DETECT_MOTION, DETECT_INTERVAL);
+	face_detect_set_budget(DETECT_SLOTS);
+
+	for (device = 0; device < APP_CAMERA_MAX; device++) {
+		usb_camera *camera = NULL;
+
+		camera = usb_camera_prepare(CAMERA_DEVICE_CAMERA0 + device, ad);
+		if (!camera) {
+			_W("camera [%d] is not available", device);
+			continue;
+		}
+
+		if (usb_camera_preview(camera) < 0) {
+			usb_camera_unprepare(camera);
+			continue;
+		}
+
+		ad->cameras[device] = camera;
+		ad->n_cameras++;
+	}
+	_D("%d cameras are running", ad->n_cameras);
+
+	return ad->n_cameras ? 0 : -1;
+}
+
+static void cameras_stop(app_data *ad)
+{
+	int device = 0;
+
+	for (device = 0; device < APP_CAMERA_MAX; device++) {
+		usb_camera_unprepare(ad->cameras[device]);
+		ad->cameras[device] = NULL;
+	}
+	ad->n_cameras = 0;
+}
+
 static void service_app_control(app_control_h app_control, void *data)
 {
 	int ret = 0;
 	app_data *ad = data;
-	tp_handle_h handle = NULL;
 
-	face_recognize();
+	/* every launch request comes here, the cameras are started once */
+	if (ad->n_cameras)
+		return;
 
-	ret = usb_camera_prepare(data);
-	ret_if(ret < 0);
+	/* trains or loads the face model before the first camera frame */
+	face_recognize();
 
-	ret = usb_camera_preview(data);
+	ret = cameras_start(ad);
 	ret_if(ret < 0);
 
 	ad->tp_timer = ecore_timer_add(20.0f, _tp_timer_cb, ad);
@@ -153,6 +203,9 @@ static bool service_app_create(void *data)
 
 	retv_if(!ad, false);
 
+	ret = http_server_session_enable(SESSION_KEY, SESSION_TTL);
+	retv_if(ret, false);
+
 	if (ad->tp_timer) {
 		ecore_timer_del(ad->tp_timer);
 		ad->tp_timer = NULL;
@@ -165,10 +218,8 @@ static bool service_app_create(void *data)
 	goto_if(ret, ERROR);
 
 	connection_get_type(ad->conn_h, &ad->cur_conn_type);
-	if (ad->cur_conn_type == CONNECTION_TYPE_DISCONNECTED) {
-		_D("network is not connected, waiting to be connected to any type of network");
-		return true;
-	}
+	if (ad->cur_conn_type == CONNECTION_TYPE_DISCONNECTED)
+		_D("network is not connected, serve when any type of network is connected");
 
 	ret = server_init_n_start(data);
 	goto_if(ret, ERROR);
@@ -176,10 +227,14 @@ static bool service_app_create(void *data)
 	return true;
 
 ERROR:
-	if (ad->conn_h)
+	hs_route_api_connection_fini();
+	server_destroy();
+
+	if (ad->conn_h) {
 		connection_destroy(ad->conn_h);
+		ad->conn_h = NULL;
+	}
 
-	server_destroy();
 	return false;
 }
 
@@ -190,7 +245,9 @@ static void service_app_terminate(void *data)
 	resource_close_relay(19);
 	resource_close_relay(26);
 
-	usb_camera_unprepare(data);
+	cameras_stop(ad);
+	/* the waiting wifi scan requests are answered while the server is up */
+	hs_route_api_connection_fini();
 	server_destroy();
 
 	if (ad->conn_h) {
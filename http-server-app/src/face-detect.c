@@ -15,6 +15,8 @@
  */
 
 #include <glib.h>
+#include <errno.h>
+#include <semaphore.h>
 #include <stdlib.h>
 #include <time.h>
 #include <json-glib/json-glib.h>
@@ -29,9 +31,11 @@
 #include <camera.h>
 
 #include "http-server-log-private.h"
+#include "http-server-metrics.h"
 #include "http-server-route.h"
 #include "hs-util-json.h"
 #include "face-detect.h"
+#include "frame-pool.h"
 #include "face-recognize.h"
 #include "image-cropper.h"
 #include "resource_relay.h"
@@ -39,20 +43,43 @@
 /* Face Detect Model from Tizen */
 #define FACE_DETECT_MODEL_FILEPATH "/usr/share/OpenCV/haarcascades/haarcascade_frontalface_alt.xml"
 
-/* For face detection, use the following facedata_s structure: */
-struct _facedata_s {
-    mv_source_h g_source;
+#define FACE_DETECT_SLOTS_DEFAULT 1 /* detections running at once, over all cameras */
+
+/* For face detection of one camera, use the following face_detector structure: */
+struct _face_detector {
     mv_engine_config_h g_engine_config;
-    int is_working;
 
-	char *type;
-	char *result;
-	unsigned char *image_data;
-	void *user_data;
-	int size;
+    /* detection worker, fed the latest frame through the mailbox */
+    GThread *worker;
+    sem_t wakeup; /* posted for every frame, never blocks the camera */
+    frame_buffer *mailbox;
+    gint running;
+    guint64 vtime; /* usec of detection used, for the scheduler */
+
+    face_recognize_cb result_cb;
+    void *result_data;
+
+    metrics_counter *detected;
+    metrics_counter *replaced;
+    metrics_counter *latency;
+};
+
+/*
+ * Shares the detection and recognition CPU budget between the cameras:
+ * a free slot goes to the waiting detector that has used the least
+ * detection time so far, so a camera with costly frames does not starve
+ * the others and a new one does not take over with its zero account.
+ */
+static struct {
+	GMutex lock;
+	GCond cond;
+	unsigned int slots;
+	unsigned int running;
+	GList *waiting; /* face_detector, in arrival order */
+	guint64 vtime; /* of the last detector granted a slot */
+} g_sched = {
+	.slots = FACE_DETECT_SLOTS_DEFAULT,
 };
-typedef struct _facedata_s facedata_s;
-static facedata_s facedata;
 
 static bool _crop_i420(mv_source_h image, unsigned int result_x, unsigned int result_y,
 		unsigned int result_width, unsigned int result_height,
@@ -307,6 +334,7 @@ static bool _crop_result(mv_source_h image, unsigned int result_x, unsigned int
 static void _on_face_detected_cb(mv_source_h source, mv_engine_config_h engine_cfg,
 	mv_rectangle_s *locations, int number_of_faces, void *user_data)
 {
+	face_detector *detector = user_data;
 	unsigned char *data_buffer = NULL;
 	unsigned int buffer_size = 0;
 	unsigned int image_width = 0;
@@ -383,7 +411,7 @@ static void _on_face_detected_cb(mv_source_h source, mv_engine_config_h engine_c
 		}
 		free(result_buff);
 
-		error_code = face_recognize_with_source(face_part, user_data);
+		error_code = face_recognize_with_source(face_part, detector->result_cb, detector->result_data);
 		if (error_code !=0) _E("cannot recognize faces in the source");
 
 		mv_destroy_source(face_part);
@@ -395,27 +423,27 @@ ERROR:
 	return;
 }
 
-static void _unset_engine_config(void)
+static void _unset_engine_config(face_detector *detector)
 {
-	if (!facedata.g_engine_config) return;
-	mv_destroy_engine_config(facedata.g_engine_config);
-	facedata.g_engine_config = NULL;
+	if (!detector->g_engine_config) return;
+	mv_destroy_engine_config(detector->g_engine_config);
+	detector->g_engine_config = NULL;
 }
 
-static int _set_engine_config(void)
+static int _set_engine_config(face_detector *detector)
 {
 	int error_code = 0;
 
-	if (facedata.g_engine_config) return 0;
+	if (detector->g_engine_config) return 0;
 
 	/* Create the media vision engine using the mv_create_engine_config() function.
 	 * The function creates the g_engine_config engine configuration handle and configures it with default attributes. */
-	error_code = mv_create_engine_config(&facedata.g_engine_config);
+	error_code = mv_create_engine_config(&detector->g_engine_config);
 	retv_if(error_code != MEDIA_VISION_ERROR_NONE, -1);
 
 	/* Face detection details can be configured by setting attributes to the engine configuration handle.
 	 * In this use case, the MV_FACE_DETECTION_MODEL_FILE_PATH attribute is configured. */
-	error_code = mv_engine_config_set_string_attribute(facedata.g_engine_config,
+	error_code = mv_engine_config_set_string_attribute(detector->g_engine_config,
 		MV_FACE_DETECTION_MODEL_FILE_PATH,
 		FACE_DETECT_MODEL_FILEPATH);
 	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
@@ -423,99 +451,198 @@ static int _set_engine_config(void)
 	return 0;
 
 ERROR:
-	_unset_engine_config();
+	_unset_engine_config(detector);
 	return -1;
 }
 
-static gboolean _after_detect_cb(void *user_data)
+/* the waiting detector with the least detection time, the earliest on a tie */
+static face_detector *_sched_next(void)
 {
-	//_D("After mv_face_detect()");
-	facedata.is_working = 0;
-	return FALSE;
+	face_detector *next = NULL;
+	GList *l = NULL;
+
+	for (l = g_sched.waiting; l; l = l->next) {
+		face_detector *detector = l->data;
+
+		if (!next || detector->vtime < next->vtime)
+			next = detector;
+	}
+
+	return next;
 }
 
-static gpointer _create_thread_with_source(void *data)
+static void _sched_acquire(face_detector *detector)
 {
-	int error_code = 0;
+	g_mutex_lock(&g_sched.lock);
 
-	/* When the source and engine configuration handles are ready, use the mv_face_detect() function to detect faces: */
-	error_code = mv_face_detect(facedata.g_source, facedata.g_engine_config, _on_face_detected_cb, data);
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	g_sched.waiting = g_list_append(g_sched.waiting, detector);
+	while (g_sched.running >= g_sched.slots || _sched_next() != detector)
+		g_cond_wait(&g_sched.cond, &g_sched.lock);
 
-	g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
-		_after_detect_cb, NULL, NULL);
+	g_sched.waiting = g_list_remove(g_sched.waiting, detector);
+	g_sched.running++;
+	g_sched.vtime = detector->vtime;
 
-	return NULL;
+	g_mutex_unlock(&g_sched.lock);
+}
 
-ERROR:
-	g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
-		_after_detect_cb, NULL, NULL);
+static void _sched_release(face_detector *detector, gint64 elapsed)
+{
+	g_mutex_lock(&g_sched.lock);
 
-	return NULL;
+	g_sched.running--;
+	detector->vtime += elapsed;
+
+	/* every waiter checks whether it is the next one now */
+	g_cond_broadcast(&g_sched.cond);
+
+	g_mutex_unlock(&g_sched.lock);
 }
 
-int face_detect_with_source(mv_source_h source, void *data)
+/* swaps frame, NULL to take, into the mailbox and returns what was there */
+static frame_buffer *_mailbox_exchange(face_detector *detector, frame_buffer *frame)
 {
-	GThread *th = NULL;
-	unsigned char *data_buffer = NULL;
-	unsigned int buffer_size = 0;
-	unsigned int image_width = 0;
-	unsigned int image_height = 0;
-	mv_colorspace_e image_colorspace = 0;
+	frame_buffer *old = NULL;
+
+	do {
+		old = g_atomic_pointer_get(&detector->mailbox);
+	} while (!g_atomic_pointer_compare_and_exchange(&detector->mailbox, old, frame));
+
+	return old;
+}
 
+static gpointer _detect_worker(gpointer data)
+{
+	face_detector *detector = data;
+	frame_buffer *frame = NULL;
+	gint64 start = 0;
+	gint64 now = 0;
 	int error_code = 0;
 
-	retv_if(!source, -1);
-	if (facedata.is_working) return 0;
-	facedata.is_working = 1;
+	while (g_atomic_int_get(&detector->running)) {
+		if (sem_wait(&detector->wakeup) && errno == EINTR)
+			continue;
 
-	if (facedata.g_source) {
-		//_D("Clear the clonned source");
-		mv_source_clear(facedata.g_source);
-	} else {
-		//_D("Create a clonned source");
-		/* Create a source handle using the mv_create_source() function with the mv_source_h member of the detection data structure as the out parameter: */
-		/* The source stores the face to be detected and all related data. You manage the source through the source handle. */
-		error_code = mv_create_source(&facedata.g_source);
-		goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+		_sched_acquire(detector);
+
+		/* taken once the slot is granted, the latest frame by then */
+		frame = _mailbox_exchange(detector, NULL);
+		if (!frame) {
+			/* the wake up of face_detect_stop() */
+			_sched_release(detector, 0);
+			continue;
+		}
+
+		start = g_get_monotonic_time();
+
+		/* When the source and engine configuration handles are ready, use the mv_face_detect() function to detect faces: */
+		error_code = mv_face_detect(frame_buffer_get_source(frame), detector->g_engine_config,
+				_on_face_detected_cb, detector);
+		if (error_code != MEDIA_VISION_ERROR_NONE)
+			_E("failed to detect faces [%d]", error_code);
+
+		now = g_get_monotonic_time();
+		_sched_release(detector, now - start);
+
+		metrics_counter_add(detector->detected, 1);
+		metrics_counter_add(detector->latency, now - frame_buffer_get_time(frame));
+		frame_buffer_unref(frame);
 	}
 
-	error_code = mv_source_get_buffer(source, &data_buffer, &buffer_size);
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	return NULL;
+}
 
-	error_code = mv_source_get_width(source, &image_width);
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+void face_detect_set_budget(unsigned int slots)
+{
+	ret_if(!slots);
 
-	error_code = mv_source_get_height(source, &image_height);
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	g_mutex_lock(&g_sched.lock);
+	g_sched.slots = slots;
+	g_cond_broadcast(&g_sched.cond);
+	g_mutex_unlock(&g_sched.lock);
+}
 
-	error_code = mv_source_get_colorspace(source, &image_colorspace);
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+face_detector *face_detect_start(const char *label, face_recognize_cb result_cb, void *result_data)
+{
+	face_detector *detector = NULL;
+	int error_code = 0;
 
-	/* Fill the dataBuffer to g_source */
-	error_code = mv_source_fill_by_buffer(facedata.g_source, data_buffer, buffer_size,
-			image_width, image_height, image_colorspace);
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	retv_if(!label, NULL);
 
-	_D("Fill the image[%u x %u = %u]", image_width, image_height, buffer_size);
+	detector = g_new0(face_detector, 1);
+	detector->result_cb = result_cb;
+	detector->result_data = result_data;
 
-	error_code = _set_engine_config();
+	error_code = _set_engine_config(detector);
 	goto_if(error_code, ERROR);
 
-	th = g_thread_try_new(NULL, _create_thread_with_source, data, NULL);
-	retvm_if(!th, -1, "failed to create a thread");
+	detector->detected = metrics_counter_get_labeled("face_detect_frames_total", "camera", label,
+		"Frames face detection ran on");
+	detector->replaced = metrics_counter_get_labeled("face_detect_frames_replaced_total", "camera", label,
+		"Frames replaced by a newer one before face detection took them");
+	detector->latency = metrics_counter_get_labeled("face_detect_latency_usec_total", "camera", label,
+		"Usec from the camera frame to the end of its detection and recognition");
+
+	goto_if(sem_init(&detector->wakeup, 0, 0), ERROR);
+
+	/* joins the others at the current share instead of owing nothing */
+	g_mutex_lock(&g_sched.lock);
+	detector->vtime = g_sched.vtime;
+	g_mutex_unlock(&g_sched.lock);
+
+	g_atomic_int_set(&detector->running, 1);
+	detector->worker = g_thread_try_new("face-detect", _detect_worker, detector, NULL);
+	if (!detector->worker) {
+		_E("failed to create the detection worker");
+		sem_destroy(&detector->wakeup);
+		goto ERROR;
+	}
 
-	return 0;
+	return detector;
 
 ERROR:
-	facedata.is_working = 0;
-	return -1;
+	_unset_engine_config(detector);
+	g_free(detector);
+	return NULL;
 }
 
-void face_undetect(void)
+int face_detect_with_frame(face_detector *detector, frame_buffer *frame)
 {
-	/* After the face detection is complete, destroy the source and engine configuration handles using the  mv_destroy_source() and mv_destroy_engine_config() functions: */
-	mv_destroy_source(facedata.g_source);
-	facedata.g_source = NULL;
-	_unset_engine_config();
+	frame_buffer *replaced = NULL;
+
+	retv_if(!detector || !frame, -1);
+
+	/* the latest frame wins, one the worker has not taken yet is dropped */
+	replaced = _mailbox_exchange(detector, frame_buffer_ref(frame));
+	if (replaced) {
+		/* its wake up is still pending, the worker takes this frame */
+		frame_buffer_unref(replaced);
+		metrics_counter_add(detector->replaced, 1);
+	} else {
+		sem_post(&detector->wakeup);
+	}
+
+	return 0;
+}
+
+void face_detect_stop(face_detector *detector)
+{
+	frame_buffer *frame = NULL;
+
+	if (!detector)
+		return;
+
+	/* the detection in flight finishes first */
+	g_atomic_int_set(&detector->running, 0);
+	sem_post(&detector->wakeup);
+	g_thread_join(detector->worker);
+
+	frame = _mailbox_exchange(detector, NULL);
+	if (frame)
+		frame_buffer_unref(frame);
+	sem_destroy(&detector->wakeup);
+
+	/* After the face detection is complete, destroy the engine configuration handle using the mv_destroy_engine_config() function: */
+	_unset_engine_config(detector);
+	g_free(detector);
 }
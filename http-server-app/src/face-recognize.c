@@ -19,6 +19,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
+#include <unistd.h>
 #include <json-glib/json-glib.h>
 #include <libsoup/soup.h>
 #include <app_common.h>
@@ -30,6 +31,7 @@
 #include <image_util.h>
 
 #include "app.h"
+#include "hs-route-api-face-detect.h"
 #include "http-server-log-private.h"
 #include "thingspark_api.h"
 #include "resource_relay.h"
@@ -43,17 +45,24 @@ struct _facedata_s {
     mv_source_h g_source;
     mv_engine_config_h g_engine_config;
     mv_face_recognition_model_h g_face_recog_model;
-
-	int recognize_label;
-	double recognize_percent;
-	int recognize_x;
-	int recognize_y;
-	int recognize_width;
-	int recognize_height;
+    GMutex lock; /* the model is shared by the detection workers of all cameras */
 };
 typedef struct _facedata_s facedata_s;
 static facedata_s facedata;
 
+/* the caller of mv_face_recognize(), for its callback */
+struct recognize_call {
+	face_recognize_cb result_cb;
+	void *user_data;
+};
+
+/* a result on its way to the main context */
+struct recognize_event {
+	void *data;
+	int camera;
+	face_recognize_result result;
+};
+
 /* Add face examples to the face recognition model handle.
  * Make sure that the face examples are of the same person but captured at different angles.
  * The following example assumes that 10 face samples
@@ -78,6 +87,12 @@ static int _create_model(void)
 	image_util_decode_h imageDecoder = NULL;
 	int error_code = 0;
 
+	/* the samples are decoded into g_source, not created yet on the detection path */
+	if (!facedata.g_source) {
+		error_code = mv_create_source(&facedata.g_source);
+		retv_if(error_code != MEDIA_VISION_ERROR_NONE, -1);
+	}
+
 	app_res_dir = app_get_resource_path();
 	retv_if(!app_res_dir, -1);
 
@@ -169,18 +184,21 @@ ERROR:
 
 static gboolean _after_recognize_cb(void *user_data)
 {
-	app_data *ad = user_data;
+	struct recognize_event *event = user_data;
+	app_data *ad = event->data;
 
 	int ret = 0;
 
-	retv_if(!user_data, FALSE);
+	retv_if(!ad, FALSE);
 
-	ad->recognize_label = facedata.recognize_label;
-	ad->recognize_percent = facedata.recognize_percent;
-	ad->recognize_x = facedata.recognize_x;
-	ad->recognize_y = facedata.recognize_y;
-	ad->recognize_width = facedata.recognize_width;
-	ad->recognize_height = facedata.recognize_height;
+	ad->recognize_camera = event->camera;
+	ad->recognize_label = event->result.label;
+	ad->recognize_percent = event->result.confidence;
+	ad->recognize_x = event->result.x;
+	ad->recognize_y = event->result.y;
+	ad->recognize_width = event->result.width;
+	ad->recognize_height = event->result.height;
+	hs_route_api_face_detect_notify(ad);
 
 	if (ad->recognize_percent > MINIMUM_RECOGNIZE) {
 		ret = tp_initialize("czRXVbgv72ILyJUl", &ad->handle);
@@ -205,23 +223,25 @@ static void _on_face_recognized_cb(mv_source_h source, mv_face_recognition_model
                        mv_engine_config_h engine_config, mv_rectangle_s *face_location,
                        const int *face_label, double confidence, void *user_data)
 {
+	struct recognize_call *call = user_data;
+	face_recognize_result result;
 	int ret = 0;
 
     if (face_label) {
-    	facedata.recognize_label = *face_label;
-    	facedata.recognize_percent = confidence;
-    	facedata.recognize_x = face_location->point.x;
-    	facedata.recognize_y = face_location->point.y;
-    	facedata.recognize_width = face_location->width;
-    	facedata.recognize_height = face_location->height;
+    	result.label = *face_label;
+    	result.confidence = confidence;
+    	result.x = face_location->point.x;
+    	result.y = face_location->point.y;
+    	result.width = face_location->width;
+    	result.height = face_location->height;
 
         _D("Face Recognized : Label[%d], Confidence [%.2f], [%d,%d], [%d:%d]",
-        		facedata.recognize_label,
-				facedata.recognize_percent,
-				facedata.recognize_x,
-				facedata.recognize_y,
-				facedata.recognize_width,
-				facedata.recognize_height);
+        		result.label,
+				result.confidence,
+				result.x,
+				result.y,
+				result.width,
+				result.height);
 
         _D("Relay On");
         ret = resource_write_relay(19, 1);
@@ -230,8 +250,8 @@ static void _on_face_recognized_cb(mv_source_h source, mv_face_recognition_model
         //ret = resource_write_relay(26, 1);
         //if (ret < 0) _E("cannot control the relay");
 
-        g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
-        	_after_recognize_cb, user_data, NULL);
+        if (call && call->result_cb)
+        	call->result_cb(&result, call->user_data);
     } else {
         _D("Relay Off");
         ret = resource_write_relay(19, 0);
@@ -402,27 +422,36 @@ int face_recognize(void)
 	_check_supported_type();
 #endif
 
+	/* the detection workers may be recognizing with the same handles */
+	g_mutex_lock(&facedata.lock);
+
 	/* Create the source and engine configuration handles: */
-	error_code = mv_create_source(&facedata.g_source);
-	retv_if(error_code != MEDIA_VISION_ERROR_NONE, -1);
+	if (!facedata.g_source) {
+		error_code = mv_create_source(&facedata.g_source);
+		goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	}
 
-	error_code = mv_create_engine_config(&facedata.g_engine_config);
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	if (!facedata.g_engine_config) {
+		error_code = mv_create_engine_config(&facedata.g_engine_config);
+		goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	}
 
-	app_data_dir = app_get_data_path();
-	goto_if(!app_data_dir, ERROR);
+	if (!facedata.g_face_recog_model) {
+		app_data_dir = app_get_data_path();
+		goto_if(!app_data_dir, ERROR);
 
-	snprintf(filePath, FILEPATH_SIZE, "%s%s", app_data_dir, FACE_MODEL_FILE_NAME);
-	free(app_data_dir);
+		snprintf(filePath, FILEPATH_SIZE, "%s%s", app_data_dir, FACE_MODEL_FILE_NAME);
+		free(app_data_dir);
 
-	if (access(filePath, F_OK)) {
-		_D("Creating a face model");
-		error_code = _create_model();
-		goto_if(error_code != 0, ERROR);
-	} else {
-		_D("Loading the face model from %s", filePath);
-		error_code = mv_face_recognition_model_load(filePath, &facedata.g_face_recog_model);
-		goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+		if (access(filePath, F_OK)) {
+			_D("Creating a face model");
+			error_code = _create_model();
+			goto_if(error_code != 0, ERROR);
+		} else {
+			_D("Loading the face model from %s", filePath);
+			error_code = mv_face_recognition_model_load(filePath, &facedata.g_face_recog_model);
+			goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+		}
 	}
 
 	error_code = _recognize_face();
@@ -437,6 +466,8 @@ int face_recognize(void)
 	mv_face_recognition_model_destroy(facedata.g_face_recog_model);
 	facedata.g_face_recog_model = NULL;
 
+	g_mutex_unlock(&facedata.lock);
+
 	return 0;
 
 ERROR:
@@ -455,16 +486,18 @@ ERROR:
 		facedata.g_face_recog_model = NULL;
 	}
 
+	g_mutex_unlock(&facedata.lock);
+
 	return -1;
 }
 
 
-static int _recognize_face_with_source(mv_source_h source, void *data)
+static int _recognize_face_with_source(mv_source_h source, struct recognize_call *call)
 {
 	int error_code = 0;
 
 	error_code = mv_face_recognize(source, facedata.g_face_recog_model, facedata.g_engine_config,
-	                               NULL, _on_face_recognized_cb, data);
+	                               NULL, _on_face_recognized_cb, call);
 	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
 
 	return 0;
@@ -473,14 +506,31 @@ ERROR:
 	return -1;
 }
 
-int face_recognize_with_source(mv_source_h source, void *data)
+void face_recognize_notify(void *data, int camera, const face_recognize_result *result)
 {
+	struct recognize_event *event = NULL;
+
+	ret_if(!data || !result);
+
+	event = g_new(struct recognize_event, 1);
+	event->data = data;
+	event->camera = camera;
+	event->result = *result;
+
+	g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+		_after_recognize_cb, event, g_free);
+}
+
+int face_recognize_with_source(mv_source_h source, face_recognize_cb result_cb, void *user_data)
+{
+	struct recognize_call call = { result_cb, user_data };
 	char filePath[FILEPATH_SIZE] = {0, };
 	char *app_data_dir = NULL;
 
-
 	int error_code = 0;
 
+	g_mutex_lock(&facedata.lock);
+
 	/* Engine */
 	if (!facedata.g_engine_config) {
 		error_code = mv_create_engine_config(&facedata.g_engine_config);
@@ -505,9 +555,11 @@ int face_recognize_with_source(mv_source_h source, void *data)
 		}
 	}
 
-	error_code = _recognize_face_with_source(source, data);
+	error_code = _recognize_face_with_source(source, &call);
 	goto_if(error_code != 0, ERROR);
 
+	g_mutex_unlock(&facedata.lock);
+
 	return 0;
 
 ERROR:
@@ -526,6 +578,8 @@ ERROR:
 		facedata.g_face_recog_model = NULL;
 	}
 
+	g_mutex_unlock(&facedata.lock);
+
 	return -1;
 }
 
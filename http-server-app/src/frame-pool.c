@@ -0,0 +1,168 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include "http-server-log-private.h"
+#include "http-server-metrics.h"
+#include "frame-pool.h"
+
+struct _frame_buffer {
+	frame_pool *pool;
+	mv_source_h source;
+	gint64 time; /* monotonic usec of the last fill */
+	volatile gint ref; /* 0 while the slot is free */
+};
+
+struct _frame_pool {
+	volatile gint ref; /* owner and every slot in use */
+	unsigned int n_slots;
+	frame_buffer *slots;
+};
+
+static metrics_counter *g_allocs;
+static metrics_counter *g_copy_bytes;
+
+static void frame_pool_unref(frame_pool *pool)
+{
+	unsigned int i = 0;
+
+	if (!g_atomic_int_dec_and_test(&pool->ref))
+		return;
+
+	for (i = 0; i < pool->n_slots; i++)
+		if (pool->slots[i].source)
+			mv_destroy_source(pool->slots[i].source);
+
+	g_free(pool->slots);
+	g_free(pool);
+}
+
+frame_pool *frame_pool_new(unsigned int n_slots, unsigned int width, unsigned int height)
+{
+	frame_pool *pool = NULL;
+	unsigned int size = width * height;
+	unsigned int i = 0;
+	int error_code = 0;
+
+	retvm_if(!n_slots || !size, NULL, "invalid pool [%u, %ux%u]", n_slots, width, height);
+
+	if (!g_allocs) {
+		g_allocs = metrics_counter_get("frame_pool_allocs_total",
+			"Source buffers Media Vision allocated for camera frames, one per fill");
+		g_copy_bytes = metrics_counter_get("frame_pool_copy_bytes_total",
+			"Bytes copied from the camera into frame pool slots");
+	}
+
+	pool = g_new0(frame_pool, 1);
+	pool->ref = 1;
+	pool->n_slots = n_slots;
+	pool->slots = g_new0(frame_buffer, n_slots);
+
+	for (i = 0; i < n_slots; i++) {
+		frame_buffer *slot = &pool->slots[i];
+
+		slot->pool = pool;
+
+		error_code = mv_create_source(&slot->source);
+		goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	}
+
+	_D("frame pool [%u slots of %ux%u]", n_slots, width, height);
+
+	return pool;
+
+ERROR:
+	_E("failed to prepare the frame pool slot [%u]", i);
+	frame_pool_unref(pool);
+	return NULL;
+}
+
+void frame_pool_free(frame_pool *pool)
+{
+	ret_if(!pool);
+
+	frame_pool_unref(pool);
+}
+
+frame_buffer *frame_pool_acquire(frame_pool *pool)
+{
+	unsigned int i = 0;
+
+	retv_if(!pool, NULL);
+
+	for (i = 0; i < pool->n_slots; i++) {
+		frame_buffer *slot = &pool->slots[i];
+
+		if (g_atomic_int_compare_and_exchange(&slot->ref, 0, 1)) {
+			g_atomic_int_inc(&pool->ref);
+			return slot;
+		}
+	}
+
+	return NULL;
+}
+
+frame_buffer *frame_buffer_ref(frame_buffer *frame)
+{
+	retv_if(!frame, NULL);
+
+	g_atomic_int_inc(&frame->ref);
+
+	return frame;
+}
+
+void frame_buffer_unref(frame_buffer *frame)
+{
+	ret_if(!frame);
+
+	if (g_atomic_int_dec_and_test(&frame->ref))
+		frame_pool_unref(frame->pool);
+}
+
+int frame_buffer_fill(frame_buffer *frame, unsigned char *data, unsigned int size,
+		unsigned int width, unsigned int height, mv_colorspace_e colorspace)
+{
+	int error_code = 0;
+
+	retv_if(!frame || !data, -1);
+
+	/* clear frees the source buffer, the fill allocates a new one */
+	mv_source_clear(frame->source);
+
+	error_code = mv_source_fill_by_buffer(frame->source, data, size,
+			width, height, colorspace);
+	retv_if(error_code != MEDIA_VISION_ERROR_NONE, -1);
+
+	metrics_counter_add(g_allocs, 1);
+	metrics_counter_add(g_copy_bytes, size);
+	frame->time = g_get_monotonic_time();
+
+	return 0;
+}
+
+mv_source_h frame_buffer_get_source(frame_buffer *frame)
+{
+	retv_if(!frame, NULL);
+
+	return frame->source;
+}
+
+gint64 frame_buffer_get_time(frame_buffer *frame)
+{
+	retv_if(!frame, 0);
+
+	return frame->time;
+}
@@ -15,15 +15,13 @@
  */
 
 #include <glib.h>
+#include <string.h>
 #include <libsoup/soup.h>
-#include <json-glib/json-glib.h>
 #include <app_manager.h>
 #include "http-server-log-private.h"
 #include "http-server-route.h"
 #include "hs-util-json.h"
 
-#define ASYNC_RESPONSE 1
-
 #define APP_UNDEFINED "Unknown"
 #define APP_RUNNING "Running"
 #define APP_NOT_RUNNING "Not Running"
@@ -33,6 +31,10 @@
 #define APP_SERVICE "Service"
 #define APP_TERMINATED "Terminated"
 
+#define APPLIST_CACHE_KEY "applicationList"
+#define APPLIST_LIMIT_MAX 1000
+#define APPLIST_RESPONSE_RESERVE (16 * 1024) /* a full device list fits */
+
 static const char *__app_state_to_str(app_state_e state)
 {
 	const char *str = NULL;
@@ -56,124 +58,352 @@ static const char *__app_state_to_str(app_state_e state)
 	return str;
 }
 
+struct app_entry {
+	char *app_id;
+	gboolean running;
+	app_state_e state;
+	pid_t pid;
+};
+
+/*
+ * Installed applications, seeded once and kept current by app manager
+ * callbacks, which come on the main loop like the route callback.
+ */
+struct app_registry {
+	GHashTable *apps; /* app_id -> app_entry */
+	GPtrArray *sorted; /* app_entry by app_id, NULL after a change */
+	app_manager_event_h event;
+};
+
+static void app_context_status_cb(app_context_h app_context,
+			app_context_status_e status, void *user_data);
+
+static void app_entry_free(gpointer data)
+{
+	struct app_entry *entry = data;
+
+	app_manager_unset_app_context_status_cb(app_context_status_cb, entry->app_id);
+	g_free(entry->app_id);
+	g_free(entry);
+}
+
+static const char *app_entry_state_to_str(const struct app_entry *entry)
+{
+	const char *str = NULL;
+
+	if (!entry->running)
+		return APP_NOT_RUNNING;
+
+	str = __app_state_to_str(entry->state);
+
+	return str ? str : APP_UNDEFINED;
+}
+
+static void app_registry_changed(struct app_registry *registry)
+{
+	g_clear_pointer(&registry->sorted, g_ptr_array_unref);
+	http_server_route_cache_invalidate(APPLIST_CACHE_KEY);
+}
+
+static struct app_entry *
+app_registry_add(struct app_registry *registry, const char *app_id)
+{
+	struct app_entry *entry = NULL;
+	int ret = 0;
+
+	entry = g_hash_table_lookup(registry->apps, app_id);
+	if (entry)
+		return entry;
+
+	entry = g_new0(struct app_entry, 1);
+	entry->app_id = g_strdup(app_id);
+	g_hash_table_insert(registry->apps, entry->app_id, entry);
+
+	ret = app_manager_set_app_context_status_cb(app_context_status_cb,
+				app_id, registry);
+	if (ret != APP_MANAGER_ERROR_NONE)
+		_W("failed to watch [%s], its state may go stale [%d]", app_id, ret);
+
+	return entry;
+}
+
+static void app_entry_set_context(struct app_entry *entry, app_context_h app_context)
+{
+	pid_t pid = 0;
+	app_state_e state = APP_STATE_UNDEFINED;
+
+	app_context_get_pid(app_context, &pid);
+	app_context_get_app_state(app_context, &state);
+
+	entry->running = TRUE;
+	entry->pid = pid;
+	entry->state = state;
+}
+
+static void app_context_status_cb(app_context_h app_context,
+			app_context_status_e status, void *user_data)
+{
+	struct app_registry *registry = user_data;
+	struct app_entry *entry = NULL;
+	char *app_id = NULL;
+
+	app_context_get_app_id(app_context, &app_id);
+	ret_if(!app_id);
+
+	entry = g_hash_table_lookup(registry->apps, app_id);
+	g_free(app_id);
+	ret_if(!entry);
+
+	if (status == APP_CONTEXT_STATUS_LAUNCHED) {
+		app_entry_set_context(entry, app_context);
+	} else {
+		entry->running = FALSE;
+		entry->pid = 0;
+	}
+
+	http_server_route_cache_invalidate(APPLIST_CACHE_KEY);
+}
+
+static void app_manager_event_cb(const char *type, const char *app_id,
+			app_manager_event_type_e event_type,
+			app_manager_event_state_e event_state,
+			app_manager_event_h handle, void *user_data)
+{
+	struct app_registry *registry = user_data;
+
+	if (event_state != APP_MANAGER_EVENT_STATE_COMPLETED || !app_id)
+		return;
+
+	switch (event_type) {
+	case APP_MANAGER_EVENT_INSTALL:
+		app_registry_add(registry, app_id);
+		break;
+	case APP_MANAGER_EVENT_UNINSTALL:
+		g_hash_table_remove(registry->apps, app_id);
+		break;
+	default:
+		return;
+	}
+
+	_D("[%s] is %s", app_id,
+		event_type == APP_MANAGER_EVENT_INSTALL ? "installed" : "uninstalled");
+	app_registry_changed(registry);
+}
+
 static bool app_info_foreach_cb(app_info_h app_info, void *user_data)
 {
-	JsonBuilder *builder = user_data;
+	struct app_registry *registry = user_data;
 	char *app_id = NULL;
-	app_context_h app_context = NULL;
-	int pid = 0;
-	int ret = 0;
-	const char *app_state = NULL;
-	retv_if(!builder, false);
 
 	app_info_get_app_id(app_info, &app_id);
 	retv_if(!app_id, false);
 
-	ret = app_manager_get_app_context(app_id, &app_context);
-	if (ret != APP_MANAGER_ERROR_NONE) {
-		if (ret == APP_MANAGER_ERROR_NO_SUCH_APP) {
-			app_state = APP_NOT_RUNNING;
-		} else {
-			_E("failed to get app context");
-			app_state = APP_UNDEFINED;
-		}
-	} else {
-		app_state_e state;
-		app_context_get_pid(app_context, &pid);
-		app_context_get_app_state(app_context, &state);
-		app_state = __app_state_to_str(state);
-		app_context_destroy(app_context);
-		app_context = NULL;
-	}
+	app_registry_add(registry, app_id);
+	g_free(app_id);
 
-	json_builder_begin_object(builder);
+	return true;
+}
 
-	util_json_add_str(builder, "appId", app_id);
-	util_json_add_str(builder, "appState", app_state);
+static bool app_context_foreach_cb(app_context_h app_context, void *user_data)
+{
+	struct app_registry *registry = user_data;
+	struct app_entry *entry = NULL;
+	char *app_id = NULL;
 
-	if (pid > 0)
-		util_json_add_int(builder, "appPid", pid);
+	app_context_get_app_id(app_context, &app_id);
+	retv_if(!app_id, true);
 
-	json_builder_end_object(builder);
+	entry = g_hash_table_lookup(registry->apps, app_id);
+	if (entry)
+		app_entry_set_context(entry, app_context);
+	g_free(app_id);
 
 	return true;
 }
 
-static void app_info_response_append(SoupMessage *msg)
+static void app_registry_free(gpointer data)
 {
-	char *response_msg = NULL;
-	gsize resp_msg_size = 0;
-	JsonBuilder *builder = NULL;
+	struct app_registry *registry = data;
+
+	if (!registry)
+		return;
 
-	builder = json_builder_new();
+	if (registry->event) {
+		app_manager_unset_event_cb(registry->event);
+		app_manager_event_destroy(registry->event);
+	}
+	g_clear_pointer(&registry->sorted, g_ptr_array_unref);
+	g_hash_table_unref(registry->apps);
+	g_free(registry);
+}
 
-	json_builder_begin_object(builder);
-	json_builder_set_member_name(builder, "installedAppList");
+static struct app_registry *app_registry_new(void)
+{
+	struct app_registry *registry = NULL;
+	int ret = 0;
 
-	json_builder_begin_array(builder);
-	app_manager_foreach_app_info(app_info_foreach_cb, builder);
-	json_builder_end_array(builder);
+	registry = g_new0(struct app_registry, 1);
+	registry->apps = g_hash_table_new_full(g_str_hash, g_str_equal,
+				NULL, app_entry_free);
 
-	json_builder_end_object(builder);
+	/* one enumeration of each, instead of a context lookup per app */
+	ret = app_manager_foreach_app_info(app_info_foreach_cb, registry);
+	if (ret != APP_MANAGER_ERROR_NONE) {
+		_E("failed to get installed apps [%d]", ret);
+		app_registry_free(registry);
+		return NULL;
+	}
 
-	response_msg = util_json_generate_str(builder, &resp_msg_size);
-	g_clear_pointer(&builder, g_object_unref);
+	ret = app_manager_foreach_app_context(app_context_foreach_cb, registry);
+	if (ret != APP_MANAGER_ERROR_NONE)
+		_W("failed to get running apps [%d], all shown as not running", ret);
 
-	soup_message_body_append(msg->response_body, SOUP_MEMORY_COPY,
-					response_msg, resp_msg_size);
+	ret = app_manager_event_create(&registry->event);
+	if (ret == APP_MANAGER_ERROR_NONE) {
+		app_manager_event_set_status(registry->event,
+				APP_MANAGER_EVENT_STATUS_TYPE_ALL);
+		ret = app_manager_set_event_cb(registry->event,
+				app_manager_event_cb, registry);
+	}
+	if (ret != APP_MANAGER_ERROR_NONE)
+		_W("failed to watch app installation [%d]", ret);
 
-	g_clear_pointer(&response_msg, g_free);
+	_D("%u installed apps", g_hash_table_size(registry->apps));
 
-	soup_message_headers_set_content_type(
-						msg->response_headers, "application/json", NULL);
+	return registry;
+}
 
-	soup_message_set_status(msg, SOUP_STATUS_OK);
+static gint app_entry_cmp(gconstpointer a, gconstpointer b)
+{
+	const struct app_entry *x = *(struct app_entry * const *)a;
+	const struct app_entry *y = *(struct app_entry * const *)b;
+
+	return strcmp(x->app_id, y->app_id);
+}
+
+/* a stable order, so pages do not shift while nothing is installed */
+static GPtrArray *app_registry_sorted(struct app_registry *registry)
+{
+	GHashTableIter iter;
+	gpointer entry = NULL;
+
+	if (registry->sorted)
+		return registry->sorted;
+
+	registry->sorted = g_ptr_array_sized_new(g_hash_table_size(registry->apps));
+	g_hash_table_iter_init(&iter, registry->apps);
+	while (g_hash_table_iter_next(&iter, NULL, &entry))
+		g_ptr_array_add(registry->sorted, entry);
+	g_ptr_array_sort(registry->sorted, app_entry_cmp);
+
+	return registry->sorted;
 }
 
-#if ASYNC_RESPONSE
-static gboolean __handle_message_finished(gpointer data)
+static gboolean app_entry_matches(const struct app_entry *entry, const char *state)
 {
-	SoupMessage *msg = data;
-	http_server_unpause_message(msg);
-	return FALSE;
+	if (!state)
+		return TRUE;
+
+	if (!strcmp(state, APP_RUNNING))
+		return entry->running;
+
+	return !strcmp(state, app_entry_state_to_str(entry));
 }
 
-static gpointer app_info_thread(gpointer data)
+static int query_get_uint(GHashTable *query, const char *name,
+			guint64 max, guint64 *value)
 {
-	SoupMessage *msg = data;
+	const char *str = NULL;
+	char *end = NULL;
+	guint64 v = 0;
 
-	app_info_response_append(msg);
+	str = query ? g_hash_table_lookup(query, name) : NULL;
+	if (!str)
+		return 0;
 
-	g_idle_add(__handle_message_finished, msg);
+	if (!g_ascii_isdigit(str[0]))
+		return -1;
 
-	return NULL;
+	v = g_ascii_strtoull(str, &end, 10);
+	if (*end || v > max)
+		return -1;
+
+	*value = v;
+
+	return 0;
 }
-#endif /* ASYNC_RESPONSE */
 
 static void route_api_applist_callback(SoupMessage *msg,
 					const char *path, GHashTable *query,
 					SoupClientContext *client, gpointer user_data)
 {
-	if (msg->method != SOUP_METHOD_GET) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
+	struct app_registry *registry = user_data;
+	const char *state = NULL;
+	char *response_msg = NULL;
+	gsize resp_msg_size = 0;
+	util_json_writer *writer = NULL;
+	GPtrArray *apps = NULL;
+	guint64 offset = 0;
+	guint64 limit = APPLIST_LIMIT_MAX;
+	guint64 total = 0;
+	guint i = 0;
+
+	/* ?state=Running or any appState value, ?offset= and ?limit= */
+	if (query_get_uint(query, "offset", G_MAXUINT, &offset)
+		|| query_get_uint(query, "limit", APPLIST_LIMIT_MAX, &limit)) {
+		soup_message_set_status(msg, SOUP_STATUS_BAD_REQUEST);
 		return;
 	}
+	state = query ? g_hash_table_lookup(query, "state") : NULL;
 
-#if ASYNC_RESPONSE
-	GThread *thread = g_thread_try_new(NULL, app_info_thread, msg, NULL);
-	if (!thread) {
-		_E("failed to create thread");
-		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
-		return;
+	writer = util_json_writer_new(APPLIST_RESPONSE_RESERVE);
+
+	util_json_begin_object(writer, NULL);
+	util_json_begin_array(writer, "installedAppList");
+	apps = app_registry_sorted(registry);
+	for (i = 0; i < apps->len; i++) {
+		struct app_entry *entry = g_ptr_array_index(apps, i);
+
+		if (!app_entry_matches(entry, state))
+			continue;
+
+		if (total++ < offset || total > offset + limit)
+			continue;
+
+		util_json_begin_object(writer, NULL);
+		util_json_add_str(writer, "appId", entry->app_id);
+		util_json_add_str(writer, "appState", app_entry_state_to_str(entry));
+		if (entry->running && entry->pid > 0)
+			util_json_add_int(writer, "appPid", entry->pid);
+		util_json_end_object(writer);
 	}
-	http_server_pause_message(msg);
-#else
-	app_info_response_append(msg);
-#endif /* ASYNC_RESPONSE */
+	util_json_end_array(writer);
+
+	/* matching apps on all pages */
+	util_json_add_int(writer, "total", total);
+
+	util_json_end_object(writer);
+
+	response_msg = util_json_writer_free_to_str(writer, &resp_msg_size);
+
+	soup_message_set_response(msg, "application/json",
+			SOUP_MEMORY_TAKE, response_msg, resp_msg_size);
+	soup_message_set_status(msg, SOUP_STATUS_OK);
 }
 
 int hs_route_api_applist_init(void)
 {
-	return http_server_route_handler_add("/api/applicationList",
-				route_api_applist_callback, NULL, NULL);
+	struct app_registry *registry = NULL;
+	int ret = 0;
+
+	registry = app_registry_new();
+	retv_if(!registry, -1);
+
+	/* rebuilt only when an app is installed, removed, launched or terminated */
+	ret = http_server_route_add_cached("/api/applicationList", 0, APPLIST_CACHE_KEY,
+				TRUE, route_api_applist_callback, registry, app_registry_free);
+	if (ret)
+		app_registry_free(registry);
+
+	return ret;
 }
@@ -16,31 +16,53 @@
 
 #include <glib.h>
 #include <libsoup/soup.h>
-#include <json-glib/json-glib.h>
 #include <wifi-manager.h>
 #include "http-server-log-private.h"
 #include "http-server-route.h"
 #include "hs-util-json.h"
+#include "hs-route-api-connection.h"
 
 #define API_SUB_WIFI "wifiScan"
-
-struct wifi_data {
+#define WIFI_SCAN_MAX_AGE 10 /* sec, when the request has no maxAge */
+#define WIFI_SCAN_REFRESH_INTERVAL 60 /* sec */
+#define WIFI_SCAN_REFRESH_IDLE_STOP (5 * 60) /* sec without a request */
+
+typedef enum {
+	WIFI_SCAN_IDLE,
+	WIFI_SCAN_ACTIVATING,
+	WIFI_SCAN_SCANNING,
+	WIFI_SCAN_DEACTIVATING,
+} wifi_scan_state;
+
+struct wifi_waiter {
 	SoupMessage *msg;
+	gulong finished_handler;
+};
+
+/*
+ * One scan at a time for every client, on the server's main context.
+ * Requests arriving during a scan wait for it instead of starting another.
+ */
+struct wifi_scan {
 	wifi_manager_h wifi;
-	bool activated;
+	wifi_scan_state state;
+	gboolean activated_by_scan; /* the radio was off, turn it off again */
+	GList *waiters; /* wifi_waiter */
+
+	SoupBuffer *result; /* NULL until a scan succeeds */
+	gint64 result_time; /* monotonic */
+
+	guint refresh_timer;
+	gint64 last_request_time; /* monotonic */
 };
 
-static void wifi_deactivated_cb(wifi_manager_error_e result, void *user_data)
-{
-	struct wifi_data *data = user_data;
-	wifi_manager_deinitialize(data->wifi);
-	http_server_unpause_message(data->msg);
-	g_free(data);
-}
+static struct wifi_scan g_scan;
+
+static void wifi_scan_start(struct wifi_scan *scan);
 
 static bool wifi_found_ap_cb(wifi_manager_ap_h ap, void *user_data)
 {
-	JsonBuilder *builder = user_data;
+	util_json_writer *writer = user_data;
 	char *essid = NULL;
 	int rssi = 0;
 	bool fav = false;
@@ -49,147 +71,319 @@ static bool wifi_found_ap_cb(wifi_manager_ap_h ap, void *user_data)
 	wifi_manager_ap_get_rssi(ap, &rssi);
 	wifi_manager_ap_is_favorite(ap, &fav);
 
-	json_builder_begin_object(builder);
+	util_json_begin_object(writer, NULL);
 
-	util_json_add_str(builder, "essid", essid);
-	util_json_add_int(builder, "rssi", rssi);
-	util_json_add_bool(builder, "favorite", fav);
+	util_json_add_str(writer, "essid", essid);
+	util_json_add_int(writer, "rssi", rssi);
+	util_json_add_bool(writer, "favorite", fav);
 
-	json_builder_end_object(builder);
+	util_json_end_object(writer);
 
 	g_free(essid);
 
 	return true;
 }
 
-static void wifi_info_response_append(wifi_manager_h wifi, SoupMessage *msg)
+static SoupBuffer *wifi_scan_result_build(wifi_manager_h wifi)
 {
 	char *response_msg = NULL;
 	gsize resp_msg_size = 0;
-	JsonBuilder *builder = NULL;
+	util_json_writer *writer = NULL;
+
+	writer = util_json_writer_new(0);
+
+	util_json_begin_object(writer, NULL);
+	util_json_begin_array(writer, "apList");
+	wifi_manager_foreach_found_ap(wifi, wifi_found_ap_cb, writer);
+	util_json_end_array(writer);
+	util_json_end_object(writer);
 
-	builder = json_builder_new();
+	response_msg = util_json_writer_free_to_str(writer, &resp_msg_size);
 
-	json_builder_begin_object(builder);
-	json_builder_set_member_name(builder, "apList");
+	return soup_buffer_new(SOUP_MEMORY_TAKE, response_msg, resp_msg_size);
+}
 
-	json_builder_begin_array(builder);
-	wifi_manager_foreach_found_ap(wifi, wifi_found_ap_cb, builder);
-	json_builder_end_array(builder);
+static gint64 wifi_scan_result_age(struct wifi_scan *scan)
+{
+	return (g_get_monotonic_time() - scan->result_time) / G_USEC_PER_SEC;
+}
 
-	json_builder_end_object(builder);
+static void wifi_scan_respond(struct wifi_scan *scan, SoupMessage *msg)
+{
+	char *age = NULL;
 
-	response_msg = util_json_generate_str(builder, &resp_msg_size);
-	g_clear_pointer(&builder, g_object_unref);
+	if (!scan->result) {
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		return;
+	}
 
-	soup_message_body_append(msg->response_body, SOUP_MEMORY_COPY,
-					response_msg, resp_msg_size);
-	g_clear_pointer(&response_msg, g_free);
+	/* shared by every response, appending only takes a reference */
+	soup_message_body_append_buffer(msg->response_body, scan->result);
+	soup_message_headers_set_content_type(msg->response_headers,
+			"application/json", NULL);
 
-	soup_message_headers_set_content_type(
-						msg->response_headers, "application/json", NULL);
+	age = g_strdup_printf("%" G_GINT64_FORMAT, wifi_scan_result_age(scan));
+	soup_message_headers_replace(msg->response_headers, "Age", age);
+	g_free(age);
 
 	soup_message_set_status(msg, SOUP_STATUS_OK);
 }
 
+static void wifi_waiter_finished_cb(SoupMessage *msg, gpointer user_data)
+{
+	struct wifi_waiter *waiter = user_data;
+
+	/* the client is gone while waiting */
+	g_signal_handler_disconnect(msg, waiter->finished_handler);
+	g_scan.waiters = g_list_remove(g_scan.waiters, waiter);
+	g_object_unref(waiter->msg);
+	g_free(waiter);
+}
+
+static void wifi_scan_wait(struct wifi_scan *scan, SoupMessage *msg)
+{
+	struct wifi_waiter *waiter = NULL;
+
+	waiter = g_new0(struct wifi_waiter, 1);
+	waiter->msg = g_object_ref(msg);
+	waiter->finished_handler = g_signal_connect(msg, "finished",
+				G_CALLBACK(wifi_waiter_finished_cb), waiter);
+	scan->waiters = g_list_append(scan->waiters, waiter);
+
+	http_server_pause_message(msg);
+}
+
+/*
+ * Answers every waiting request, with the new result or an error.
+ * A failed scan keeps the last result for ?stale=1 requests.
+ */
+static void wifi_scan_complete(struct wifi_scan *scan, gboolean succeeded)
+{
+	GList *waiters = NULL;
+	GList *l = NULL;
+
+	waiters = g_steal_pointer(&scan->waiters);
+	for (l = waiters; l; l = l->next) {
+		struct wifi_waiter *waiter = l->data;
+
+		g_signal_handler_disconnect(waiter->msg, waiter->finished_handler);
+		if (succeeded)
+			wifi_scan_respond(scan, waiter->msg);
+		else
+			soup_message_set_status(waiter->msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		http_server_unpause_message(waiter->msg);
+		g_object_unref(waiter->msg);
+		g_free(waiter);
+	}
+	g_list_free(waiters);
+}
+
+static void wifi_scan_idle(struct wifi_scan *scan)
+{
+	scan->state = WIFI_SCAN_IDLE;
+
+	/* requests that came while the radio was turned off */
+	if (scan->waiters)
+		wifi_scan_start(scan);
+}
+
+static void wifi_deactivated_cb(wifi_manager_error_e result, void *user_data)
+{
+	struct wifi_scan *scan = user_data;
+
+	if (result != WIFI_MANAGER_ERROR_NONE)
+		_E("wifi_deactivated_cb() with error(%x)", result);
+
+	/* radio on/off does not change the connection type */
+	hs_route_api_connection_refresh();
+	wifi_scan_idle(scan);
+}
+
 static void wifi_scan_finished_cb(wifi_manager_error_e result, void *user_data)
 {
-	struct wifi_data *data = user_data;
+	struct wifi_scan *scan = user_data;
+	int ret = 0;
 
 	_D("wifi scan finished");
 
 	if (result != WIFI_MANAGER_ERROR_NONE) {
 		_E("wifi_scan_finished_cb() with error(%x)", result);
-		soup_message_set_status(data->msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
-		goto OUT;
+		wifi_scan_complete(scan, FALSE);
+	} else {
+		if (scan->result)
+			soup_buffer_free(scan->result);
+		scan->result = wifi_scan_result_build(scan->wifi);
+		scan->result_time = g_get_monotonic_time();
+		wifi_scan_complete(scan, TRUE);
 	}
 
-	wifi_info_response_append(data->wifi, data->msg);
-
-	if (!data->activated) {
-		int ret = wifi_manager_deactivate(data->wifi, wifi_deactivated_cb, data);
-		if (ret) {
-			_E("failed to wifi_manager_deactivate() - %d", ret);
-			http_server_unpause_message(data->msg);
-		}
+	if (!scan->activated_by_scan) {
+		wifi_scan_idle(scan);
 		return;
 	}
 
-OUT:
-	wifi_manager_deinitialize(data->wifi);
-	http_server_unpause_message(data->msg);
-	g_free(data);
+	scan->state = WIFI_SCAN_DEACTIVATING;
+	ret = wifi_manager_deactivate(scan->wifi, wifi_deactivated_cb, scan);
+	if (ret) {
+		_E("failed to wifi_manager_deactivate() - %d", ret);
+		wifi_scan_idle(scan);
+	}
 }
 
 static void wifi_activated_cb(wifi_manager_error_e result, void *user_data)
 {
-	struct wifi_data *data = user_data;
+	struct wifi_scan *scan = user_data;
+	int ret = 0;
 
 	if (result != WIFI_MANAGER_ERROR_NONE) {
 		_E("wifi_activated_cb() with error(%x)", result);
-		soup_message_set_status(data->msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
-		wifi_manager_deinitialize(data->wifi);
-		http_server_unpause_message(data->msg);
-		g_free(data);
+		wifi_scan_complete(scan, FALSE);
+		wifi_scan_idle(scan);
 		return;
 	}
 
-	wifi_manager_scan(data->wifi, wifi_scan_finished_cb, user_data);
+	hs_route_api_connection_refresh();
+	scan->state = WIFI_SCAN_SCANNING;
+	ret = wifi_manager_scan(scan->wifi, wifi_scan_finished_cb, scan);
+	if (ret) {
+		_E("failed to wifi_manager_scan() - %x", ret);
+		wifi_scan_finished_cb(ret, scan);
+	}
 }
 
-void handle_connection_wifi(SoupMessage *msg, GHashTable *query)
+static void wifi_scan_start(struct wifi_scan *scan)
 {
-	wifi_manager_h wifi = NULL;
 	bool activated = false;
-	struct wifi_data *data = NULL;
 	int ret = 0;
 
-	if (msg->method != SOUP_METHOD_GET) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
+	if (scan->state != WIFI_SCAN_IDLE)
 		return;
+
+	if (!scan->wifi) {
+		ret = wifi_manager_initialize(&scan->wifi);
+		if (ret) {
+			_E("failed to wifi_manager_initialize - %x", ret);
+			scan->wifi = NULL;
+			wifi_scan_complete(scan, FALSE);
+			return;
+		}
 	}
 
-	data = g_try_new0(struct wifi_data, 1);
-	if (!data) {
-		_E("failed to alloc wifi data");
-		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+	ret = wifi_manager_is_activated(scan->wifi, &activated);
+	if (ret) {
+		_E("failed to wifi_manager_is_activated - %x", ret);
+		wifi_scan_complete(scan, FALSE);
 		return;
 	}
 
-	ret = wifi_manager_initialize(&wifi);
+	scan->activated_by_scan = !activated;
+	if (activated) {
+		scan->state = WIFI_SCAN_SCANNING;
+		ret = wifi_manager_scan(scan->wifi, wifi_scan_finished_cb, scan);
+	} else {
+		scan->state = WIFI_SCAN_ACTIVATING;
+		ret = wifi_manager_activate(scan->wifi, wifi_activated_cb, scan);
+	}
+
 	if (ret) {
-		_E("failed to wifi_manager_initialize");
-		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
-		g_free(data);
+		_E("failed to wifi_manager scan or activate [%d] - %x", activated, ret);
+		scan->state = WIFI_SCAN_IDLE;
+		wifi_scan_complete(scan, FALSE);
+	}
+}
+
+/* keeps the result fresh while someone looks, never turns the radio on */
+static gboolean wifi_scan_refresh_cb(gpointer user_data)
+{
+	struct wifi_scan *scan = user_data;
+	bool activated = false;
+
+	if (g_get_monotonic_time() - scan->last_request_time
+		> (gint64)WIFI_SCAN_REFRESH_IDLE_STOP * G_USEC_PER_SEC) {
+		scan->refresh_timer = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	if (scan->state == WIFI_SCAN_IDLE && scan->wifi
+		&& !wifi_manager_is_activated(scan->wifi, &activated) && activated)
+		wifi_scan_start(scan);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gint64 query_get_max_age(GHashTable *query)
+{
+	const char *str = NULL;
+	char *end = NULL;
+	gint64 max_age = 0;
+
+	str = query ? g_hash_table_lookup(query, "maxAge") : NULL;
+	if (!str || !g_ascii_isdigit(str[0]))
+		return WIFI_SCAN_MAX_AGE;
+
+	max_age = g_ascii_strtoll(str, &end, 10);
+	if (*end)
+		return WIFI_SCAN_MAX_AGE;
+
+	return max_age;
+}
+
+/*
+ * ?maxAge=sec takes a result up to that old without scanning,
+ * ?stale=1 takes any result now and lets a scan refresh it afterwards.
+ */
+void handle_connection_wifi(SoupMessage *msg, GHashTable *query)
+{
+	struct wifi_scan *scan = &g_scan;
+	const char *stale = NULL;
+	gint64 max_age = 0;
+
+	scan->last_request_time = g_get_monotonic_time();
+	if (!scan->refresh_timer)
+		scan->refresh_timer = g_timeout_add_seconds(WIFI_SCAN_REFRESH_INTERVAL,
+					wifi_scan_refresh_cb, scan);
+
+	max_age = query_get_max_age(query);
+	stale = query ? g_hash_table_lookup(query, "stale") : NULL;
+
+	if (scan->result && wifi_scan_result_age(scan) <= max_age) {
+		wifi_scan_respond(scan, msg);
 		return;
 	}
 
-	ret = wifi_manager_is_activated(wifi, &activated);
-	if (ret) {
-		_E("failed to wifi_manager_is_activated");
-		goto ERROR;
+	if (scan->result && stale && !g_strcmp0(stale, "1")) {
+		wifi_scan_respond(scan, msg);
+		wifi_scan_start(scan);
+		return;
 	}
 
-	data->msg = msg;
-	data->wifi = wifi;
-	data->activated = activated;
+	/* joins the scan in flight, or starts one */
+	wifi_scan_wait(scan, msg);
+	wifi_scan_start(scan);
+}
 
-	if (activated)
-		ret = wifi_manager_scan(wifi, wifi_scan_finished_cb, data);
-	else
-		ret = wifi_manager_activate(wifi, wifi_activated_cb, data);
+/* the server is going away, nothing may fire into g_scan after this */
+void handle_connection_wifi_fini(void)
+{
+	struct wifi_scan *scan = &g_scan;
 
+	if (scan->refresh_timer) {
+		g_source_remove(scan->refresh_timer);
+		scan->refresh_timer = 0;
+	}
 
-	if (ret) {
-		_E("failed to wifi_manager scan or activate [%d] - %x", activated, ret);
-		goto ERROR;
+	/* drops the callbacks of a scan or radio change in flight */
+	if (scan->wifi) {
+		wifi_manager_deinitialize(scan->wifi);
+		scan->wifi = NULL;
 	}
+	scan->state = WIFI_SCAN_IDLE;
+	scan->activated_by_scan = FALSE;
 
-	http_server_pause_message(msg);
+	wifi_scan_complete(scan, FALSE);
 
-	return;
-ERROR:
-	soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
-	wifi_manager_deinitialize(wifi);
-	g_free(data);
+	if (scan->result) {
+		soup_buffer_free(scan->result);
+		scan->result = NULL;
+	}
 }
@@ -17,11 +17,16 @@
 #include <glib.h>
 #include <libsoup/soup.h>
 #include <net_connection.h>
+#include <wifi-manager.h>
+#include <bluetooth.h>
 #include "http-server-log-private.h"
 #include "http-server-route.h"
+#include "http-server-common.h"
+#include "hs-route-api-connection.h"
+#include "hs-util-json.h"
+#include "hs-route-api-ws.h"
 
 #define API_CONNECTION "/api/connection"
-#define API_CONNECTION_LEN sizeof(API_CONNECTION)
 
 
 
@@ -32,150 +37,210 @@
 //declare sub modules
 #define API_SUB_WIFI "wifiScan"
 extern void handle_connection_wifi(SoupMessage *msg, GHashTable *query);
+extern void handle_connection_wifi_fini(void);
 
 
-static const char *get_connection_type(connection_h connection)
-{
-	connection_type_e type = CONNECTION_TYPE_DISCONNECTED;
-	const char *conn_type = NULL;
-
-	retv_if(!connection, "unknown");
+/* all four states in one int, so the handler reads them without a lock */
+#define CONN_STATE_KNOWN (1 << 30)
+#define CONN_STATE_PACK(type, wifi, eth, bt) \
+	(CONN_STATE_KNOWN | ((type) & 0xff) | (((wifi) & 0xff) << 8) \
+	| (((eth) & 0xff) << 16) | (((bt) & 0x3f) << 24))
+#define CONN_STATE_TYPE(state) ((state) & 0xff)
+#define CONN_STATE_WIFI(state) (((state) >> 8) & 0xff)
+#define CONN_STATE_ETHERNET(state) (((state) >> 16) & 0xff)
+#define CONN_STATE_BT(state) (((state) >> 24) & 0x3f)
 
-	connection_get_type(connection, &type);
+static connection_h g_connection = NULL;
+static gint g_conn_state = 0;
+static wifi_manager_h g_wifi = NULL; /* only to watch the radio */
+static gboolean g_bt_watched = FALSE;
 
+static const char *connection_type_to_string(connection_type_e type)
+{
 	switch (type) {
 	case CONNECTION_TYPE_DISCONNECTED:
-		conn_type = DISCONNECTED_STR;
-		break;
+		return DISCONNECTED_STR;
 	case CONNECTION_TYPE_WIFI:
-		conn_type = "wifi";
-		break;
+		return "wifi";
 	case CONNECTION_TYPE_CELLULAR:
-		conn_type = "cellular";
-		break;
+		return "cellular";
 	case CONNECTION_TYPE_ETHERNET:
-		conn_type = "ethernet";
-		break;
+		return "ethernet";
 	case CONNECTION_TYPE_BT:
-		conn_type = "bluetooth";
-		break;
+		return "bluetooth";
 	case CONNECTION_TYPE_NET_PROXY:
-		conn_type = "net proxy";
-		break;
+		return "net proxy";
 	default:
-		conn_type = "unknown";
-		break;
+		return "unknown";
 	}
-
-	return conn_type;
 }
 
-static const char *get_wifi_state(connection_h connection)
+/* wifi, ethernet and bt states share the same three values */
+static const char *connection_state_to_string(int state)
 {
-	connection_wifi_state_e wifi_state = CONNECTION_WIFI_STATE_DEACTIVATED;
-	const char *wifi = NULL;
-
-	retv_if(!connection, "unknown");
-	connection_get_wifi_state(connection, &wifi_state);
-
-	switch (wifi_state) {
+	switch (state) {
 	case CONNECTION_WIFI_STATE_DEACTIVATED:
-		wifi = DEACTIVATED_STR;
-		break;
+		return DEACTIVATED_STR;
 	case CONNECTION_WIFI_STATE_DISCONNECTED:
-		wifi = DISCONNECTED_STR;
-		break;
+		return DISCONNECTED_STR;
 	case CONNECTION_WIFI_STATE_CONNECTED:
-		wifi = CONNECTED_STR;
+		return CONNECTED_STR;
+	default:
+		return "unknown";
 	}
+}
 
-	return wifi;
+static char *connection_info_build(gint state, gsize *len)
+{
+	util_json_writer *writer = NULL;
+	gint64 handover = http_server_handover_time_to_serve();
+
+	writer = util_json_writer_new(0);
+	util_json_begin_object(writer, NULL);
+	util_json_add_str(writer, "connection_type",
+			connection_type_to_string(CONN_STATE_TYPE(state)));
+	util_json_add_str(writer, "wifi",
+			connection_state_to_string(CONN_STATE_WIFI(state)));
+	util_json_add_str(writer, "ethernet",
+			connection_state_to_string(CONN_STATE_ETHERNET(state)));
+	util_json_add_str(writer, "bluetooth",
+			connection_state_to_string(CONN_STATE_BT(state)));
+	util_json_add_int(writer, "handover_time_to_serve_ms",
+			handover < 0 ? handover : handover / 1000);
+	util_json_end_object(writer);
+
+	return util_json_writer_free_to_str(writer, len);
 }
 
-static const char *get_ethernet_state(connection_h connection)
+void hs_route_api_connection_refresh(void)
 {
-	connection_ethernet_state_e eth_state = CONNECTION_ETHERNET_STATE_DEACTIVATED;
-	const char *ethernet = NULL;
+	connection_type_e type = CONNECTION_TYPE_DISCONNECTED;
+	connection_wifi_state_e wifi = CONNECTION_WIFI_STATE_DEACTIVATED;
+	connection_ethernet_state_e eth = CONNECTION_ETHERNET_STATE_DEACTIVATED;
+	connection_bt_state_e bt = CONNECTION_BT_STATE_DEACTIVATED;
+	gint state = 0;
+	char *info = NULL;
 
-	retv_if(!connection, "unknown");
-	connection_get_ethernet_state(connection, &eth_state);
+	ret_if(!g_connection);
 
-	switch (eth_state) {
-	case CONNECTION_ETHERNET_STATE_DEACTIVATED:
-		ethernet = DEACTIVATED_STR;
-		break;
-	case CONNECTION_ETHERNET_STATE_DISCONNECTED:
-		ethernet = DISCONNECTED_STR;
-		break;
-	case CONNECTION_ETHERNET_STATE_CONNECTED:
-		ethernet = CONNECTED_STR;
-	}
+	connection_get_type(g_connection, &type);
+	connection_get_wifi_state(g_connection, &wifi);
+	connection_get_ethernet_state(g_connection, &eth);
+	connection_get_bt_state(g_connection, &bt);
+
+	state = CONN_STATE_PACK(type, wifi, eth, bt);
+	if (state == g_atomic_int_get(&g_conn_state))
+		return;
+
+	_D("connection state - type[%d] wifi[%d] ethernet[%d] bt[%d]",
+		type, wifi, eth, bt);
+	g_atomic_int_set(&g_conn_state, state);
 
-	return ethernet;
+	info = connection_info_build(state, NULL);
+	if (info)
+		hs_route_api_ws_publish(WS_TOPIC_CONNECTION, info, NULL);
+	g_free(info);
 }
 
-static const char *get_bt_state(connection_h connection)
+static void conn_cable_state_changed_cb(
+	connection_ethernet_cable_state_e cable_state, void *user_data)
 {
-	connection_bt_state_e bt_state = CONNECTION_BT_STATE_DEACTIVATED;
-	const char *bt = NULL;
+	hs_route_api_connection_refresh();
+}
 
-	retv_if(!connection, "unknown");
-	connection_get_bt_state(connection, &bt_state);
+static void conn_address_changed_cb(const char *ipv4_address,
+	const char *ipv6_address, void *user_data)
+{
+	hs_route_api_connection_refresh();
+}
+
+/* the type changes only with the default network, these do not */
+static void conn_wifi_device_state_changed_cb(
+	wifi_manager_device_state_e state, void *user_data)
+{
+	hs_route_api_connection_refresh();
+}
+
+static void conn_wifi_connection_state_changed_cb(
+	wifi_manager_connection_state_e state, wifi_manager_ap_h ap, void *user_data)
+{
+	hs_route_api_connection_refresh();
+}
+
+static void conn_bt_state_changed_cb(int result,
+	bt_adapter_state_e adapter_state, void *user_data)
+{
+	hs_route_api_connection_refresh();
+}
 
-	switch (bt_state) {
-	case CONNECTION_BT_STATE_DEACTIVATED:
-		bt = DEACTIVATED_STR;
-		break;
-	case CONNECTION_BT_STATE_DISCONNECTED:
-		bt = DISCONNECTED_STR;
-		break;
-	case CONNECTION_BT_STATE_CONNECTED:
-		bt = CONNECTED_STR;
+static void conn_wifi_watch(void)
+{
+	if (wifi_manager_initialize(&g_wifi)) {
+		_W("failed to watch wifi state");
+		g_wifi = NULL;
+		return;
 	}
 
-	return bt;
+	if (wifi_manager_set_device_state_changed_cb(g_wifi,
+			conn_wifi_device_state_changed_cb, NULL))
+		_W("failed to watch wifi device state");
+
+	if (wifi_manager_set_connection_state_changed_cb(g_wifi,
+			conn_wifi_connection_state_changed_cb, NULL))
+		_W("failed to watch wifi connection state");
 }
 
-static void
-handle_sub_path(SoupMessage *msg, const char *sub_path, GHashTable *query)
+static void conn_wifi_unwatch(void)
 {
-	_D("sub path : %s", sub_path);
-	if (0 == g_strcmp0(sub_path, API_SUB_WIFI))
-		handle_connection_wifi(msg, query);
-	else
-		soup_message_set_status(msg, SOUP_STATUS_BAD_REQUEST);
+	if (!g_wifi)
+		return;
+
+	wifi_manager_unset_device_state_changed_cb(g_wifi);
+	wifi_manager_unset_connection_state_changed_cb(g_wifi);
+	wifi_manager_deinitialize(g_wifi);
+	g_wifi = NULL;
 }
 
-static void handle_connection_info(SoupMessage *msg)
+static void conn_bt_watch(void)
 {
-	connection_h connection = NULL;
-	SoupBuffer *buffer;
-	char *response_msg = NULL;
+	if (bt_initialize()) {
+		_W("failed to watch bluetooth state");
+		return;
+	}
 
-	if (msg->method != SOUP_METHOD_GET) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
+	if (bt_adapter_set_state_changed_cb(conn_bt_state_changed_cb, NULL)) {
+		_W("failed to watch bluetooth state");
+		bt_deinitialize();
 		return;
 	}
 
-	connection_create(&connection);
+	g_bt_watched = TRUE;
+}
 
-	response_msg = g_strdup_printf(
-				"{ \"connection_type\": \"%s\", "
-				"\"wifi\": \"%s\", "
-				"\"ethernet\": \"%s\", "
-				"\"bluetooth\": \"%s\" }",
-				get_connection_type(connection),
-				get_wifi_state(connection),
-				get_ethernet_state(connection),
-				get_bt_state(connection));
+static void conn_bt_unwatch(void)
+{
+	if (!g_bt_watched)
+		return;
 
-	connection_destroy(connection);
-	connection = NULL;
+	bt_adapter_unset_state_changed_cb();
+	bt_deinitialize();
+	g_bt_watched = FALSE;
+}
 
-	buffer = soup_buffer_new_with_owner(response_msg, strlen(response_msg),
-					response_msg, (GDestroyNotify)g_free);
-	soup_message_body_append_buffer(msg->response_body, buffer);
-	soup_buffer_free(buffer);
+static void handle_connection_info(SoupMessage *msg)
+{
+	char *response_msg = NULL;
+	gsize resp_msg_size = 0;
+	gint state = g_atomic_int_get(&g_conn_state);
+
+	if (!(state & CONN_STATE_KNOWN)) {
+		soup_message_set_status(msg, SOUP_STATUS_SERVICE_UNAVAILABLE);
+		return;
+	}
+
+	response_msg = connection_info_build(state, &resp_msg_size);
+	soup_message_body_append(msg->response_body, SOUP_MEMORY_TAKE,
+					response_msg, resp_msg_size);
 
 	soup_message_headers_set_content_type(
 						msg->response_headers, "application/json", NULL);
@@ -187,20 +252,60 @@ static void route_api_connection_callback(SoupMessage *msg,
 					const char *path, GHashTable *query,
 					SoupClientContext *client, gpointer user_data)
 {
-	if (strlen(path) <= API_CONNECTION_LEN) {
-		handle_connection_info(msg);
-	} else {
-		const char *sub_path = path + API_CONNECTION_LEN;
-		handle_sub_path(msg, sub_path, query);
-	}
+	handle_connection_info(msg);
 }
 
-int hs_route_api_connection_init(void)
+static void route_api_connection_wifi_callback(SoupMessage *msg,
+					const char *path, GHashTable *query,
+					SoupClientContext *client, gpointer user_data)
+{
+	handle_connection_wifi(msg, query);
+}
+
+int hs_route_api_connection_init(connection_h connection)
 {
 	int ret = 0;
 
-	ret = http_server_route_handler_add(API_CONNECTION,
+	retv_if(!connection, -1);
+
+	g_connection = connection;
+	hs_route_api_connection_refresh();
+
+	/* the type changed callback belongs to the app, it calls refresh */
+	if (connection_set_ethernet_cable_state_changed_cb(connection,
+			conn_cable_state_changed_cb, NULL))
+		_W("failed to watch ethernet cable state");
+
+	if (connection_set_ip_address_changed_cb(connection,
+			conn_address_changed_cb, NULL))
+		_W("failed to watch ip address");
+
+	/* a radio that is not the default network changes without a type change */
+	conn_wifi_watch();
+	conn_bt_watch();
+
+	ret = http_server_route_add(SOUP_METHOD_GET, API_CONNECTION,
 				route_api_connection_callback, NULL, NULL);
+	retv_if(ret, ret);
+
+	ret = http_server_route_add(SOUP_METHOD_GET, API_CONNECTION "/" API_SUB_WIFI,
+				route_api_connection_wifi_callback, NULL, NULL);
 
 	return ret;
 }
+
+void hs_route_api_connection_fini(void)
+{
+	handle_connection_wifi_fini();
+
+	conn_wifi_unwatch();
+	conn_bt_unwatch();
+
+	if (!g_connection)
+		return;
+
+	connection_unset_ethernet_cable_state_changed_cb(g_connection);
+	connection_unset_ip_address_changed_cb(g_connection);
+	g_connection = NULL;
+	g_atomic_int_set(&g_conn_state, 0);
+}
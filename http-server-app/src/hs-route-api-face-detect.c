@@ -16,75 +16,354 @@
 
 #include <glib.h>
 #include <libsoup/soup.h>
-#include <json-glib/json-glib.h>
-#include <system_info.h>
-#include <stdio.h>
+#include <string.h>
 #include "app.h"
 #include "http-server-log-private.h"
 #include "http-server-route.h"
 #include "hs-util-json.h"
+#include "hs-route-api-face-detect.h"
+#include "hs-route-api-ws.h"
 
-#define SIZE 1024
+#define FACE_STREAM_QUEUE_MAX 8 /* events a slow client may fall behind */
+#define FACE_STREAM_KEEPALIVE 15 /* sec */
+#define FACE_STREAM_RETRY 3000 /* msec, EventSource reconnect delay */
 
-static void route_api_face_detect_callback(SoupMessage *msg,
-					const char *path, GHashTable *query,
-					SoupClientContext *client, gpointer user_data)
+struct face_result {
+	int camera; /* device the face was seen on */
+	int label;
+	int confidence; /* hundredths, as the JSON shows it */
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+struct face_stream_client {
+	SoupMessage *msg;
+	GQueue queue; /* SoupBuffer, waiting for the chunk in flight */
+	gboolean writing; /* a chunk is appended and not written yet */
+	guint dropped;
+	gulong wrote_chunk_handler;
+	gulong finished_handler;
+};
+
+/*
+ * The last result serialized once, as a plain body for /api/faceDetect
+ * and as an event for every /api/faceDetect/stream client.
+ */
+struct face_stream {
+	struct face_result last;
+	SoupBuffer *json;
+	SoupBuffer *event;
+	guint64 event_id;
+	GList *clients; /* face_stream_client */
+	guint keepalive_timer;
+};
+
+static struct face_stream g_face;
+
+static void face_result_from_app(app_data *ad, struct face_result *result)
+{
+	memset(result, 0, sizeof(*result));
+	result->camera = ad->recognize_camera;
+	result->label = ad->recognize_label;
+	result->confidence = (int)(ad->recognize_percent * 100.0 + 0.5);
+	result->x = ad->recognize_x;
+	result->y = ad->recognize_y;
+	result->width = ad->recognize_width;
+	result->height = ad->recognize_height;
+}
+
+static void face_json_add_int_str(util_json_writer *writer,
+		const char *name, int value)
+{
+	char num[16];
+
+	g_snprintf(num, sizeof(num), "%d", value);
+	util_json_add_str(writer, name, num);
+}
+
+static char *face_result_to_json(const struct face_result *result, gsize *len)
+{
+	util_json_writer *writer = NULL;
+	char confidence[16];
+
+	writer = util_json_writer_new(0);
+	util_json_begin_object(writer, NULL);
+	face_json_add_int_str(writer, "Camera", result->camera);
+	util_json_add_str(writer, "Label",
+			result->label == 1 ? "Han Min Su" : "Guest");
+	g_snprintf(confidence, sizeof(confidence), "%d.%02d",
+			result->confidence / 100, result->confidence % 100);
+	util_json_add_str(writer, "Confidence", confidence);
+	face_json_add_int_str(writer, "X", result->x);
+	face_json_add_int_str(writer, "Y", result->y);
+	face_json_add_int_str(writer, "Width", result->width);
+	face_json_add_int_str(writer, "Height", result->height);
+	util_json_end_object(writer);
+
+	return util_json_writer_free_to_str(writer, len);
+}
+
+static void face_stream_publish(const struct face_result *result)
 {
-	app_data *ad = user_data;
-	bool bool_val = false;
-	char *response_msg = NULL;
-	char temp_str[SIZE] = {0, };
-	gsize resp_msg_size = 0;
-	JsonBuilder *builder = NULL;
+	char *json = NULL;
+	char *event = NULL;
+	gsize len = 0;
 
-	ret_if(!ad);
+	json = face_result_to_json(result, &len);
+	ret_if(!json);
 
-	if (msg->method != SOUP_METHOD_GET) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
+	event = g_strdup_printf("id: %" G_GUINT64_FORMAT "\ndata: %s\n\n",
+			++g_face.event_id, json);
+	hs_route_api_ws_publish(WS_TOPIC_FACE, json, NULL);
+
+	if (g_face.json)
+		soup_buffer_free(g_face.json);
+	g_face.json = soup_buffer_new(SOUP_MEMORY_TAKE, json, len);
+
+	if (g_face.event)
+		soup_buffer_free(g_face.event);
+	g_face.event = soup_buffer_new(SOUP_MEMORY_TAKE, event, strlen(event));
+
+	g_face.last = *result;
+}
+
+/* appending only takes a reference, every client shares the buffer */
+static void face_stream_client_write(struct face_stream_client *client,
+		SoupBuffer *buffer)
+{
+	soup_message_body_append_buffer(client->msg->response_body, buffer);
+	client->writing = TRUE;
+	http_server_unpause_message(client->msg);
+}
+
+/*
+ * One chunk in flight per client, the rest waits in a bounded queue.
+ * Each event carries the whole state, so a client that falls behind
+ * loses the oldest ones it has not received yet.
+ */
+static void face_stream_client_push(struct face_stream_client *client,
+		SoupBuffer *buffer)
+{
+	if (!client->writing) {
+		face_stream_client_write(client, buffer);
+		return;
+	}
+
+	g_queue_push_tail(&client->queue, soup_buffer_copy(buffer));
+	if (g_queue_get_length(&client->queue) > FACE_STREAM_QUEUE_MAX) {
+		soup_buffer_free(g_queue_pop_head(&client->queue));
+		if (!client->dropped++)
+			_W("face stream client is behind, dropping events");
+	}
+}
+
+static void face_stream_wrote_chunk_cb(SoupMessage *msg, gpointer user_data)
+{
+	struct face_stream_client *client = user_data;
+	SoupBuffer *buffer = NULL;
+
+	client->writing = FALSE;
+
+	buffer = g_queue_pop_head(&client->queue);
+	if (!buffer)
 		return;
+
+	face_stream_client_write(client, buffer);
+	soup_buffer_free(buffer);
+}
+
+static void face_stream_client_free(struct face_stream_client *client)
+{
+	g_signal_handler_disconnect(client->msg, client->wrote_chunk_handler);
+	g_signal_handler_disconnect(client->msg, client->finished_handler);
+	g_queue_foreach(&client->queue, (GFunc)soup_buffer_free, NULL);
+	g_queue_clear(&client->queue);
+	g_object_unref(client->msg);
+	g_free(client);
+}
+
+static void face_stream_finished_cb(SoupMessage *msg, gpointer user_data)
+{
+	struct face_stream_client *client = user_data;
+
+	if (client->dropped)
+		_D("face stream client dropped %u events", client->dropped);
+
+	g_face.clients = g_list_remove(g_face.clients, client);
+	face_stream_client_free(client);
+
+	if (!g_face.clients && g_face.keepalive_timer) {
+		g_source_remove(g_face.keepalive_timer);
+		g_face.keepalive_timer = 0;
+	}
+}
+
+/* a comment line, keeps idle connections open and finds dead clients */
+static gboolean face_stream_keepalive_cb(gpointer user_data)
+{
+	static SoupBuffer *keepalive = NULL;
+	GList *l = NULL;
+
+	if (!keepalive)
+		keepalive = soup_buffer_new(SOUP_MEMORY_STATIC, ": keepalive\n\n", 13);
+
+	for (l = g_face.clients; l; l = l->next) {
+		struct face_stream_client *client = l->data;
+
+		if (!client->writing)
+			face_stream_client_write(client, keepalive);
 	}
 
-	builder = json_builder_new();
-	json_builder_begin_object(builder);
+	return G_SOURCE_CONTINUE;
+}
 
-	if (ad->recognize_label == 1)
-		snprintf(temp_str, SIZE - 1, "Han Min Su");
-	else
-		snprintf(temp_str, SIZE - 1, "Guest");
-	util_json_add_str(builder, "Label", temp_str);
+void hs_route_api_face_detect_notify(void *data)
+{
+	struct face_result result;
+	GList *l = NULL;
 
-	snprintf(temp_str, SIZE - 1, "%.2f", ad->recognize_percent);
-	util_json_add_str(builder, "Confidence", temp_str);
+	ret_if(!data);
 
-	snprintf(temp_str, SIZE - 1, "%d", ad->recognize_x);
-	util_json_add_str(builder, "X", temp_str);
+	face_result_from_app(data, &result);
+	if (g_face.json && !memcmp(&result, &g_face.last, sizeof(result)))
+		return;
 
-	snprintf(temp_str, SIZE - 1, "%d", ad->recognize_y);
-	util_json_add_str(builder, "Y", temp_str);
+	face_stream_publish(&result);
+	ret_if(!g_face.event);
 
-	snprintf(temp_str, SIZE - 1, "%d", ad->recognize_width);
-	util_json_add_str(builder, "Width", temp_str);
+	for (l = g_face.clients; l; l = l->next)
+		face_stream_client_push(l->data, g_face.event);
+}
 
-	snprintf(temp_str, SIZE - 1, "%d", ad->recognize_height);
-	util_json_add_str(builder, "Height", temp_str);
+/* ?camera=N, the last face of that camera instead of the last of any */
+static void route_api_face_detect_camera(SoupMessage *msg, app_data *ad,
+					const char *camera)
+{
+	face_recognize_result recognized;
+	struct face_result result;
+	char *end = NULL;
+	char *json = NULL;
+	gint64 device = 0;
+	gsize len = 0;
 
-	json_builder_end_object(builder);
+	device = g_ascii_strtoll(camera, &end, 10);
+	if (end == camera || *end || device < 0 || device >= APP_CAMERA_MAX
+			|| !ad->cameras[device]) {
+		soup_message_set_status(msg, SOUP_STATUS_NOT_FOUND);
+		return;
+	}
 
-	response_msg = util_json_generate_str(builder, &resp_msg_size);
-	g_clear_pointer(&builder, g_object_unref);
+	memset(&result, 0, sizeof(result));
+	result.camera = device;
+	if (usb_camera_get_result(ad->cameras[device], &recognized)) {
+		result.label = recognized.label;
+		result.confidence = (int)(recognized.confidence * 100.0 + 0.5);
+		result.x = recognized.x;
+		result.y = recognized.y;
+		result.width = recognized.width;
+		result.height = recognized.height;
+	}
 
-	soup_message_body_append(msg->response_body, SOUP_MEMORY_COPY,
-					response_msg, resp_msg_size);
-	g_clear_pointer(&response_msg, g_free);
+	json = face_result_to_json(&result, &len);
+	if (!json) {
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		return;
+	}
 
+	soup_message_body_append_take(msg->response_body, (guchar *)json, len);
 	soup_message_headers_set_content_type(
 						msg->response_headers, "application/json", NULL);
 
 	soup_message_set_status(msg, SOUP_STATUS_OK);
 }
 
+static void route_api_face_detect_callback(SoupMessage *msg,
+					const char *path, GHashTable *query,
+					SoupClientContext *client, gpointer user_data)
+{
+	const char *camera = query ? g_hash_table_lookup(query, "camera") : NULL;
+
+	if (camera) {
+		route_api_face_detect_camera(msg, user_data, camera);
+		return;
+	}
+
+	if (!g_face.json) {
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		return;
+	}
+
+	soup_message_body_append_buffer(msg->response_body, g_face.json);
+	soup_message_headers_set_content_type(
+						msg->response_headers, "application/json", NULL);
+
+	soup_message_set_status(msg, SOUP_STATUS_OK);
+}
+
+/* text/event-stream, an event each time the recognition result changes */
+static void route_api_face_detect_stream_callback(SoupMessage *msg,
+					const char *path, GHashTable *query,
+					SoupClientContext *client, gpointer user_data)
+{
+	struct face_stream_client *stream_client = NULL;
+	SoupBuffer *buffer = NULL;
+	char *retry = NULL;
+
+	soup_message_headers_set_content_type(
+						msg->response_headers, "text/event-stream", NULL);
+	soup_message_headers_replace(msg->response_headers,
+			"Cache-Control", "no-cache");
+	soup_message_set_status(msg, SOUP_STATUS_OK);
+
+	if (msg->method == SOUP_METHOD_HEAD)
+		return;
+
+	soup_message_headers_set_encoding(msg->response_headers,
+			SOUP_ENCODING_CHUNKED);
+	soup_message_body_set_accumulate(msg->response_body, FALSE);
+
+	stream_client = g_new0(struct face_stream_client, 1);
+	stream_client->msg = g_object_ref(msg);
+	g_queue_init(&stream_client->queue);
+	stream_client->wrote_chunk_handler = g_signal_connect(msg, "wrote_chunk",
+			G_CALLBACK(face_stream_wrote_chunk_cb), stream_client);
+	stream_client->finished_handler = g_signal_connect(msg, "finished",
+			G_CALLBACK(face_stream_finished_cb), stream_client);
+	g_face.clients = g_list_prepend(g_face.clients, stream_client);
+
+	if (!g_face.keepalive_timer)
+		g_face.keepalive_timer = g_timeout_add_seconds(FACE_STREAM_KEEPALIVE,
+				face_stream_keepalive_cb, NULL);
+
+	/*
+	 * The server pauses a chunked message by itself once it has written
+	 * every appended chunk, face_stream_client_write() unpauses it.
+	 * The current result goes first, the client has nothing to show yet.
+	 */
+	retry = g_strdup_printf("retry: %d\n\n", FACE_STREAM_RETRY);
+	buffer = soup_buffer_new(SOUP_MEMORY_TAKE, retry, strlen(retry));
+	face_stream_client_write(stream_client, buffer);
+	soup_buffer_free(buffer);
+
+	if (g_face.event)
+		face_stream_client_push(stream_client, g_face.event);
+}
+
 int hs_route_api_face_detect_init(void *data)
 {
-	return http_server_route_handler_add("/api/faceDetect",
+	int ret = 0;
+
+	retv_if(!data, -1);
+
+	face_result_from_app(data, &g_face.last);
+	face_stream_publish(&g_face.last);
+
+	ret = http_server_route_add(SOUP_METHOD_GET, "/api/faceDetect",
 			route_api_face_detect_callback, data, NULL);
+	retv_if(ret, ret);
+
+	return http_server_route_add(SOUP_METHOD_GET, "/api/faceDetect/stream",
+			route_api_face_detect_stream_callback, NULL, NULL);
 }
@@ -52,11 +52,6 @@ static void route_api_image_upload_callback(SoupMessage *msg,
 	SoupBuffer *buffer = NULL;
 	GHashTable *part_hash = NULL;
 
-	if (msg->method != SOUP_METHOD_POST) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
-		return;
-	}
-
 	part_hash = soup_form_decode_multipart(msg, "imageFile",
 						&filename, &type, &buffer);
 
@@ -77,7 +72,7 @@ int hs_route_api_image_upload_init(void)
 {
 	int ret = 0;
 
-	ret = http_server_route_handler_add("/api/imageUpload",
+	ret = http_server_route_add(SOUP_METHOD_POST, "/api/imageUpload",
 				route_api_image_upload_callback, NULL, NULL);
 
 	return ret;
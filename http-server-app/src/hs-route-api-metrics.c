@@ -0,0 +1,47 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <libsoup/soup.h>
+#include "http-server-log-private.h"
+#include "http-server-route.h"
+#include "http-server-common.h"
+
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4"
+
+static void route_api_metrics_callback(SoupMessage *msg,
+					const char *path, GHashTable *query,
+					SoupClientContext *client, gpointer user_data)
+{
+	char *response_msg = NULL;
+
+	response_msg = http_server_metrics_dump();
+	if (!response_msg) {
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		return;
+	}
+
+	soup_message_set_response(msg, METRICS_CONTENT_TYPE, SOUP_MEMORY_TAKE,
+				response_msg, strlen(response_msg));
+	soup_message_set_status(msg, SOUP_STATUS_OK);
+}
+
+int hs_route_api_metrics_init(void)
+{
+	return http_server_route_add(SOUP_METHOD_GET, "/api/metrics",
+				route_api_metrics_callback, NULL, NULL);
+}
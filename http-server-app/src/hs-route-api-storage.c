@@ -16,11 +16,93 @@
 
 #include <glib.h>
 #include <libsoup/soup.h>
-#include <json-glib/json-glib.h>
 #include <storage.h>
 #include "http-server-log-private.h"
 #include "http-server-route.h"
 #include "hs-util-json.h"
+#include "hs-route-api-ws.h"
+
+#define STORAGE_CACHE_KEY "storage"
+#define STORAGE_REFRESH_INTERVAL 30 /* sec */
+#define STORAGE_HISTORY_MAX 120 /* samples, an hour at the refresh interval */
+#define STORAGE_SAMPLE_DEVICE_MAX 4
+
+struct storage_device {
+	int id;
+	storage_type_e type;
+	storage_state_e state;
+	char *path;
+	gint64 total_kb;
+	gint64 avail_kb;
+};
+
+struct storage_sample {
+	gint64 time; /* sec since the epoch */
+	guint n_devices;
+	struct {
+		int id;
+		gint64 avail_kb;
+	} devices[STORAGE_SAMPLE_DEVICE_MAX];
+};
+
+/* owned by the server's main context, a refresh job only builds a new list */
+struct storage_info {
+	gint ref_count;
+	GMainContext *context;
+	GThreadPool *refresh_pool;
+	guint refresh_timer;
+	gboolean watching;
+	gboolean refresh_running;
+	gboolean refresh_pending;
+
+	GArray *devices; /* storage_device, NULL until the first refresh */
+	struct storage_sample history[STORAGE_HISTORY_MAX];
+	guint history_head; /* next sample to write */
+	guint history_len;
+};
+
+struct storage_refresh_job {
+	struct storage_info *info;
+	GArray *devices; /* NULL if the query failed */
+};
+
+static void storage_changed_cb(int storage_id, storage_dev_e dev,
+			storage_state_e state, const char *fstype, const char *fsuuid,
+			const char *mountpath, bool primary, int flags, void *user_data);
+
+static struct storage_info *storage_info_ref(struct storage_info *info)
+{
+	g_atomic_int_inc(&info->ref_count);
+
+	return info;
+}
+
+static void storage_info_unref(gpointer data)
+{
+	struct storage_info *info = data;
+
+	if (!info || !g_atomic_int_dec_and_test(&info->ref_count))
+		return;
+
+	if (info->watching)
+		storage_unset_changed_cb(STORAGE_TYPE_EXTERNAL, storage_changed_cb);
+	if (info->refresh_timer)
+		g_source_remove(info->refresh_timer);
+	/* the last reference is never dropped by a job, so this cannot wait on itself */
+	if (info->refresh_pool)
+		g_thread_pool_free(info->refresh_pool, TRUE, TRUE);
+	if (info->devices)
+		g_array_unref(info->devices);
+	g_main_context_unref(info->context);
+	g_free(info);
+}
+
+static void storage_device_clear(gpointer data)
+{
+	struct storage_device *device = data;
+
+	g_free(device->path);
+}
 
 static const char *storage_type_to_str(storage_type_e type)
 {
@@ -70,81 +152,396 @@ static const char *storage_state_to_str(storage_state_e state)
 static bool storage_device_callback(int storage_id, storage_type_e type,
 					storage_state_e state, const char *path, void *user_data)
 {
-	JsonBuilder *builder = user_data;
+	GArray *devices = user_data;
+	struct storage_device device = { 0, };
 	unsigned long long total = 0;
 	unsigned long long avail = 0;
-	gint64 total_kb = 0;
-	gint64 avail_kb = 0;
 
-	retv_if(!builder, false);
+	retv_if(!devices, false);
 
-	json_builder_begin_object(builder);
-
-	util_json_add_int(builder, "id", storage_id);
-	util_json_add_str(builder, "type", storage_type_to_str(type));
-	util_json_add_str(builder, "state", storage_state_to_str(state));
-	util_json_add_str(builder, "path", path);
+	device.id = storage_id;
+	device.type = type;
+	device.state = state;
+	device.path = g_strdup(path);
 
+	/* may block on a slow card, which is why this runs off the main context */
 	storage_get_total_space(storage_id, &total);
 	if (total > 0)
-		total_kb = total / 1024;
-	util_json_add_int(builder, "totalSpace", total_kb);
+		device.total_kb = total / 1024;
 
 	storage_get_available_space(storage_id, &avail);
 	if (avail > 0)
-		avail_kb = avail / 1024;
-	util_json_add_int(builder, "availSpace", avail_kb);
+		device.avail_kb = avail / 1024;
 
-	json_builder_end_object(builder);
+	g_array_append_val(devices, device);
 
 	return true;
 }
 
+static GArray *storage_devices_query(void)
+{
+	GArray *devices = NULL;
+	int ret = 0;
+
+	devices = g_array_new(FALSE, TRUE, sizeof(struct storage_device));
+	g_array_set_clear_func(devices, storage_device_clear);
+
+	ret = storage_foreach_device_supported(storage_device_callback, devices);
+	if (ret) {
+		_E("failed to get storage devices [%d]", ret);
+		g_array_unref(devices);
+		return NULL;
+	}
+
+	return devices;
+}
+
+static void storage_history_append(struct storage_info *info, GArray *devices)
+{
+	struct storage_sample *sample = &info->history[info->history_head];
+	guint i = 0;
+
+	sample->time = g_get_real_time() / G_USEC_PER_SEC;
+	sample->n_devices = MIN(devices->len, STORAGE_SAMPLE_DEVICE_MAX);
+	for (i = 0; i < sample->n_devices; i++) {
+		struct storage_device *device = &g_array_index(devices,
+					struct storage_device, i);
+
+		sample->devices[i].id = device->id;
+		sample->devices[i].avail_kb = device->avail_kb;
+	}
+
+	info->history_head = (info->history_head + 1) % STORAGE_HISTORY_MAX;
+	if (info->history_len < STORAGE_HISTORY_MAX)
+		info->history_len++;
+}
+
+static void storage_device_write(util_json_writer *writer,
+			const struct storage_device *device)
+{
+	util_json_begin_object(writer, NULL);
+	util_json_add_int(writer, "id", device->id);
+	util_json_add_str(writer, "type", storage_type_to_str(device->type));
+	util_json_add_str(writer, "state", storage_state_to_str(device->state));
+	util_json_add_str(writer, "path", device->path);
+	util_json_add_int(writer, "totalSpace", device->total_kb);
+	util_json_add_int(writer, "availSpace", device->avail_kb);
+	util_json_end_object(writer);
+}
+
+static const struct storage_device *storage_devices_find(GArray *devices, int id)
+{
+	guint i = 0;
+
+	for (i = 0; devices && i < devices->len; i++) {
+		const struct storage_device *device =
+			&g_array_index(devices, struct storage_device, i);
+
+		if (device->id == id)
+			return device;
+	}
+
+	return NULL;
+}
+
+static gboolean storage_device_equal(const struct storage_device *a,
+			const struct storage_device *b)
+{
+	return a->type == b->type && a->state == b->state
+		&& a->total_kb == b->total_kb && a->avail_kb == b->avail_kb
+		&& !g_strcmp0(a->path, b->path);
+}
+
+/*
+ * {"full": false, "changed": [device], "removed": [id]} from old to devices,
+ * old NULL gives the full list. NULL if nothing changed.
+ */
+static char *storage_delta_build(GArray *old, GArray *devices)
+{
+	util_json_writer *writer = NULL;
+	gboolean changed = !old;
+	guint i = 0;
+
+	writer = util_json_writer_new(0);
+	util_json_begin_object(writer, NULL);
+	util_json_add_bool(writer, "full", !old);
+
+	util_json_begin_array(writer, "changed");
+	for (i = 0; i < devices->len; i++) {
+		const struct storage_device *device =
+			&g_array_index(devices, struct storage_device, i);
+		const struct storage_device *prev = storage_devices_find(old, device->id);
+
+		if (old && prev && storage_device_equal(prev, device))
+			continue;
+
+		storage_device_write(writer, device);
+		changed = TRUE;
+	}
+	util_json_end_array(writer);
+
+	util_json_begin_array(writer, "removed");
+	for (i = 0; old && i < old->len; i++) {
+		const struct storage_device *prev =
+			&g_array_index(old, struct storage_device, i);
+
+		if (storage_devices_find(devices, prev->id))
+			continue;
+
+		util_json_add_int(writer, NULL, prev->id);
+		changed = TRUE;
+	}
+	util_json_end_array(writer);
+	util_json_end_object(writer);
+
+	if (!changed) {
+		g_free(util_json_writer_free_to_str(writer, NULL));
+		return NULL;
+	}
+
+	return util_json_writer_free_to_str(writer, NULL);
+}
+
+/* only what changed goes to the dashboard, the full list to new subscribers */
+static void storage_info_notify(GArray *old, GArray *devices)
+{
+	char *delta = NULL;
+	char *snapshot = NULL;
+
+	delta = storage_delta_build(old, devices);
+	if (!delta)
+		return;
+
+	snapshot = old ? storage_delta_build(NULL, devices) : NULL;
+	hs_route_api_ws_publish(WS_TOPIC_STORAGE, delta, snapshot);
+
+	g_free(snapshot);
+	g_free(delta);
+}
+
+static void storage_info_publish(struct storage_info *info, GArray *devices)
+{
+	storage_info_notify(info->devices, devices);
+
+	if (info->devices)
+		g_array_unref(info->devices);
+	info->devices = devices;
+
+	storage_history_append(info, devices);
+	http_server_route_cache_invalidate(STORAGE_CACHE_KEY);
+}
+
+static void storage_refresh_request(struct storage_info *info);
+
+static gboolean storage_refresh_done_cb(gpointer data)
+{
+	struct storage_refresh_job *job = data;
+	struct storage_info *info = job->info;
+
+	info->refresh_running = FALSE;
+
+	/* a failed query keeps the last devices rather than showing none */
+	if (job->devices)
+		storage_info_publish(info, job->devices);
+
+	if (info->refresh_pending) {
+		info->refresh_pending = FALSE;
+		storage_refresh_request(info);
+	}
+
+	storage_info_unref(info);
+	g_free(job);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void storage_refresh_run(gpointer data, gpointer pool_data)
+{
+	struct storage_refresh_job *job = data;
+	GSource *source = NULL;
+
+	job->devices = storage_devices_query();
+
+	source = g_idle_source_new();
+	g_source_set_callback(source, storage_refresh_done_cb, job, NULL);
+	g_source_attach(source, job->info->context);
+	g_source_unref(source);
+}
+
+/* coalesced, a request while one runs is served by one more run after it */
+static void storage_refresh_request(struct storage_info *info)
+{
+	struct storage_refresh_job *job = NULL;
+
+	if (info->refresh_running) {
+		info->refresh_pending = TRUE;
+		return;
+	}
+
+	job = g_new0(struct storage_refresh_job, 1);
+	job->info = storage_info_ref(info);
+
+	if (!g_thread_pool_push(info->refresh_pool, job, NULL)) {
+		_E("failed to push storage refresh");
+		storage_info_unref(info);
+		g_free(job);
+		return;
+	}
+	info->refresh_running = TRUE;
+}
+
+static gboolean storage_refresh_timer_cb(gpointer user_data)
+{
+	storage_refresh_request(user_data);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void storage_changed_cb(int storage_id, storage_dev_e dev,
+			storage_state_e state, const char *fstype, const char *fsuuid,
+			const char *mountpath, bool primary, int flags, void *user_data)
+{
+	_D("storage [%d] is changed, state [%s]", storage_id,
+		storage_state_to_str(state));
+
+	storage_refresh_request(user_data);
+}
+
 static void route_api_storage_callback(SoupMessage *msg,
 					const char *path, GHashTable *query,
 					SoupClientContext *client, gpointer user_data)
 {
-	int ret = 0;
+	struct storage_info *info = user_data;
 	char *response_msg = NULL;
 	gsize resp_msg_size = 0;
-	JsonBuilder *builder = NULL;
+	util_json_writer *writer = NULL;
+	guint i = 0;
 
-	if (msg->method != SOUP_METHOD_GET) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
+	if (!info->devices) {
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
 		return;
 	}
 
-	builder = json_builder_new();
-	json_builder_begin_object(builder);
-	json_builder_set_member_name(builder, "storageInfoList");
-	json_builder_begin_array(builder);
+	writer = util_json_writer_new(0);
+	util_json_begin_object(writer, NULL);
+	util_json_begin_array(writer, "storageInfoList");
 
+	for (i = 0; i < info->devices->len; i++) {
+		struct storage_device *device = &g_array_index(info->devices,
+					struct storage_device, i);
 
-	ret = storage_foreach_device_supported(storage_device_callback, builder);
-	if (ret) {
-		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
-		g_object_unref(builder);
-		return;
+		storage_device_write(writer, device);
 	}
 
-	json_builder_end_array(builder);
-	json_builder_end_object(builder);
+	util_json_end_array(writer);
+	util_json_end_object(writer);
+
+	response_msg = util_json_writer_free_to_str(writer, &resp_msg_size);
+
+	soup_message_set_response(msg, "application/json",
+			SOUP_MEMORY_TAKE, response_msg, resp_msg_size);
+	soup_message_set_status(msg, SOUP_STATUS_OK);
+}
+
+static void route_api_storage_history_callback(SoupMessage *msg,
+					const char *path, GHashTable *query,
+					SoupClientContext *client, gpointer user_data)
+{
+	struct storage_info *info = user_data;
+	char *response_msg = NULL;
+	gsize resp_msg_size = 0;
+	util_json_writer *writer = NULL;
+	guint first = 0;
+	guint i = 0;
+	guint j = 0;
+
+	writer = util_json_writer_new(STORAGE_HISTORY_MAX * 64);
+	util_json_begin_object(writer, NULL);
+	util_json_add_int(writer, "interval", STORAGE_REFRESH_INTERVAL);
+	util_json_begin_array(writer, "samples");
 
-	response_msg = util_json_generate_str(builder, &resp_msg_size);
-	g_clear_pointer(&builder, g_object_unref);
+	/* oldest first */
+	first = (info->history_head + STORAGE_HISTORY_MAX - info->history_len)
+			% STORAGE_HISTORY_MAX;
+	for (i = 0; i < info->history_len; i++) {
+		struct storage_sample *sample =
+			&info->history[(first + i) % STORAGE_HISTORY_MAX];
 
-	soup_message_body_append(msg->response_body, SOUP_MEMORY_COPY,
-					response_msg, resp_msg_size);
-	g_clear_pointer(&response_msg, g_free);
+		util_json_begin_object(writer, NULL);
+		util_json_add_int(writer, "time", sample->time);
+		util_json_begin_array(writer, "availSpace");
+		for (j = 0; j < sample->n_devices; j++) {
+			util_json_begin_object(writer, NULL);
+			util_json_add_int(writer, "id", sample->devices[j].id);
+			util_json_add_int(writer, "availSpace", sample->devices[j].avail_kb);
+			util_json_end_object(writer);
+		}
+		util_json_end_array(writer);
+		util_json_end_object(writer);
+	}
 
-	soup_message_headers_set_content_type(
-						msg->response_headers, "application/json", NULL);
+	util_json_end_array(writer);
+	util_json_end_object(writer);
 
+	response_msg = util_json_writer_free_to_str(writer, &resp_msg_size);
+
+	soup_message_set_response(msg, "application/json",
+			SOUP_MEMORY_TAKE, response_msg, resp_msg_size);
 	soup_message_set_status(msg, SOUP_STATUS_OK);
 }
 
 int hs_route_api_storage_init(void)
 {
-	return http_server_route_handler_add("/api/storage",
-				route_api_storage_callback, NULL, NULL);
+	struct storage_info *info = NULL;
+	GArray *devices = NULL;
+	int ret = 0;
+
+	info = g_new0(struct storage_info, 1);
+	info->ref_count = 1;
+	info->context = g_main_context_ref_thread_default();
+	info->refresh_pool = g_thread_pool_new(storage_refresh_run, NULL,
+				1, FALSE, NULL);
+	if (!info->refresh_pool) {
+		_E("failed to create storage refresh pool");
+		storage_info_unref(info);
+		return -1;
+	}
+
+	/* the server is not serving yet, blocking here stalls nobody */
+	devices = storage_devices_query();
+	if (devices)
+		storage_info_publish(info, devices);
+
+	/* SD card insertion, removal and mount changes */
+	ret = storage_set_changed_cb(STORAGE_TYPE_EXTERNAL, storage_changed_cb, info);
+	if (ret)
+		_W("failed to watch external storage [%d], refreshed by timer only", ret);
+	info->watching = !ret;
+
+	info->refresh_timer = g_timeout_add_seconds(STORAGE_REFRESH_INTERVAL,
+				storage_refresh_timer_cb, info);
+
+	/* served from the kept snapshot, cached until the next one */
+	ret = http_server_route_add_cached("/api/storage", 0, STORAGE_CACHE_KEY,
+				FALSE, route_api_storage_callback,
+				storage_info_ref(info), storage_info_unref);
+	if (ret) {
+		storage_info_unref(info);
+		goto ERROR;
+	}
+
+	ret = http_server_route_add_cached("/api/storage/history", 0, STORAGE_CACHE_KEY,
+				FALSE, route_api_storage_history_callback,
+				storage_info_ref(info), storage_info_unref);
+	if (ret) {
+		storage_info_unref(info);
+		http_server_route_remove(SOUP_METHOD_GET, "/api/storage");
+		goto ERROR;
+	}
+
+	ret = 0;
+
+ERROR:
+	storage_info_unref(info);
+	return ret;
 }
@@ -16,7 +16,6 @@
 
 #include <glib.h>
 #include <libsoup/soup.h>
-#include <json-glib/json-glib.h>
 #include <system_info.h>
 #include "http-server-log-private.h"
 #include "http-server-route.h"
@@ -34,80 +33,75 @@
 #define SYSINFO_DISPLAY "http://tizen.org/feature/display"
 
 
-static void route_api_sysinfo_callback(SoupMessage *msg,
-					const char *path, GHashTable *query,
-					SoupClientContext *client, gpointer user_data)
+static void sysinfo_worker(http_server_response *resp, gpointer user_data)
 {
 	bool bool_val = false;
 	char *str_val = NULL;
 	char *response_msg = NULL;
 	gsize resp_msg_size = 0;
-	JsonBuilder *builder = NULL;
+	util_json_writer *writer = NULL;
 
-	if (msg->method != SOUP_METHOD_GET) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
-		return;
-	}
-
-	builder = json_builder_new();
-	json_builder_begin_object(builder);
+	writer = util_json_writer_new(0);
+	util_json_begin_object(writer, NULL);
 
 	system_info_get_platform_string(SYSINFO_MANUFACTURER, &str_val);
-	util_json_add_str(builder, "manufacturer", str_val ? str_val : " ");
+	util_json_add_str(writer, "manufacturer", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_PROFILE, &str_val);
-	util_json_add_str(builder, "profile", str_val ? str_val : " ");
+	util_json_add_str(writer, "profile", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_PLATFORM_VERSION, &str_val);
-	util_json_add_str(builder, "platformVersion", str_val ? str_val : " ");
+	util_json_add_str(writer, "platformVersion", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_BUILD, &str_val);
-	util_json_add_str(builder, "build", str_val ? str_val : " ");
+	util_json_add_str(writer, "build", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_RELEASE, &str_val);
-	util_json_add_str(builder, "buildRelease", str_val ? str_val : " ");
+	util_json_add_str(writer, "buildRelease", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_BUILD_TYPE, &str_val);
-	util_json_add_str(builder, "buildType", str_val ? str_val : " ");
+	util_json_add_str(writer, "buildType", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_BUILD_DATE, &str_val);
-	util_json_add_str(builder, "buildDate", str_val ? str_val : " ");
+	util_json_add_str(writer, "buildDate", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_MODEL_NAME, &str_val);
-	util_json_add_str(builder, "modelName", str_val ? str_val : " ");
+	util_json_add_str(writer, "modelName", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_string(SYSINFO_PROCESSOR, &str_val);
-	util_json_add_str(builder, "processor", str_val ? str_val : " ");
+	util_json_add_str(writer, "processor", str_val ? str_val : " ");
 	g_clear_pointer(&str_val, g_free);
 
 	system_info_get_platform_bool(SYSINFO_DISPLAY, &bool_val);
-	util_json_add_str(builder, "display", bool_val ? "headed" : "headless");
+	util_json_add_str(writer, "display", bool_val ? "headed" : "headless");
 
-	json_builder_end_object(builder);
+	util_json_end_object(writer);
 
-	response_msg = util_json_generate_str(builder, &resp_msg_size);
-	g_clear_pointer(&builder, g_object_unref);
+	response_msg = util_json_writer_free_to_str(writer, &resp_msg_size);
 
-	soup_message_body_append(msg->response_body, SOUP_MEMORY_COPY,
+	http_server_response_take_body(resp, "application/json",
 					response_msg, resp_msg_size);
-	g_clear_pointer(&response_msg, g_free);
-
-	soup_message_headers_set_content_type(
-						msg->response_headers, "application/json", NULL);
+	http_server_response_set_status(resp, SOUP_STATUS_OK);
+}
 
-	soup_message_set_status(msg, SOUP_STATUS_OK);
+static void route_api_sysinfo_callback(SoupMessage *msg,
+					const char *path, GHashTable *query,
+					SoupClientContext *client, gpointer user_data)
+{
+	http_server_defer_to_worker(msg, sysinfo_worker, NULL, NULL);
 }
 
 int hs_route_api_sysinfo_init(void)
 {
-	return http_server_route_handler_add("/api/systemInfo",
-				route_api_sysinfo_callback, NULL, NULL);
+	/* platform info does not change while running */
+	return http_server_route_add_cached("/api/systemInfo", 0, NULL,
+				FALSE, route_api_sysinfo_callback, NULL, NULL);
 }
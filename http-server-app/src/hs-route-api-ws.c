@@ -0,0 +1,304 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <libsoup/soup.h>
+#include <json-glib/json-glib.h>
+#include "http-server-log-private.h"
+#include "http-server-route.h"
+#include "http-server-common.h"
+#include "hs-util-json.h"
+#include "hs-route-api-ws.h"
+
+#define WS_PATH "/api/ws"
+#define WS_KEEPALIVE 30 /* sec */
+#define WS_MESSAGE_MAX 4096 /* bytes, a client only sends subscriptions */
+#define WS_METRICS_INTERVAL 5 /* sec */
+
+/*
+ * One endpoint for every dashboard panel : a client sends
+ * {"subscribe": ["face", ...]} or {"unsubscribe": [...]} and receives
+ * {"topic": "face", "data": ...} for the topics it subscribed.
+ */
+struct ws_topic {
+	const char *name;
+	guint min_interval; /* msec between two sends */
+	char *snapshot; /* framed, NULL until published */
+	guint subscribers;
+	gint64 last_send_time; /* monotonic */
+	guint hold_timer; /* the snapshot goes out when it fires */
+};
+
+struct ws_client {
+	SoupWebsocketConnection *connection;
+	guint topics; /* 1 << ws_topic_e */
+	gulong message_handler;
+	gulong closed_handler;
+};
+
+static struct ws_topic g_topics[WS_TOPIC_MAX] = {
+	[WS_TOPIC_FACE] = { "face", 250 },
+	[WS_TOPIC_STORAGE] = { "storage", 1000 },
+	[WS_TOPIC_CONNECTION] = { "connection", 0 },
+	[WS_TOPIC_METRICS] = { "metrics", 1000 },
+};
+
+static GList *g_ws_clients; /* ws_client */
+static guint g_metrics_timer;
+
+static char *ws_frame(struct ws_topic *topic, const char *data)
+{
+	return g_strdup_printf("{\"topic\":\"%s\",\"data\":%s}", topic->name, data);
+}
+
+static void ws_client_send(struct ws_client *client, const char *framed)
+{
+	if (soup_websocket_connection_get_state(client->connection)
+		!= SOUP_WEBSOCKET_STATE_OPEN)
+		return;
+
+	soup_websocket_connection_send_text(client->connection, framed);
+}
+
+/* framed once, whatever the number of subscribers */
+static void ws_topic_send(struct ws_topic *topic, const char *framed)
+{
+	guint bit = 1 << (topic - g_topics);
+	GList *l = NULL;
+
+	for (l = g_ws_clients; l; l = l->next) {
+		struct ws_client *client = l->data;
+
+		if (client->topics & bit)
+			ws_client_send(client, framed);
+	}
+
+	topic->last_send_time = g_get_monotonic_time();
+}
+
+static gboolean ws_topic_hold_cb(gpointer user_data)
+{
+	struct ws_topic *topic = user_data;
+
+	topic->hold_timer = 0;
+	if (topic->subscribers && topic->snapshot)
+		ws_topic_send(topic, topic->snapshot);
+
+	return G_SOURCE_REMOVE;
+}
+
+void hs_route_api_ws_publish(ws_topic_e topic_id, const char *data,
+			const char *snapshot)
+{
+	struct ws_topic *topic = NULL;
+	char *framed = NULL;
+	gint64 wait = 0;
+
+	ret_if((int)topic_id < 0 || topic_id >= WS_TOPIC_MAX);
+	ret_if(!data);
+
+	topic = &g_topics[topic_id];
+	g_free(topic->snapshot);
+	topic->snapshot = ws_frame(topic, snapshot ? snapshot : data);
+
+	if (!topic->subscribers || topic->hold_timer)
+		return;
+
+	/* too soon after the last send, the latest state goes when allowed */
+	wait = topic->last_send_time + (gint64)topic->min_interval * 1000
+		- g_get_monotonic_time();
+	if (topic->last_send_time && wait > 0) {
+		topic->hold_timer = g_timeout_add(wait / 1000 + 1,
+				ws_topic_hold_cb, topic);
+		return;
+	}
+
+	if (!snapshot) {
+		ws_topic_send(topic, topic->snapshot);
+		return;
+	}
+
+	framed = ws_frame(topic, data);
+	ws_topic_send(topic, framed);
+	g_free(framed);
+}
+
+static gboolean ws_metrics_cb(gpointer user_data)
+{
+	util_json_writer *writer = NULL;
+	char *dump = NULL;
+	char *json = NULL;
+
+	dump = http_server_metrics_dump();
+	retv_if(!dump, G_SOURCE_CONTINUE);
+
+	writer = util_json_writer_new(strlen(dump) + 64);
+	util_json_begin_object(writer, NULL);
+	util_json_add_str(writer, "prometheus", dump);
+	util_json_end_object(writer);
+	g_free(dump);
+
+	json = util_json_writer_free_to_str(writer, NULL);
+	if (json)
+		hs_route_api_ws_publish(WS_TOPIC_METRICS, json, NULL);
+	g_free(json);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void ws_topic_subscribe(struct ws_client *client, ws_topic_e topic_id)
+{
+	struct ws_topic *topic = &g_topics[topic_id];
+
+	if (client->topics & (1 << topic_id))
+		return;
+
+	client->topics |= 1 << topic_id;
+	topic->subscribers++;
+
+	/* metrics are only gathered while someone watches them */
+	if (topic_id == WS_TOPIC_METRICS && !g_metrics_timer) {
+		g_metrics_timer = g_timeout_add_seconds(WS_METRICS_INTERVAL,
+				ws_metrics_cb, NULL);
+		ws_metrics_cb(NULL);
+		return;
+	}
+
+	if (topic->snapshot)
+		ws_client_send(client, topic->snapshot);
+}
+
+static void ws_topic_unsubscribe(struct ws_client *client, ws_topic_e topic_id)
+{
+	struct ws_topic *topic = &g_topics[topic_id];
+
+	if (!(client->topics & (1 << topic_id)))
+		return;
+
+	client->topics &= ~(1 << topic_id);
+	topic->subscribers--;
+
+	if (topic_id == WS_TOPIC_METRICS && !topic->subscribers && g_metrics_timer) {
+		g_source_remove(g_metrics_timer);
+		g_metrics_timer = 0;
+	}
+}
+
+static void ws_client_update_topics(struct ws_client *client,
+		JsonArray *names, gboolean subscribe)
+{
+	guint i = 0;
+	int t = 0;
+
+	for (i = 0; i < json_array_get_length(names); i++) {
+		const char *name = json_array_get_string_element(names, i);
+
+		for (t = 0; t < WS_TOPIC_MAX; t++) {
+			if (g_strcmp0(name, g_topics[t].name))
+				continue;
+
+			if (subscribe)
+				ws_topic_subscribe(client, t);
+			else
+				ws_topic_unsubscribe(client, t);
+			break;
+		}
+
+		if (t == WS_TOPIC_MAX)
+			_W("unknown topic [%s]", name ? name : "");
+	}
+}
+
+static void ws_message_cb(SoupWebsocketConnection *connection, gint type,
+		GBytes *message, gpointer user_data)
+{
+	struct ws_client *client = user_data;
+	JsonParser *parser = NULL;
+	JsonNode *root = NULL;
+	JsonObject *object = NULL;
+	gsize len = 0;
+	const char *data = NULL;
+
+	ret_if(type != SOUP_WEBSOCKET_DATA_TEXT);
+
+	data = g_bytes_get_data(message, &len);
+	parser = json_parser_new();
+	if (!json_parser_load_from_data(parser, data, len, NULL)) {
+		_W("websocket message is not JSON");
+		goto out;
+	}
+
+	root = json_parser_get_root(parser);
+	if (!root || !JSON_NODE_HOLDS_OBJECT(root)) {
+		_W("websocket message is not an object");
+		goto out;
+	}
+
+	object = json_node_get_object(root);
+	if (json_object_has_member(object, "subscribe")
+		&& JSON_NODE_HOLDS_ARRAY(json_object_get_member(object, "subscribe")))
+		ws_client_update_topics(client,
+			json_object_get_array_member(object, "subscribe"), TRUE);
+
+	if (json_object_has_member(object, "unsubscribe")
+		&& JSON_NODE_HOLDS_ARRAY(json_object_get_member(object, "unsubscribe")))
+		ws_client_update_topics(client,
+			json_object_get_array_member(object, "unsubscribe"), FALSE);
+
+out:
+	g_object_unref(parser);
+}
+
+static void ws_closed_cb(SoupWebsocketConnection *connection, gpointer user_data)
+{
+	struct ws_client *client = user_data;
+	int t = 0;
+
+	for (t = 0; t < WS_TOPIC_MAX; t++)
+		ws_topic_unsubscribe(client, t);
+
+	g_ws_clients = g_list_remove(g_ws_clients, client);
+	g_signal_handler_disconnect(connection, client->message_handler);
+	g_signal_handler_disconnect(connection, client->closed_handler);
+	g_object_unref(client->connection);
+	g_free(client);
+}
+
+static void route_api_ws_callback(SoupWebsocketConnection *connection,
+					const char *path, SoupClientContext *client,
+					gpointer user_data)
+{
+	struct ws_client *ws_client = NULL;
+
+	ws_client = g_new0(struct ws_client, 1);
+	ws_client->connection = g_object_ref(connection);
+	ws_client->message_handler = g_signal_connect(connection, "message",
+			G_CALLBACK(ws_message_cb), ws_client);
+	ws_client->closed_handler = g_signal_connect(connection, "closed",
+			G_CALLBACK(ws_closed_cb), ws_client);
+
+	soup_websocket_connection_set_keepalive_interval(connection, WS_KEEPALIVE);
+	soup_websocket_connection_set_max_incoming_payload_size(connection,
+			WS_MESSAGE_MAX);
+
+	g_ws_clients = g_list_prepend(g_ws_clients, ws_client);
+}
+
+int hs_route_api_ws_init(void)
+{
+	return http_server_websocket_add(WS_PATH, route_api_ws_callback, NULL, NULL);
+}
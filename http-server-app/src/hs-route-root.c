@@ -15,103 +15,512 @@
  */
 
 #include <glib.h>
-#include <gio/gio.h>
 #include <errno.h>
 #include <string.h>
-#include <sys/types.h>
-#include <unistd.h>
-#include <sys/stat.h>
 #include <libsoup/soup.h>
 #include <app_common.h>
 #include "http-server-log-private.h"
 #include "http-server-route.h"
+#include "http-server-file-cache.h"
 
-static int serve_file(const char *file, SoupMessage *msg, guint *status_code)
+#define PUBLIC_DIR "public"
+#define INDEX_FILE "/index.html"
+#define CACHE_CONTROL_CONF "cache-control.conf"
+#define CACHE_CONTROL_GROUP "max-age"
+#define CACHE_CONTROL_DEFAULT_KEY "default"
+#define STREAM_CHUNK_SIZE (64 * 1024)
+
+struct stream {
+	file_cache_entry *entry;
+	SoupClientContext *client;
+	goffset offset;
+	goffset remaining;
+};
+
+struct route_root {
+	file_cache *cache;
+	GHashTable *max_age; /* lower case file extension -> seconds */
+	gint default_max_age;
+};
+
+static gboolean
+encoding_is_acceptable(GSList *accepted, GSList *unacceptable, const char *name)
 {
-	GMappedFile *map_file = NULL;
-	char *content_type = NULL;
+	if (g_slist_find_custom(accepted, name, (GCompareFunc)g_ascii_strcasecmp))
+		return TRUE;
+
+	if (g_slist_find_custom(unacceptable, name, (GCompareFunc)g_ascii_strcasecmp))
+		return FALSE;
+
+	return g_slist_find_custom(accepted, "*", (GCompareFunc)g_strcmp0) != NULL;
+}
+
+/* the smallest coding the client accepts, and whether the entry has any */
+static file_cache_encoding
+negotiate_encoding(SoupMessage *msg, file_cache_entry *entry, gboolean *has_variants)
+{
+	static const file_cache_encoding preferred[] = {
+		FILE_CACHE_ENCODING_BR,
+		FILE_CACHE_ENCODING_GZIP,
+	};
+	file_cache_encoding encoding = FILE_CACHE_ENCODING_IDENTITY;
+	GSList *accepted = NULL;
+	GSList *unacceptable = NULL;
+	const char *header = NULL;
+	guint i = 0;
+
+	*has_variants = FALSE;
 
-	map_file = g_mapped_file_new(file, FALSE, NULL);
-	if (!map_file) {
-		if (status_code)
-			*status_code = SOUP_STATUS_INTERNAL_SERVER_ERROR;
-		return -1;
+	header = soup_message_headers_get_list(msg->request_headers, "Accept-Encoding");
+	if (header)
+		accepted = soup_header_parse_quality_list(header, &unacceptable);
+
+	for (i = 0; i < G_N_ELEMENTS(preferred); i++) {
+		if (!file_cache_entry_get_encoded_data(entry, preferred[i], NULL))
+			continue;
+
+		*has_variants = TRUE;
+		if (encoding == FILE_CACHE_ENCODING_IDENTITY
+			&& encoding_is_acceptable(accepted, unacceptable,
+				file_cache_encoding_to_string(preferred[i])))
+			encoding = preferred[i];
 	}
 
-	soup_message_body_append(msg->response_body,
-		SOUP_MEMORY_COPY,
-		g_mapped_file_get_contents(map_file),
-		g_mapped_file_get_length(map_file));
+	soup_header_free_list(accepted);
+	soup_header_free_list(unacceptable);
+
+	return encoding;
+}
+
+static gint max_age_get(struct route_root *root, const char *path)
+{
+	const char *base = NULL;
+	const char *ext = NULL;
+	gpointer value = NULL;
+	char *key = NULL;
+	gboolean found = FALSE;
+
+	base = strrchr(path, '/');
+	ext = strrchr(base ? base : path, '.');
+	if (!ext || !ext[1])
+		return root->default_max_age;
 
-	g_clear_pointer(&map_file, g_mapped_file_unref);
+	key = g_ascii_strdown(ext + 1, -1);
+	found = g_hash_table_lookup_extended(root->max_age, key, NULL, &value);
+	g_free(key);
 
-	content_type = g_content_type_guess(file, NULL, 0, NULL);
-	if (content_type) {
-		char *mime_type = g_content_type_get_mime_type(content_type);
-		if (mime_type) {
-			soup_message_headers_set_content_type(
-					msg->response_headers, mime_type, NULL);
-			g_free(mime_type);
+	return found ? GPOINTER_TO_INT(value) : root->default_max_age;
+}
+
+static gboolean etag_list_matches(const char *header, const char *etag)
+{
+	GSList *tags = NULL;
+	GSList *l = NULL;
+	gboolean matched = FALSE;
+
+	tags = soup_header_parse_list(header);
+	for (l = tags; l && !matched; l = l->next) {
+		const char *tag = l->data;
+
+		if (!strcmp(tag, "*")) {
+			matched = TRUE;
+			continue;
 		}
-		g_clear_pointer(&content_type, g_free);
+
+		/* If-None-Match uses the weak comparison */
+		if (g_str_has_prefix(tag, "W/"))
+			tag += 2;
+		matched = !g_strcmp0(tag, etag);
 	}
+	soup_header_free_list(tags);
+
+	return matched;
+}
+
+static gboolean
+is_not_modified(SoupMessage *msg, file_cache_entry *entry, const char *etag)
+{
+	const char *header = NULL;
+	SoupDate *date = NULL;
+	gboolean not_modified = FALSE;
+
+	/* If-Modified-Since only counts without If-None-Match, RFC 7232 6. */
+	header = soup_message_headers_get_list(msg->request_headers, "If-None-Match");
+	if (header)
+		return etag_list_matches(header, etag);
+
+	header = soup_message_headers_get_one(msg->request_headers, "If-Modified-Since");
+	if (!header)
+		return FALSE;
+
+	date = soup_date_new_from_string(header);
+	if (!date)
+		return FALSE;
+
+	not_modified = file_cache_entry_get_mtime(entry) <= soup_date_to_time_t(date);
+	soup_date_free(date);
+
+	return not_modified;
+}
+
+static void set_validators(struct route_root *root, SoupMessage *msg,
+			const char *path, file_cache_entry *entry, const char *etag)
+{
+	SoupDate *date = NULL;
+	char *value = NULL;
+	gint max_age = 0;
+
+	soup_message_headers_replace(msg->response_headers, "ETag", etag);
+
+	date = soup_date_new_from_time_t(file_cache_entry_get_mtime(entry));
+	value = soup_date_to_string(date, SOUP_DATE_HTTP);
+	soup_message_headers_replace(msg->response_headers, "Last-Modified", value);
+	g_free(value);
+	soup_date_free(date);
+
+	/* behind auth, so never for shared caches */
+	max_age = max_age_get(root, path);
+	if (max_age > 0)
+		value = g_strdup_printf("private, max-age=%d", max_age);
+	else
+		value = g_strdup("private, no-cache");
+	soup_message_headers_replace(msg->response_headers, "Cache-Control", value);
+	g_free(value);
+}
+
+/*
+ * One "bytes=" range of size bytes. -EINVAL when there is none to honour,
+ * multiple ranges included, -ERANGE when it is not satisfiable.
+ */
+static int range_parse(const char *header, goffset size, goffset *start, goffset *end)
+{
+	const char *spec = NULL;
+	char *endp = NULL;
+	gint64 first = 0;
+	gint64 last = 0;
+
+	if (!g_str_has_prefix(header, "bytes="))
+		return -EINVAL;
+
+	spec = header + strlen("bytes=");
+	if (strchr(spec, ','))
+		return -EINVAL;
+
+	if (*spec == '-') {
+		/* the last bytes */
+		last = g_ascii_strtoll(spec + 1, &endp, 10);
+		if (endp == spec + 1 || *endp || last < 0)
+			return -EINVAL;
+		if (!last || !size)
+			return -ERANGE;
+
+		*start = MAX(size - last, 0);
+		*end = size - 1;
+		return 0;
+	}
+
+	first = g_ascii_strtoll(spec, &endp, 10);
+	if (endp == spec || *endp != '-' || first < 0)
+		return -EINVAL;
+
+	spec = endp + 1;
+	last = size - 1;
+	if (*spec) {
+		last = g_ascii_strtoll(spec, &endp, 10);
+		if (endp == spec || *endp || last < first)
+			return -EINVAL;
+	}
+
+	if (first >= size)
+		return -ERANGE;
+
+	*start = first;
+	*end = MIN(last, size - 1);
 
 	return 0;
 }
 
+/* Range only counts while If-Range still names this content */
+static gboolean if_range_matches(SoupMessage *msg, const char *etag)
+{
+	const char *header = NULL;
+	const char *last_modified = NULL;
+
+	header = soup_message_headers_get_one(msg->request_headers, "If-Range");
+	if (!header)
+		return TRUE;
+
+	if (g_str_has_prefix(header, "W/"))
+		return FALSE;
+
+	if (header[0] == '"')
+		return !g_strcmp0(header, etag);
+
+	last_modified = soup_message_headers_get_one(msg->response_headers, "Last-Modified");
+
+	return !g_strcmp0(header, last_modified);
+}
+
+static void stream_free(gpointer data, GClosure *closure)
+{
+	struct stream *stream = data;
+
+	file_cache_entry_unref(stream->entry);
+	g_free(stream);
+}
+
+static void stream_append_chunk(SoupMessage *msg, gpointer user_data)
+{
+	struct stream *stream = user_data;
+	gsize count = 0;
+	gssize n = 0;
+	char *buf = NULL;
+
+	if (stream->remaining <= 0)
+		return;
+
+	count = MIN(stream->remaining, STREAM_CHUNK_SIZE);
+	buf = g_malloc(count);
+	n = file_cache_entry_read(stream->entry, stream->offset, buf, count);
+	if (n <= 0) {
+		/* the length is already sent, the body can only be cut short */
+		_E("failed to read at %" G_GINT64_FORMAT " - %s",
+			(gint64)stream->offset, n ? g_strerror(-n) : "end of file");
+		g_free(buf);
+		stream->remaining = 0;
+		soup_socket_disconnect(soup_client_context_get_socket(stream->client));
+		return;
+	}
+
+	stream->offset += n;
+	stream->remaining -= n;
+	soup_message_body_append(msg->response_body, SOUP_MEMORY_TAKE, buf, n);
+}
+
+/*
+ * Large files go out a chunk at a time, the next one read when the
+ * previous one is written and dropped, so a download holds one chunk.
+ */
+static void serve_stream(SoupMessage *msg, SoupClientContext *client,
+			file_cache_entry *entry, goffset offset, goffset length)
+{
+	struct stream *stream = NULL;
+
+	soup_message_headers_set_encoding(msg->response_headers,
+			SOUP_ENCODING_CONTENT_LENGTH);
+	soup_message_headers_set_content_length(msg->response_headers, length);
+	soup_message_body_set_accumulate(msg->response_body, FALSE);
+
+	stream = g_new0(struct stream, 1);
+	stream->entry = file_cache_entry_ref(entry);
+	stream->client = client;
+	stream->offset = offset;
+	stream->remaining = length;
+
+	g_signal_connect_data(msg, "wrote_chunk", G_CALLBACK(stream_append_chunk),
+			stream, stream_free, 0);
+	stream_append_chunk(msg, stream);
+}
+
+static void serve_entry(struct route_root *root, SoupMessage *msg,
+			SoupClientContext *client, const char *path,
+			file_cache_entry *entry)
+{
+	file_cache_encoding encoding = FILE_CACHE_ENCODING_IDENTITY;
+	gboolean has_variants = FALSE;
+	const char *mime_type = NULL;
+	const char *etag = NULL;
+	const char *data = NULL;
+	const char *range = NULL;
+	SoupBuffer *buffer = NULL;
+	guint status = SOUP_STATUS_OK;
+	goffset size = 0;
+	goffset start = 0;
+	goffset end = 0;
+	gsize len = 0;
+	int ret = 0;
+
+	encoding = negotiate_encoding(msg, entry, &has_variants);
+	etag = file_cache_entry_get_etag(entry, encoding);
+
+	set_validators(root, msg, path, entry, etag);
+
+	/* shared caches must not hand one client's coding to another */
+	if (has_variants)
+		soup_message_headers_append(msg->response_headers,
+				"Vary", "Accept-Encoding");
+
+	if (is_not_modified(msg, entry, etag)) {
+		soup_message_set_status(msg, SOUP_STATUS_NOT_MODIFIED);
+		return;
+	}
+
+	data = file_cache_entry_get_encoded_data(entry, encoding, &len);
+	size = data ? (goffset)len : file_cache_entry_get_size(entry);
+	end = size - 1;
+
+	soup_message_headers_replace(msg->response_headers, "Accept-Ranges", "bytes");
+
+	/* ranges are of the coded content, as the ETag is */
+	range = soup_message_headers_get_one(msg->request_headers, "Range");
+	if (range && if_range_matches(msg, etag)) {
+		ret = range_parse(range, size, &start, &end);
+		if (ret == -ERANGE) {
+			char *content_range = g_strdup_printf("bytes */%" G_GINT64_FORMAT,
+						(gint64)size);
+			soup_message_headers_replace(msg->response_headers,
+					"Content-Range", content_range);
+			g_free(content_range);
+			soup_message_set_status(msg, SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE);
+			return;
+		} else if (!ret) {
+			soup_message_headers_set_content_range(msg->response_headers,
+					start, end, size);
+			status = SOUP_STATUS_PARTIAL_CONTENT;
+		}
+	}
+
+	if (data) {
+		/* the body points into the cached entry, which the buffer keeps alive */
+		buffer = soup_buffer_new_with_owner(data + start, end - start + 1,
+					file_cache_entry_ref(entry),
+					(GDestroyNotify)file_cache_entry_unref);
+		soup_message_body_append_buffer(msg->response_body, buffer);
+		soup_buffer_free(buffer);
+	} else {
+		serve_stream(msg, client, entry, start, end - start + 1);
+	}
+
+	mime_type = file_cache_entry_get_mime_type(entry);
+	if (mime_type)
+		soup_message_headers_set_content_type(msg->response_headers,
+				mime_type, NULL);
+
+	if (encoding != FILE_CACHE_ENCODING_IDENTITY)
+		soup_message_headers_replace(msg->response_headers, "Content-Encoding",
+				file_cache_encoding_to_string(encoding));
+
+	soup_message_set_status(msg, status);
+}
+
 static void
-get_static_contents(SoupMessage *msg, const char *path)
+get_static_contents(SoupMessage *msg, SoupClientContext *client,
+			struct route_root *root, const char *path)
 {
-	struct stat st;
-	guint status_code = SOUP_STATUS_OK;
+	file_cache_entry *entry = NULL;
+	int ret = 0;
 
-	if (stat(path, &st) == -1) {
+	/* the only directory served is the root, as its index */
+	if (!path || !strcmp(path, "/"))
+		path = INDEX_FILE;
+
+	ret = file_cache_lookup(root->cache, path, &entry);
+	if (ret == -ENOENT) {
 		_E("invalid path[%s]", path);
 		// DO NOT use code 403
 		soup_message_set_status(msg, SOUP_STATUS_NOT_FOUND);
 		return;
+	} else if (ret) {
+		_E("failed to read [%s] - %s", path, g_strerror(-ret));
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		return;
 	}
 
-	if (S_ISDIR(st.st_mode)) {
-		if (!soup_message_get_uri(msg)->path
-			|| (0 == strncmp("/", soup_message_get_uri(msg)->path, 2))) {
-			char *index_path = g_strdup_printf("%sindex.html", path);
-			serve_file(index_path, msg, &status_code);
-			g_free(index_path);
-		} else {
-			// DO NOT use code 403
-			_E("dir[%s] is not for serve", path);
-			status_code = SOUP_STATUS_NOT_FOUND;
-		}
-	} else {
-		serve_file(path, msg, &status_code);
-	}
-	soup_message_set_status(msg, status_code);
+	serve_entry(root, msg, client, path, entry);
+	file_cache_entry_unref(entry);
 }
 
 static void route_root_callback(SoupMessage *msg,
 					const char *path, GHashTable *query,
 					SoupClientContext *client, gpointer user_data)
 {
-	char *file_path = NULL;
-	char *res_path = NULL;
+	get_static_contents(msg, client, user_data, path);
+}
+
+static void max_age_load(struct route_root *root, const char *conf)
+{
+	GKeyFile *key_file = NULL;
+	GError *error = NULL;
+	char **keys = NULL;
+	int i = 0;
 
-	if (msg->method != SOUP_METHOD_GET) {
-		soup_message_set_status(msg, SOUP_STATUS_NOT_IMPLEMENTED);
+	key_file = g_key_file_new();
+	if (!g_key_file_load_from_file(key_file, conf, G_KEY_FILE_NONE, &error)) {
+		_W("failed to load [%s] - %s, files are revalidated on each use",
+			conf, error->message);
+		g_error_free(error);
+		g_key_file_unref(key_file);
 		return;
 	}
-	res_path = app_get_resource_path();
-	file_path = g_strdup_printf("%spublic%s", res_path, path ? path : "/");
-	g_clear_pointer(&res_path, g_free);
 
-	get_static_contents(msg, file_path);
-	g_free(file_path);
+	keys = g_key_file_get_keys(key_file, CACHE_CONTROL_GROUP, NULL, NULL);
+	for (i = 0; keys && keys[i]; i++) {
+		gint max_age = g_key_file_get_integer(key_file,
+					CACHE_CONTROL_GROUP, keys[i], &error);
+		if (error || max_age < 0) {
+			_W("invalid max-age of [%s] in [%s]", keys[i], conf);
+			g_clear_error(&error);
+			continue;
+		}
+
+		if (!strcmp(keys[i], CACHE_CONTROL_DEFAULT_KEY))
+			root->default_max_age = max_age;
+		else
+			g_hash_table_replace(root->max_age,
+				g_ascii_strdown(keys[i], -1), GINT_TO_POINTER(max_age));
+	}
+	g_strfreev(keys);
+	g_key_file_unref(key_file);
+}
+
+static void route_root_free(gpointer data)
+{
+	struct route_root *root = data;
+
+	if (!root)
+		return;
+
+	file_cache_free(root->cache);
+	g_hash_table_unref(root->max_age);
+	g_free(root);
 }
 
 int hs_route_root_init(void)
 {
-	int ret = http_server_auth_default_realm_path_add("/");
-	retv_if(ret, ret);
+	struct route_root *root = NULL;
+	char *res_path = NULL;
+	char *path = NULL;
+	int ret = 0;
+
+	res_path = app_get_resource_path();
+	retv_if(!res_path, -1);
+
+	root = g_new0(struct route_root, 1);
+	root->max_age = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	path = g_strconcat(res_path, CACHE_CONTROL_CONF, NULL);
+	max_age_load(root, path);
+	g_free(path);
+
+	path = g_strconcat(res_path, PUBLIC_DIR, NULL);
+	root->cache = file_cache_new(path);
+	g_free(path);
+	g_free(res_path);
+	if (!root->cache) {
+		ret = -1;
+		goto ERROR;
+	}
+
+	ret = http_server_auth_default_realm_path_add("/");
+	goto_if(ret, ERROR);
+
+	ret = http_server_route_add(SOUP_METHOD_GET, "/*",
+				route_root_callback, root, route_root_free);
+	goto_if(ret, ERROR);
+
+	return 0;
 
-	return http_server_route_handler_add(NULL, route_root_callback, NULL, NULL);
+ERROR:
+	route_root_free(root);
+	return ret;
 }
@@ -15,84 +15,209 @@
  */
 
 #include <glib.h>
-#include <json-glib/json-glib.h>
+#include <math.h>
 #include "http-server-log-private.h"
+#include "hs-util-json.h"
 
-char *util_json_generate_str(JsonBuilder *builder, gsize *len)
+struct _util_json_writer {
+	GString *out;
+	guint depth;
+	gboolean need_comma; /* a value was written at the current depth */
+	gboolean failed;
+};
+
+static const char hex_digits[] = "0123456789abcdef";
+
+util_json_writer *util_json_writer_new(gsize reserved_size)
 {
-	JsonNode *root = NULL;
-	JsonGenerator *generator = NULL;
-	char *str = NULL;
-	gsize length = 0;
+	util_json_writer *writer = g_new0(util_json_writer, 1);
+
+	writer->out = g_string_sized_new(reserved_size ? reserved_size : 256);
+
+	return writer;
+}
 
-	retv_if(!builder, NULL);
+/* copies runs of plain bytes at once, escapes only what JSON requires */
+static void append_escaped(GString *out, const gchar *str)
+{
+	const guchar *p = (const guchar *)str;
+	const guchar *run = p;
+
+	g_string_append_c(out, '"');
+
+	for (; *p; p++) {
+		if (*p >= 0x20 && *p != '"' && *p != '\\')
+			continue;
+
+		if (p > run)
+			g_string_append_len(out, (const gchar *)run, p - run);
+		run = p + 1;
+
+		switch (*p) {
+		case '"':
+			g_string_append(out, "\\\"");
+			break;
+		case '\\':
+			g_string_append(out, "\\\\");
+			break;
+		case '\n':
+			g_string_append(out, "\\n");
+			break;
+		case '\r':
+			g_string_append(out, "\\r");
+			break;
+		case '\t':
+			g_string_append(out, "\\t");
+			break;
+		default:
+			g_string_append(out, "\\u00");
+			g_string_append_c(out, hex_digits[*p >> 4]);
+			g_string_append_c(out, hex_digits[*p & 0xf]);
+			break;
+		}
+	}
 
-	root = json_builder_get_root(builder);
-	generator = json_generator_new();
+	if (p > run)
+		g_string_append_len(out, (const gchar *)run, p - run);
 
-	json_generator_set_root(generator, root);
-	str = json_generator_to_data(generator, &length);
+	g_string_append_c(out, '"');
+}
 
-	if (len)
-		*len = length;
+/* separator and member name in front of every value */
+static gboolean begin_value(util_json_writer *writer, const gchar *name)
+{
+	retv_if(!writer, FALSE);
 
-	if (length == 0) {
-		g_free(str);
-		str = NULL;
+	if (writer->depth == 0 && writer->need_comma) {
+		_E("json already has a root value");
+		writer->failed = TRUE;
+		return FALSE;
 	}
 
-	g_object_unref(generator);
-	json_node_unref(root);
+	if (writer->need_comma)
+		g_string_append_c(writer->out, ',');
 
-	return str;
+	if (name) {
+		append_escaped(writer->out, name);
+		g_string_append_c(writer->out, ':');
+	}
+
+	writer->need_comma = TRUE;
+
+	return TRUE;
+}
+
+static void begin_container(util_json_writer *writer, const gchar *name, char open)
+{
+	ret_if(!begin_value(writer, name));
+
+	g_string_append_c(writer->out, open);
+	writer->depth++;
+	writer->need_comma = FALSE;
+}
+
+static void end_container(util_json_writer *writer, char close)
+{
+	ret_if(!writer);
+
+	if (writer->depth == 0) {
+		_E("json container is not open");
+		writer->failed = TRUE;
+		return;
+	}
+
+	g_string_append_c(writer->out, close);
+	writer->depth--;
+	writer->need_comma = TRUE;
+}
+
+void util_json_begin_object(util_json_writer *writer, const gchar *name)
+{
+	begin_container(writer, name, '{');
+}
+
+void util_json_end_object(util_json_writer *writer)
+{
+	end_container(writer, '}');
+}
+
+void util_json_begin_array(util_json_writer *writer, const gchar *name)
+{
+	begin_container(writer, name, '[');
+}
+
+void util_json_end_array(util_json_writer *writer)
+{
+	end_container(writer, ']');
 }
 
 void
-util_json_add_int(JsonBuilder *builder, const gchar *name, gint64 value)
+util_json_add_int(util_json_writer *writer, const gchar *name, gint64 value)
 {
-	ret_if(!builder);
-	ret_if(!name);
+	ret_if(!begin_value(writer, name));
 
-	json_builder_set_member_name(builder, name);
-	json_builder_add_int_value(builder, value);
+	g_string_append_printf(writer->out, "%" G_GINT64_FORMAT, value);
 }
 
 void
-util_json_add_double(JsonBuilder *builder, const gchar *name, gdouble value)
+util_json_add_double(util_json_writer *writer, const gchar *name, gdouble value)
 {
-	ret_if(!builder);
-	ret_if(!name);
+	char num[G_ASCII_DTOSTR_BUF_SIZE];
+
+	ret_if(!begin_value(writer, name));
 
-	json_builder_set_member_name(builder, name);
-	json_builder_add_double_value(builder, value);
+	/* JSON has no NaN or infinity */
+	if (isnan(value) || isinf(value))
+		g_string_append(writer->out, "null");
+	else
+		g_string_append(writer->out, g_ascii_dtostr(num, sizeof(num), value));
 }
 
 void
-util_json_add_bool(JsonBuilder *builder, const gchar *name, gboolean value)
+util_json_add_bool(util_json_writer *writer, const gchar *name, gboolean value)
 {
-	ret_if(!builder);
-	ret_if(!name);
+	ret_if(!begin_value(writer, name));
 
-	json_builder_set_member_name(builder, name);
-	json_builder_add_boolean_value(builder, value);
+	g_string_append(writer->out, value ? "true" : "false");
 }
 
 void
-util_json_add_str(JsonBuilder *builder, const gchar *name, const gchar *value)
+util_json_add_str(util_json_writer *writer, const gchar *name, const gchar *value)
 {
-	ret_if(!builder);
-	ret_if(!name);
+	ret_if(!begin_value(writer, name));
 
-	json_builder_set_member_name(builder, name);
-	json_builder_add_string_value(builder, value);
+	if (value)
+		append_escaped(writer->out, value);
+	else
+		g_string_append(writer->out, "null");
 }
 
 void
-util_json_add_null(JsonBuilder *builder, const gchar *name)
+util_json_add_null(util_json_writer *writer, const gchar *name)
 {
-	ret_if(!builder);
-	ret_if(!name);
+	ret_if(!begin_value(writer, name));
 
-	json_builder_set_member_name(builder, name);
-	json_builder_add_null_value(builder);
+	g_string_append(writer->out, "null");
+}
+
+char *util_json_writer_free_to_str(util_json_writer *writer, gsize *len)
+{
+	char *str = NULL;
+	gsize length = 0;
+
+	retv_if(!writer, NULL);
+
+	if (writer->failed || writer->depth || !writer->out->len) {
+		_E("json is incomplete");
+		g_string_free(writer->out, TRUE);
+	} else {
+		length = writer->out->len;
+		str = g_string_free(writer->out, FALSE);
+	}
+	g_free(writer);
+
+	if (len)
+		*len = length;
+
+	return str;
 }
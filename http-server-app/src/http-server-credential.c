@@ -0,0 +1,175 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include "http-server-log-private.h"
+#include "http-server-credential.h"
+
+struct _credential_store {
+	char *path;
+	GHashTable *realms; /* realm -> (username -> HA1) */
+	GFileMonitor *monitor;
+};
+
+static GHashTable *credential_table_load(const char *path)
+{
+	GKeyFile *key_file = NULL;
+	GHashTable *realms = NULL;
+	GError *error = NULL;
+	char **groups = NULL;
+	int i = 0;
+
+	key_file = g_key_file_new();
+	if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, &error)) {
+		_E("failed to load htdigest file[%s] - %s", path, error->message);
+		g_error_free(error);
+		g_key_file_unref(key_file);
+		return NULL;
+	}
+
+	realms = g_hash_table_new_full(g_str_hash, g_str_equal,
+				g_free, (GDestroyNotify)g_hash_table_unref);
+
+	groups = g_key_file_get_groups(key_file, NULL);
+	for (i = 0; groups && groups[i]; i++) {
+		GHashTable *users = NULL;
+		char **keys = NULL;
+		int j = 0;
+
+		users = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		keys = g_key_file_get_keys(key_file, groups[i], NULL, NULL);
+		for (j = 0; keys && keys[j]; j++) {
+			char *ha1 = g_key_file_get_string(key_file, groups[i], keys[j], NULL);
+			if (ha1)
+				g_hash_table_insert(users, g_strdup(keys[j]), ha1);
+		}
+		g_strfreev(keys);
+
+		g_hash_table_insert(realms, g_strdup(groups[i]), users);
+	}
+	g_strfreev(groups);
+	g_key_file_unref(key_file);
+
+	return realms;
+}
+
+int credential_store_reload(credential_store *store)
+{
+	GHashTable *realms = NULL;
+
+	retv_if(!store, -1);
+
+	realms = credential_table_load(store->path);
+	retv_if(!realms, -1);
+
+	if (store->realms)
+		g_hash_table_unref(store->realms);
+	store->realms = realms;
+
+	_D("credentials are loaded from [%s] : %u realm(s)",
+		store->path, g_hash_table_size(realms));
+
+	return 0;
+}
+
+static void
+credential_file_changed_cb(GFileMonitor *monitor, GFile *file, GFile *other_file,
+			GFileMonitorEvent event_type, gpointer user_data)
+{
+	credential_store *store = user_data;
+
+	switch (event_type) {
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+	case G_FILE_MONITOR_EVENT_CREATED:
+		if (credential_store_reload(store))
+			_W("keep previous credentials");
+		break;
+	case G_FILE_MONITOR_EVENT_DELETED:
+		_W("htdigest file is deleted, keep previous credentials");
+		break;
+	default:
+		break;
+	}
+}
+
+credential_store *credential_store_new(const char *path)
+{
+	credential_store *store = NULL;
+	GFile *file = NULL;
+	GError *error = NULL;
+
+	retv_if(!path, NULL);
+
+	store = g_try_new0(credential_store, 1);
+	retvm_if(!store, NULL, "failed to alloc credential_store");
+
+	store->path = g_strdup(path);
+	if (credential_store_reload(store)) {
+		credential_store_free(store);
+		return NULL;
+	}
+
+	file = g_file_new_for_path(path);
+	store->monitor = g_file_monitor_file(file, G_FILE_MONITOR_NONE, NULL, &error);
+	g_object_unref(file);
+
+	if (store->monitor) {
+		g_signal_connect(store->monitor, "changed",
+			G_CALLBACK(credential_file_changed_cb), store);
+	} else {
+		/* read-only resources are still served, just never reloaded */
+		_W("failed to monitor [%s] - %s", path, error ? error->message : "");
+		g_clear_error(&error);
+	}
+
+	return store;
+}
+
+void credential_store_free(credential_store *store)
+{
+	if (!store)
+		return;
+
+	if (store->monitor) {
+		g_signal_handlers_disconnect_by_data(store->monitor, store);
+		g_file_monitor_cancel(store->monitor);
+		g_object_unref(store->monitor);
+	}
+
+	if (store->realms)
+		g_hash_table_unref(store->realms);
+
+	g_free(store->path);
+	g_free(store);
+}
+
+char *credential_store_lookup(credential_store *store,
+				const char *realm, const char *username)
+{
+	GHashTable *users = NULL;
+
+	retv_if(!store, NULL);
+	retv_if(!store->realms, NULL);
+	retv_if(!realm, NULL);
+	retv_if(!username, NULL);
+
+	users = g_hash_table_lookup(store->realms, realm);
+	if (!users)
+		return NULL;
+
+	return g_strdup(g_hash_table_lookup(users, username));
+}
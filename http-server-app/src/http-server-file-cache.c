@@ -0,0 +1,509 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "http-server-log-private.h"
+#include "http-server-file-cache.h"
+
+/* larger files are read on demand instead of being kept mapped */
+#define FILE_CACHE_MAP_MAX (1024 * 1024)
+
+struct _file_cache {
+	char *root;
+	gsize root_len;
+	GHashTable *entries; /* path below root -> file_cache_entry */
+	GHashTable *monitors; /* directory -> GFileMonitor */
+};
+
+struct _file_cache_entry {
+	gint ref_count;
+	char *file;
+	GMappedFile *map; /* NULL for large files */
+	int fd; /* -1 unless large */
+	goffset size;
+	GBytes *encoded[FILE_CACHE_ENCODING_MAX];
+	gboolean encoded_tried[FILE_CACHE_ENCODING_MAX];
+	char *mime_type;
+	char *etag[FILE_CACHE_ENCODING_MAX];
+	gint64 mtime;
+};
+
+file_cache_entry *file_cache_entry_ref(file_cache_entry *entry)
+{
+	retv_if(!entry, NULL);
+
+	g_atomic_int_inc(&entry->ref_count);
+
+	return entry;
+}
+
+void file_cache_entry_unref(file_cache_entry *entry)
+{
+	int i = 0;
+
+	if (!entry)
+		return;
+
+	if (!g_atomic_int_dec_and_test(&entry->ref_count))
+		return;
+
+	for (i = 0; i < FILE_CACHE_ENCODING_MAX; i++) {
+		g_clear_pointer(&entry->encoded[i], g_bytes_unref);
+		g_free(entry->etag[i]);
+	}
+	if (entry->map)
+		g_mapped_file_unref(entry->map);
+	if (entry->fd >= 0)
+		close(entry->fd);
+	g_free(entry->file);
+	g_free(entry->mime_type);
+	g_free(entry);
+}
+
+const char *file_cache_entry_get_data(file_cache_entry *entry, gsize *len)
+{
+	retv_if(!entry, NULL);
+
+	if (!entry->map) {
+		if (len)
+			*len = 0;
+		return NULL;
+	}
+
+	if (len)
+		*len = g_mapped_file_get_length(entry->map);
+
+	return g_mapped_file_get_contents(entry->map);
+}
+
+goffset file_cache_entry_get_size(file_cache_entry *entry)
+{
+	retv_if(!entry, 0);
+
+	return entry->size;
+}
+
+gssize file_cache_entry_read(file_cache_entry *entry, goffset offset,
+			void *buf, gsize count)
+{
+	gssize n = 0;
+
+	retv_if(!entry, -EINVAL);
+	retv_if(!buf, -EINVAL);
+	retv_if(offset < 0, -EINVAL);
+
+	if (offset >= entry->size)
+		return 0;
+
+	if ((goffset)count > entry->size - offset)
+		count = entry->size - offset;
+
+	if (entry->map) {
+		memcpy(buf, g_mapped_file_get_contents(entry->map) + offset, count);
+		return count;
+	}
+
+	do {
+		n = pread(entry->fd, buf, count, offset);
+	} while (n < 0 && errno == EINTR);
+
+	return n < 0 ? -errno : n;
+}
+
+static const char *encoding_suffix[FILE_CACHE_ENCODING_MAX] = {
+	[FILE_CACHE_ENCODING_GZIP] = ".gz",
+	[FILE_CACHE_ENCODING_BR] = ".br",
+};
+
+static const char *encoding_name[FILE_CACHE_ENCODING_MAX] = {
+	[FILE_CACHE_ENCODING_GZIP] = "gzip",
+	[FILE_CACHE_ENCODING_BR] = "br",
+};
+
+const char *file_cache_encoding_to_string(file_cache_encoding encoding)
+{
+	retv_if((int)encoding < 0 || encoding >= FILE_CACHE_ENCODING_MAX, NULL);
+
+	return encoding_name[encoding];
+}
+
+static gboolean mime_type_is_compressible(const char *mime_type)
+{
+	if (!mime_type)
+		return FALSE;
+
+	return g_str_has_prefix(mime_type, "text/")
+		|| strstr(mime_type, "javascript")
+		|| strstr(mime_type, "json")
+		|| strstr(mime_type, "xml");
+}
+
+static GBytes *gzip_compress(const char *data, gsize len)
+{
+	GConverter *compressor = NULL;
+	GConverterResult result = G_CONVERTER_ERROR;
+	GByteArray *out = NULL;
+	GError *error = NULL;
+	guint8 buf[16 * 1024];
+	gsize bytes_read = 0;
+	gsize bytes_written = 0;
+
+	compressor = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP, 9));
+	out = g_byte_array_sized_new(len / 4 + 64);
+
+	do {
+		result = g_converter_convert(compressor, data, len,
+				buf, sizeof(buf), G_CONVERTER_INPUT_AT_END,
+				&bytes_read, &bytes_written, &error);
+		if (result == G_CONVERTER_ERROR)
+			break;
+
+		g_byte_array_append(out, buf, bytes_written);
+		data += bytes_read;
+		len -= bytes_read;
+	} while (result != G_CONVERTER_FINISHED);
+
+	g_object_unref(compressor);
+
+	if (result == G_CONVERTER_ERROR) {
+		_E("failed to compress - %s", error ? error->message : "");
+		g_clear_error(&error);
+		g_byte_array_unref(out);
+		return NULL;
+	}
+
+	return g_byte_array_free_to_bytes(out);
+}
+
+static GBytes *precompressed_load(file_cache_entry *entry, file_cache_encoding encoding)
+{
+	GMappedFile *map = NULL;
+	GBytes *bytes = NULL;
+	struct stat st;
+	char *file = NULL;
+	int fd = -1;
+
+	file = g_strconcat(entry->file, encoding_suffix[encoding], NULL);
+	fd = open(file, O_RDONLY | O_CLOEXEC);
+	g_free(file);
+	if (fd < 0)
+		return NULL;
+
+	/* a variant left over from an older file is not the same content */
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)
+		|| st.st_mtime < entry->mtime) {
+		close(fd);
+		return NULL;
+	}
+
+	map = g_mapped_file_new_from_fd(fd, FALSE, NULL);
+	close(fd);
+	if (!map)
+		return NULL;
+
+	bytes = g_mapped_file_get_bytes(map);
+	g_mapped_file_unref(map);
+
+	return bytes;
+}
+
+const char *file_cache_entry_get_encoded_data(file_cache_entry *entry,
+			file_cache_encoding encoding, gsize *len)
+{
+	retv_if(!entry, NULL);
+	retv_if((int)encoding < 0 || encoding >= FILE_CACHE_ENCODING_MAX, NULL);
+
+	if (encoding == FILE_CACHE_ENCODING_IDENTITY)
+		return file_cache_entry_get_data(entry, len);
+
+	/* large files are only sent as they are */
+	if (!entry->map)
+		return NULL;
+
+	if (!entry->encoded_tried[encoding]) {
+		entry->encoded_tried[encoding] = TRUE;
+		entry->encoded[encoding] = precompressed_load(entry, encoding);
+
+		if (!entry->encoded[encoding]
+			&& encoding == FILE_CACHE_ENCODING_GZIP
+			&& mime_type_is_compressible(entry->mime_type)) {
+			gsize data_len = 0;
+			const char *data = file_cache_entry_get_data(entry, &data_len);
+			GBytes *bytes = gzip_compress(data, data_len);
+
+			/* not worth a variant when it does not get smaller */
+			if (bytes && g_bytes_get_size(bytes) < data_len)
+				entry->encoded[encoding] = bytes;
+			else if (bytes)
+				g_bytes_unref(bytes);
+		}
+	}
+
+	if (!entry->encoded[encoding])
+		return NULL;
+
+	return g_bytes_get_data(entry->encoded[encoding], len);
+}
+
+const char *file_cache_entry_get_mime_type(file_cache_entry *entry)
+{
+	retv_if(!entry, NULL);
+
+	return entry->mime_type;
+}
+
+const char *file_cache_entry_get_etag(file_cache_entry *entry,
+			file_cache_encoding encoding)
+{
+	retv_if(!entry, NULL);
+	retv_if((int)encoding < 0 || encoding >= FILE_CACHE_ENCODING_MAX, NULL);
+
+	return entry->etag[encoding];
+}
+
+gint64 file_cache_entry_get_mtime(file_cache_entry *entry)
+{
+	retv_if(!entry, 0);
+
+	return entry->mtime;
+}
+
+static char *mime_type_guess(const char *file)
+{
+	char *content_type = NULL;
+	char *mime_type = NULL;
+
+	content_type = g_content_type_guess(file, NULL, 0, NULL);
+	if (content_type) {
+		mime_type = g_content_type_get_mime_type(content_type);
+		g_free(content_type);
+	}
+
+	return mime_type;
+}
+
+static int file_cache_entry_load(const char *file, file_cache_entry **entry)
+{
+	file_cache_entry *e = NULL;
+	GMappedFile *map = NULL;
+	GError *error = NULL;
+	struct stat st;
+	int fd = -1;
+	int i = 0;
+
+	fd = open(file, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return errno == ENOTDIR ? -ENOENT : -errno;
+
+	/* validators of the mapped file, not of whatever is at the path later */
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return -ENOENT;
+	}
+
+	/* the open file keeps the content the validators describe */
+	if (st.st_size > FILE_CACHE_MAP_MAX) {
+		_D("[%s] is %" G_GINT64_FORMAT " bytes, read on demand",
+			file, (gint64)st.st_size);
+	} else {
+		map = g_mapped_file_new_from_fd(fd, FALSE, &error);
+		close(fd);
+		fd = -1;
+		if (!map) {
+			_E("failed to map [%s] - %s", file, error->message);
+			g_error_free(error);
+			return -EIO;
+		}
+	}
+
+	e = g_new0(file_cache_entry, 1);
+	e->ref_count = 1;
+	e->file = g_strdup(file);
+	e->map = map;
+	e->fd = fd;
+	e->size = st.st_size;
+	e->mime_type = mime_type_guess(file);
+	e->mtime = st.st_mtime;
+	/* strong validators, so each coding of the file needs its own */
+	e->etag[FILE_CACHE_ENCODING_IDENTITY] = g_strdup_printf("\"%" G_GINT64_MODIFIER "x-%"
+			G_GINT64_MODIFIER "x-%" G_GINT64_MODIFIER "x\"", (gint64)st.st_ino,
+			(gint64)st.st_size, (gint64)st.st_mtime);
+	for (i = FILE_CACHE_ENCODING_IDENTITY + 1; i < FILE_CACHE_ENCODING_MAX; i++) {
+		const char *etag = e->etag[FILE_CACHE_ENCODING_IDENTITY];
+
+		e->etag[i] = g_strdup_printf("%.*s-%s\"", (int)strlen(etag) - 1,
+				etag, encoding_name[i]);
+	}
+
+	*entry = e;
+
+	return 0;
+}
+
+static void file_cache_drop(file_cache *cache, GFile *file)
+{
+	char *path = NULL;
+	int i = 0;
+
+	if (!file)
+		return;
+
+	path = g_file_get_path(file);
+	if (!path || !g_str_has_prefix(path, cache->root)) {
+		g_free(path);
+		return;
+	}
+
+	/* a changed variant drops the file it belongs to */
+	for (i = 0; i < FILE_CACHE_ENCODING_MAX; i++) {
+		if (encoding_suffix[i] && g_str_has_suffix(path, encoding_suffix[i])) {
+			path[strlen(path) - strlen(encoding_suffix[i])] = '\0';
+			break;
+		}
+	}
+
+	if (g_hash_table_remove(cache->entries, path + cache->root_len))
+		_D("[%s] is changed, dropped from the cache", path);
+	g_free(path);
+}
+
+static void
+file_cache_dir_changed_cb(GFileMonitor *monitor, GFile *file, GFile *other_file,
+			GFileMonitorEvent event_type, gpointer user_data)
+{
+	file_cache *cache = user_data;
+
+	file_cache_drop(cache, file);
+	if (event_type == G_FILE_MONITOR_EVENT_RENAMED
+		|| event_type == G_FILE_MONITOR_EVENT_MOVED_IN
+		|| event_type == G_FILE_MONITOR_EVENT_MOVED_OUT)
+		file_cache_drop(cache, other_file);
+}
+
+static void file_cache_monitor_dir(file_cache *cache, const char *file)
+{
+	GFileMonitor *monitor = NULL;
+	GFile *dir = NULL;
+	GError *error = NULL;
+	char *dir_path = NULL;
+
+	dir_path = g_path_get_dirname(file);
+
+	/* only directories of the tree, requests for missing ones add nothing */
+	if (g_hash_table_contains(cache->monitors, dir_path)
+		|| !g_file_test(dir_path, G_FILE_TEST_IS_DIR)) {
+		g_free(dir_path);
+		return;
+	}
+
+	dir = g_file_new_for_path(dir_path);
+	monitor = g_file_monitor_directory(dir, G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
+	g_object_unref(dir);
+
+	if (!monitor) {
+		/* the entry is still served, just never invalidated */
+		_W("failed to monitor [%s] - %s", dir_path, error ? error->message : "");
+		g_clear_error(&error);
+		g_free(dir_path);
+		return;
+	}
+
+	g_signal_connect(monitor, "changed",
+		G_CALLBACK(file_cache_dir_changed_cb), cache);
+	g_hash_table_insert(cache->monitors, dir_path, monitor);
+}
+
+static void file_cache_monitor_free(gpointer data)
+{
+	GFileMonitor *monitor = data;
+
+	g_signal_handlers_disconnect_matched(monitor, G_SIGNAL_MATCH_FUNC,
+		0, 0, NULL, file_cache_dir_changed_cb, NULL);
+	g_file_monitor_cancel(monitor);
+	g_object_unref(monitor);
+}
+
+file_cache *file_cache_new(const char *root)
+{
+	file_cache *cache = NULL;
+
+	retv_if(!root, NULL);
+
+	cache = g_try_new0(file_cache, 1);
+	retvm_if(!cache, NULL, "failed to alloc file_cache");
+
+	cache->root = g_strdup(root);
+	cache->root_len = strlen(root);
+	cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+				g_free, (GDestroyNotify)file_cache_entry_unref);
+	cache->monitors = g_hash_table_new_full(g_str_hash, g_str_equal,
+				g_free, file_cache_monitor_free);
+
+	return cache;
+}
+
+void file_cache_free(file_cache *cache)
+{
+	if (!cache)
+		return;
+
+	g_hash_table_unref(cache->monitors);
+	g_hash_table_unref(cache->entries);
+	g_free(cache->root);
+	g_free(cache);
+}
+
+int file_cache_lookup(file_cache *cache, const char *path, file_cache_entry **entry)
+{
+	file_cache_entry *e = NULL;
+	char *file = NULL;
+	int ret = 0;
+
+	retv_if(!cache, -EINVAL);
+	retv_if(!path || path[0] != '/', -EINVAL);
+	retv_if(!entry, -EINVAL);
+
+	e = g_hash_table_lookup(cache->entries, path);
+	if (e) {
+		*entry = file_cache_entry_ref(e);
+		return 0;
+	}
+
+	/* never leave root, even if the URI was not normalized */
+	if (strstr(path, "/../") || g_str_has_suffix(path, "/.."))
+		return -ENOENT;
+
+	file = g_strconcat(cache->root, path, NULL);
+
+	/* watch before loading, so a change in between is not missed */
+	file_cache_monitor_dir(cache, file);
+	ret = file_cache_entry_load(file, &e);
+	g_free(file);
+	if (ret)
+		return ret;
+
+	g_hash_table_insert(cache->entries, g_strdup(path), file_cache_entry_ref(e));
+	*entry = e;
+
+	return 0;
+}
@@ -0,0 +1,329 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include "http-server-log-private.h"
+#include "http-server-metrics.h"
+
+/* le 2^7 .. 2^24 usec (128us .. 16.7s) and +Inf */
+#define METRICS_BUCKET_MIN_SHIFT 7
+#define METRICS_BUCKET_MAX_SHIFT 24
+#define METRICS_BUCKET_COUNT (METRICS_BUCKET_MAX_SHIFT - METRICS_BUCKET_MIN_SHIFT + 2)
+
+enum {
+	METRICS_STATUS_1XX,
+	METRICS_STATUS_2XX,
+	METRICS_STATUS_3XX,
+	METRICS_STATUS_4XX,
+	METRICS_STATUS_5XX,
+	METRICS_STATUS_OTHER, /* aborted, transport errors */
+	METRICS_STATUS_MAX,
+};
+
+static const char *status_class_str[METRICS_STATUS_MAX] = {
+	"1xx", "2xx", "3xx", "4xx", "5xx", "other",
+};
+
+struct _route_metrics {
+	char *method;
+	char *route;
+	guint64 requests[METRICS_STATUS_MAX];
+	guint64 bytes_out;
+	guint64 buckets[METRICS_BUCKET_COUNT]; /* not cumulative */
+	guint64 elapsed_sum_us;
+};
+
+struct _metrics_counter {
+	char *name;
+	char *help;
+	guint64 value;
+};
+
+static GHashTable *g_metrics; /* "method route" -> route_metrics */
+static GPtrArray *g_metrics_order; /* registration order for dump */
+
+static GMutex g_counters_lock;
+static GPtrArray *g_counters; /* metrics_counter, registration order */
+
+static void route_metrics_free(gpointer data)
+{
+	route_metrics *metrics = data;
+
+	g_free(metrics->method);
+	g_free(metrics->route);
+	g_free(metrics);
+}
+
+route_metrics *route_metrics_get(const char *method, const char *route)
+{
+	route_metrics *metrics = NULL;
+	char *key = NULL;
+
+	if (!g_metrics) {
+		g_metrics = g_hash_table_new_full(g_str_hash, g_str_equal,
+					g_free, route_metrics_free);
+		g_metrics_order = g_ptr_array_new();
+	}
+
+	key = g_strdup_printf("%s %s", method ? method : "*", route ? route : "");
+	metrics = g_hash_table_lookup(g_metrics, key);
+	if (metrics) {
+		g_free(key);
+		return metrics;
+	}
+
+	metrics = g_new0(route_metrics, 1);
+	metrics->method = g_strdup(method ? method : "*");
+	metrics->route = g_strdup(route ? route : "");
+
+	g_hash_table_insert(g_metrics, key, metrics);
+	g_ptr_array_add(g_metrics_order, metrics);
+
+	return metrics;
+}
+
+metrics_counter *metrics_counter_get(const char *name, const char *help)
+{
+	metrics_counter *counter = NULL;
+	guint i = 0;
+
+	retv_if(!name, NULL);
+
+	g_mutex_lock(&g_counters_lock);
+
+	if (!g_counters)
+		g_counters = g_ptr_array_new();
+
+	for (i = 0; i < g_counters->len; i++) {
+		counter = g_ptr_array_index(g_counters, i);
+		if (!g_strcmp0(counter->name, name))
+			goto out;
+	}
+
+	counter = g_new0(metrics_counter, 1);
+	counter->name = g_strdup(name);
+	counter->help = g_strdup(help ? help : "");
+	g_ptr_array_add(g_counters, counter);
+
+out:
+	g_mutex_unlock(&g_counters_lock);
+
+	return counter;
+}
+
+metrics_counter *metrics_counter_get_labeled(const char *name,
+			const char *label, const char *value, const char *help)
+{
+	metrics_counter *counter = NULL;
+	char *labeled = NULL;
+
+	retv_if(!name || !label || !value, NULL);
+
+	labeled = g_strdup_printf("%s{%s=\"%s\"}", name, label, value);
+	counter = metrics_counter_get(labeled, help);
+	g_free(labeled);
+
+	return counter;
+}
+
+void metrics_counter_add(metrics_counter *counter, guint64 value)
+{
+	ret_if(!counter);
+
+	g_mutex_lock(&g_counters_lock);
+	counter->value += value;
+	g_mutex_unlock(&g_counters_lock);
+}
+
+guint64 metrics_counter_value(metrics_counter *counter)
+{
+	guint64 value = 0;
+
+	retv_if(!counter, 0);
+
+	g_mutex_lock(&g_counters_lock);
+	value = counter->value;
+	g_mutex_unlock(&g_counters_lock);
+
+	return value;
+}
+
+/* length of the metric name without its labels */
+static inline gsize counter_family_len(const char *name)
+{
+	return strcspn(name, "{");
+}
+
+static gboolean counter_same_family(const metrics_counter *a, const metrics_counter *b)
+{
+	gsize len = counter_family_len(a->name);
+
+	return len == counter_family_len(b->name) && !strncmp(a->name, b->name, len);
+}
+
+/* the samples of one family have to follow its HELP and TYPE lines */
+static void append_counters(GString *out)
+{
+	guint i = 0;
+	guint j = 0;
+
+	g_mutex_lock(&g_counters_lock);
+	for (i = 0; g_counters && i < g_counters->len; i++) {
+		const metrics_counter *counter = g_ptr_array_index(g_counters, i);
+		int len = counter_family_len(counter->name);
+
+		for (j = 0; j < i; j++)
+			if (counter_same_family(g_ptr_array_index(g_counters, j), counter))
+				break;
+		if (j < i)
+			continue;
+
+		g_string_append_printf(out, "# HELP %.*s %s\n# TYPE %.*s counter\n",
+			len, counter->name, counter->help, len, counter->name);
+
+		for (j = i; j < g_counters->len; j++) {
+			const metrics_counter *sample = g_ptr_array_index(g_counters, j);
+
+			if (counter_same_family(sample, counter))
+				g_string_append_printf(out, "%s %" G_GUINT64_FORMAT "\n",
+					sample->name, sample->value);
+		}
+	}
+	g_mutex_unlock(&g_counters_lock);
+}
+
+static inline guint bucket_index(gint64 elapsed_us)
+{
+	guint idx = 0;
+
+	if (elapsed_us <= (1 << METRICS_BUCKET_MIN_SHIFT))
+		return 0;
+
+	idx = g_bit_storage((gulong)(elapsed_us - 1)) - METRICS_BUCKET_MIN_SHIFT;
+
+	return MIN(idx, METRICS_BUCKET_COUNT - 1);
+}
+
+void route_metrics_record(route_metrics *metrics,
+			guint status, gsize bytes_out, gint64 elapsed_us)
+{
+	guint status_class = status / 100 - 1;
+
+	ret_if(!metrics);
+
+	if (status < 100 || status_class >= METRICS_STATUS_OTHER)
+		status_class = METRICS_STATUS_OTHER;
+
+	if (elapsed_us < 0)
+		elapsed_us = 0;
+
+	metrics->requests[status_class]++;
+	metrics->bytes_out += bytes_out;
+	metrics->buckets[bucket_index(elapsed_us)]++;
+	metrics->elapsed_sum_us += elapsed_us;
+}
+
+static void append_labels(GString *out, const route_metrics *metrics)
+{
+	const char *p = NULL;
+
+	g_string_append_printf(out, "method=\"%s\",route=\"", metrics->method);
+	for (p = metrics->route; *p; p++) {
+		if (*p == '"' || *p == '\\')
+			g_string_append_c(out, '\\');
+		if (*p == '\n')
+			g_string_append(out, "\\n");
+		else
+			g_string_append_c(out, *p);
+	}
+	g_string_append_c(out, '"');
+}
+
+char *route_metrics_dump(void)
+{
+	GString *out = g_string_sized_new(4096);
+	char num[G_ASCII_DTOSTR_BUF_SIZE];
+	guint i = 0;
+	int j = 0;
+
+	if (!g_metrics_order) {
+		append_counters(out);
+		return g_string_free(out, FALSE);
+	}
+
+	g_string_append(out,
+		"# HELP http_server_requests_total Requests by route and status class.\n"
+		"# TYPE http_server_requests_total counter\n");
+	for (i = 0; i < g_metrics_order->len; i++) {
+		const route_metrics *metrics = g_ptr_array_index(g_metrics_order, i);
+
+		for (j = 0; j < METRICS_STATUS_MAX; j++) {
+			if (!metrics->requests[j])
+				continue;
+			g_string_append(out, "http_server_requests_total{");
+			append_labels(out, metrics);
+			g_string_append_printf(out, ",code=\"%s\"} %" G_GUINT64_FORMAT "\n",
+				status_class_str[j], metrics->requests[j]);
+		}
+	}
+
+	g_string_append(out,
+		"# HELP http_server_response_bytes_total Response body bytes by route.\n"
+		"# TYPE http_server_response_bytes_total counter\n");
+	for (i = 0; i < g_metrics_order->len; i++) {
+		const route_metrics *metrics = g_ptr_array_index(g_metrics_order, i);
+
+		g_string_append(out, "http_server_response_bytes_total{");
+		append_labels(out, metrics);
+		g_string_append_printf(out, "} %" G_GUINT64_FORMAT "\n", metrics->bytes_out);
+	}
+
+	g_string_append(out,
+		"# HELP http_server_request_duration_seconds From request read to response finished.\n"
+		"# TYPE http_server_request_duration_seconds histogram\n");
+	for (i = 0; i < g_metrics_order->len; i++) {
+		const route_metrics *metrics = g_ptr_array_index(g_metrics_order, i);
+		guint64 count = 0;
+
+		for (j = 0; j < METRICS_BUCKET_COUNT; j++) {
+			count += metrics->buckets[j];
+
+			g_string_append(out, "http_server_request_duration_seconds_bucket{");
+			append_labels(out, metrics);
+			if (j == METRICS_BUCKET_COUNT - 1)
+				g_string_append(out, ",le=\"+Inf\"}");
+			else
+				g_string_append_printf(out, ",le=\"%s\"}",
+					g_ascii_formatd(num, sizeof(num), "%.6f",
+					(double)(1 << (METRICS_BUCKET_MIN_SHIFT + j)) / G_USEC_PER_SEC));
+			g_string_append_printf(out, " %" G_GUINT64_FORMAT "\n", count);
+		}
+
+		g_string_append(out, "http_server_request_duration_seconds_sum{");
+		append_labels(out, metrics);
+		g_string_append_printf(out, "} %s\n", g_ascii_formatd(num, sizeof(num), "%.6f",
+			(double)metrics->elapsed_sum_us / G_USEC_PER_SEC));
+
+		g_string_append(out, "http_server_request_duration_seconds_count{");
+		append_labels(out, metrics);
+		g_string_append_printf(out, "} %" G_GUINT64_FORMAT "\n", count);
+	}
+
+	append_counters(out);
+
+	return g_string_free(out, FALSE);
+}
@@ -0,0 +1,441 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include "http-server-log-private.h"
+#include "http-server-route-table.h"
+
+struct route_slot {
+	const char *method; /* interned, NULL for any method */
+	gpointer handler;
+};
+
+struct route_node {
+	char *segment;
+	gsize segment_len;
+	char *param_name;
+
+	GPtrArray *children; /* literal children, sorted by segment */
+	struct route_node *param_child;
+
+	GArray *slots; /* handlers for this exact path */
+	GArray *prefix_slots; /* handlers for this path and below ("*") */
+};
+
+struct _route_table {
+	struct route_node *root;
+	GDestroyNotify handler_free;
+};
+
+struct prefix_fallback {
+	const struct route_node *node;
+	unsigned int depth;
+	route_param params[ROUTE_PARAM_MAX];
+	unsigned int n_params;
+};
+
+static struct route_node *route_node_new(void)
+{
+	return g_new0(struct route_node, 1);
+}
+
+static void route_slots_free(GArray *slots, GDestroyNotify handler_free)
+{
+	guint i = 0;
+
+	if (!slots)
+		return;
+
+	if (handler_free) {
+		for (i = 0; i < slots->len; i++)
+			handler_free(g_array_index(slots, struct route_slot, i).handler);
+	}
+	g_array_free(slots, TRUE);
+}
+
+static void route_node_free(struct route_node *node, GDestroyNotify handler_free)
+{
+	guint i = 0;
+
+	if (!node)
+		return;
+
+	if (node->children) {
+		for (i = 0; i < node->children->len; i++)
+			route_node_free(g_ptr_array_index(node->children, i), handler_free);
+		g_ptr_array_free(node->children, TRUE);
+	}
+	route_node_free(node->param_child, handler_free);
+
+	route_slots_free(node->slots, handler_free);
+	route_slots_free(node->prefix_slots, handler_free);
+
+	g_free(node->segment);
+	g_free(node->param_name);
+	g_free(node);
+}
+
+static int segment_cmp(const char *a, gsize a_len, const char *b, gsize b_len)
+{
+	int ret = memcmp(a, b, MIN(a_len, b_len));
+	if (ret)
+		return ret;
+
+	return (a_len > b_len) - (a_len < b_len);
+}
+
+/* returns the index of the child, or the insert position as -(pos + 1) */
+static gint
+literal_child_search(const struct route_node *node, const char *seg, gsize len)
+{
+	gint low = 0;
+	gint high = 0;
+
+	if (!node->children)
+		return -1;
+
+	high = (gint)node->children->len - 1;
+	while (low <= high) {
+		gint mid = (low + high) / 2;
+		const struct route_node *child = g_ptr_array_index(node->children, mid);
+		int cmp = segment_cmp(child->segment, child->segment_len, seg, len);
+
+		if (cmp == 0)
+			return mid;
+		else if (cmp < 0)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+
+	return -(low + 1);
+}
+
+static struct route_node *
+literal_child_get(struct route_node *node, const char *seg, gboolean create)
+{
+	struct route_node *child = NULL;
+	gsize len = strlen(seg);
+	gint idx = literal_child_search(node, seg, len);
+
+	if (idx >= 0)
+		return g_ptr_array_index(node->children, idx);
+
+	if (!create)
+		return NULL;
+
+	if (!node->children)
+		node->children = g_ptr_array_new();
+
+	child = route_node_new();
+	child->segment = g_strndup(seg, len);
+	child->segment_len = len;
+	g_ptr_array_insert(node->children, -(idx + 1), child);
+
+	return child;
+}
+
+static struct route_node *
+route_node_walk(route_table *table, const char *pattern,
+			gboolean create, gboolean *prefix)
+{
+	struct route_node *node = table->root;
+	char **segs = NULL;
+	int i = 0;
+
+	*prefix = FALSE;
+	segs = g_strsplit(pattern, "/", -1);
+	for (i = 0; segs[i] && node; i++) {
+		const char *seg = segs[i];
+
+		if (seg[0] == '\0')
+			continue;
+
+		if (*prefix) {
+			_E("'*' must be the last segment of [%s]", pattern);
+			node = NULL;
+			break;
+		}
+
+		if (0 == strcmp(seg, "*")) {
+			*prefix = TRUE;
+		} else if (seg[0] == ':') {
+			if (!node->param_child) {
+				if (!create) {
+					node = NULL;
+					break;
+				}
+				node->param_child = route_node_new();
+				node->param_child->param_name = g_strdup(seg + 1);
+			} else if (g_strcmp0(node->param_child->param_name, seg + 1)) {
+				_E("param [%s] conflicts with [:%s] in [%s]",
+					seg, node->param_child->param_name, pattern);
+				node = NULL;
+				break;
+			}
+			node = node->param_child;
+		} else {
+			node = literal_child_get(node, seg, create);
+		}
+	}
+	g_strfreev(segs);
+
+	return node;
+}
+
+static struct route_slot *route_slot_find(GArray *slots, const char *method)
+{
+	struct route_slot *any = NULL;
+	guint i = 0;
+
+	if (!slots)
+		return NULL;
+
+	for (i = 0; i < slots->len; i++) {
+		struct route_slot *slot = &g_array_index(slots, struct route_slot, i);
+		if (slot->method == method)
+			return slot;
+		if (!slot->method)
+			any = slot;
+	}
+
+	return any;
+}
+
+route_table *route_table_new(GDestroyNotify handler_free)
+{
+	route_table *table = g_new0(route_table, 1);
+
+	table->root = route_node_new();
+	table->handler_free = handler_free;
+
+	return table;
+}
+
+void route_table_free(route_table *table)
+{
+	if (!table)
+		return;
+
+	route_node_free(table->root, table->handler_free);
+	g_free(table);
+}
+
+int route_table_insert(route_table *table, const char *method,
+				const char *pattern, gpointer handler)
+{
+	struct route_node *node = NULL;
+	struct route_slot slot = { NULL, NULL };
+	GArray **slots = NULL;
+	gboolean prefix = FALSE;
+	guint i = 0;
+
+	retv_if(!table, -1);
+	retv_if(!pattern, -1);
+	retv_if(!handler, -1);
+
+	node = route_node_walk(table, pattern, TRUE, &prefix);
+	retvm_if(!node, -1, "invalid route pattern [%s]", pattern);
+
+	slot.method = method ? g_intern_string(method) : NULL;
+	slot.handler = handler;
+
+	slots = prefix ? &node->prefix_slots : &node->slots;
+	if (!*slots)
+		*slots = g_array_sized_new(FALSE, FALSE, sizeof(struct route_slot), 1);
+
+	for (i = 0; i < (*slots)->len; i++) {
+		retvm_if(g_array_index(*slots, struct route_slot, i).method == slot.method,
+			-1, "route [%s %s] is already registered",
+			method ? method : "*", pattern);
+	}
+	g_array_append_val(*slots, slot);
+
+	return 0;
+}
+
+int route_table_remove(route_table *table, const char *method,
+				const char *pattern)
+{
+	struct route_node *node = NULL;
+	GArray *slots = NULL;
+	const char *imethod = NULL;
+	gboolean prefix = FALSE;
+	guint i = 0;
+
+	retv_if(!table, -1);
+	retv_if(!pattern, -1);
+
+	node = route_node_walk(table, pattern, FALSE, &prefix);
+	retv_if(!node, -1);
+
+	imethod = method ? g_intern_string(method) : NULL;
+	slots = prefix ? node->prefix_slots : node->slots;
+	retv_if(!slots, -1);
+
+	for (i = 0; i < slots->len; i++) {
+		struct route_slot *slot = &g_array_index(slots, struct route_slot, i);
+		if (slot->method != imethod)
+			continue;
+
+		if (table->handler_free)
+			table->handler_free(slot->handler);
+		g_array_remove_index(slots, i);
+		return 0;
+	}
+
+	return -1;
+}
+
+static const struct route_node *
+route_node_lookup(const struct route_node *node, const char *p, unsigned int depth,
+			route_match *match, struct prefix_fallback *fallback)
+{
+	const struct route_node *found = NULL;
+	const char *seg = NULL;
+	gsize len = 0;
+	gint idx = 0;
+
+	if (node->prefix_slots && node->prefix_slots->len
+		&& (!fallback->node || depth >= fallback->depth)) {
+		fallback->node = node;
+		fallback->depth = depth;
+		fallback->n_params = match->n_params;
+		memcpy(fallback->params, match->params,
+			sizeof(route_param) * match->n_params);
+	}
+
+	while (*p == '/')
+		p++;
+
+	if (*p == '\0')
+		return (node->slots && node->slots->len) ? node : NULL;
+
+	seg = p;
+	len = strcspn(p, "/");
+
+	idx = literal_child_search(node, seg, len);
+	if (idx >= 0) {
+		found = route_node_lookup(g_ptr_array_index(node->children, idx),
+					seg + len, depth + 1, match, fallback);
+		if (found)
+			return found;
+	}
+
+	if (node->param_child && match->n_params < ROUTE_PARAM_MAX) {
+		route_param *param = &match->params[match->n_params++];
+
+		param->name = node->param_child->param_name;
+		param->value = seg;
+		param->len = len;
+
+		found = route_node_lookup(node->param_child,
+					seg + len, depth + 1, match, fallback);
+		if (found)
+			return found;
+
+		match->n_params--;
+	}
+
+	return NULL;
+}
+
+route_match_result route_table_lookup(route_table *table, const char *method,
+				const char *path, route_match *match)
+{
+	struct prefix_fallback fallback;
+	const struct route_node *node = NULL;
+	struct route_slot *slot = NULL;
+	GArray *slots = NULL;
+
+	retv_if(!table, ROUTE_MATCH_NOT_FOUND);
+	retv_if(!match, ROUTE_MATCH_NOT_FOUND);
+
+	match->handler = NULL;
+	match->n_params = 0;
+	match->node = NULL;
+	fallback.node = NULL;
+	fallback.depth = 0;
+	fallback.n_params = 0;
+
+	node = route_node_lookup(table->root, path ? path : "/", 0, match, &fallback);
+	if (node) {
+		slots = node->slots;
+	} else if (fallback.node) {
+		slots = fallback.node->prefix_slots;
+		match->n_params = fallback.n_params;
+		memcpy(match->params, fallback.params,
+			sizeof(route_param) * fallback.n_params);
+	} else {
+		return ROUTE_MATCH_NOT_FOUND;
+	}
+
+	match->node = slots;
+	slot = route_slot_find(slots, method);
+	if (!slot)
+		return ROUTE_MATCH_METHOD_NOT_ALLOWED;
+
+	match->handler = slot->handler;
+
+	return ROUTE_MATCH_OK;
+}
+
+char *route_table_match_allowed_methods(const route_match *match)
+{
+	const GArray *slots = NULL;
+	GString *allow = NULL;
+	guint i = 0;
+
+	retv_if(!match, NULL);
+	retv_if(!match->node, NULL);
+
+	slots = match->node;
+	allow = g_string_new(NULL);
+	for (i = 0; i < slots->len; i++) {
+		const struct route_slot *slot =
+			&g_array_index(slots, struct route_slot, i);
+
+		if (!slot->method)
+			continue;
+
+		if (allow->len)
+			g_string_append(allow, ", ");
+		g_string_append(allow, slot->method);
+	}
+
+	return g_string_free(allow, FALSE);
+}
+
+const char *route_match_param_get(const route_match *match,
+				const char *name, gsize *len)
+{
+	unsigned int i = 0;
+
+	retv_if(!match, NULL);
+	retv_if(!name, NULL);
+
+	for (i = 0; i < match->n_params; i++) {
+		if (g_strcmp0(match->params[i].name, name))
+			continue;
+
+		if (len)
+			*len = match->params[i].len;
+		return match->params[i].value;
+	}
+
+	return NULL;
+}
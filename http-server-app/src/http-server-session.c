@@ -0,0 +1,184 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "http-server-log-private.h"
+#include "http-server-session.h"
+
+#define SESSION_KEY_RANDOM_LEN 32
+#define SESSION_KEY_RANDOM_DEV "/dev/urandom"
+#define SESSION_MAC_LEN 32
+#define SESSION_MAC_HEX_LEN (SESSION_MAC_LEN * 2)
+
+struct _session_key {
+	GHmac *hmac; /* keyed, never updated, copied per token */
+};
+
+/* the kernel CSPRNG, g_random_int() is predictable from its output */
+static int session_key_random(guint8 *buf, gsize len)
+{
+	gsize done = 0;
+	int fd = -1;
+
+	fd = open(SESSION_KEY_RANDOM_DEV, O_RDONLY | O_CLOEXEC);
+	retvm_if(fd < 0, -1, "failed to open %s [%d]", SESSION_KEY_RANDOM_DEV, errno);
+
+	while (done < len) {
+		ssize_t r = read(fd, buf + done, len - done);
+
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0) {
+			_E("failed to read %s [%d]", SESSION_KEY_RANDOM_DEV, errno);
+			close(fd);
+			return -1;
+		}
+		done += r;
+	}
+	close(fd);
+
+	return 0;
+}
+
+session_key *session_key_new(const char *key)
+{
+	session_key *skey = NULL;
+	guint8 random_key[SESSION_KEY_RANDOM_LEN];
+	const guint8 *key_data = (const guint8 *)key;
+	gsize key_len = key ? strlen(key) : 0;
+
+	if (!key_len) {
+		retv_if(session_key_random(random_key, sizeof(random_key)), NULL);
+		key_data = random_key;
+		key_len = SESSION_KEY_RANDOM_LEN;
+	}
+
+	skey = g_try_new0(session_key, 1);
+	retvm_if(!skey, NULL, "failed to alloc session_key");
+
+	skey->hmac = g_hmac_new(G_CHECKSUM_SHA256, key_data, key_len);
+	memset(random_key, 0, sizeof(random_key));
+	if (!skey->hmac) {
+		_E("failed to g_hmac_new");
+		g_free(skey);
+		return NULL;
+	}
+
+	return skey;
+}
+
+void session_key_free(session_key *skey)
+{
+	if (!skey)
+		return;
+
+	g_hmac_unref(skey->hmac);
+	g_free(skey);
+}
+
+static void session_mac(const session_key *skey,
+			const char *data, gsize len, guint8 *mac)
+{
+	GHmac *hmac = g_hmac_copy(skey->hmac);
+	gsize mac_len = SESSION_MAC_LEN;
+
+	g_hmac_update(hmac, (const guchar *)data, len);
+	g_hmac_get_digest(hmac, mac, &mac_len);
+	g_hmac_unref(hmac);
+}
+
+char *session_token_issue(const session_key *skey,
+				const char *user, gint64 expiry)
+{
+	guint8 mac[SESSION_MAC_LEN];
+	GString *token = NULL;
+	int i = 0;
+
+	retv_if(!skey, NULL);
+	retv_if(!user, NULL);
+	retv_if(strchr(user, ';') || strchr(user, ' '), NULL);
+
+	token = g_string_sized_new(strlen(user) + 24 + SESSION_MAC_HEX_LEN);
+	g_string_printf(token, "%s:%" G_GINT64_FORMAT, user, expiry);
+
+	session_mac(skey, token->str, token->len, mac);
+
+	g_string_append_c(token, ':');
+	for (i = 0; i < SESSION_MAC_LEN; i++)
+		g_string_append_printf(token, "%02x", mac[i]);
+
+	return g_string_free(token, FALSE);
+}
+
+gboolean session_token_verify(const session_key *skey,
+				const char *token, gsize len, gint64 now, char **user)
+{
+	guint8 mac[SESSION_MAC_LEN];
+	const char *hex = NULL;
+	const char *p = NULL;
+	gint64 expiry = 0;
+	gint64 scale = 1;
+	guint8 diff = 0;
+	gsize signed_len = 0;
+	int i = 0;
+
+	if (!skey || !token)
+		return FALSE;
+
+	/* user(1+) ':' expiry(1+) ':' mac */
+	if (len < SESSION_MAC_HEX_LEN + 4)
+		return FALSE;
+
+	signed_len = len - SESSION_MAC_HEX_LEN - 1;
+	hex = token + signed_len + 1;
+	if (token[signed_len] != ':')
+		return FALSE;
+
+	for (p = token + signed_len - 1; p > token && g_ascii_isdigit(*p); p--) {
+		if (scale > G_MAXINT64 / 10)
+			return FALSE;
+		expiry += (*p - '0') * scale;
+		scale *= 10;
+	}
+	if (*p != ':' || p == token || p == token + signed_len - 1)
+		return FALSE;
+
+	if (expiry <= now)
+		return FALSE;
+
+	session_mac(skey, token, signed_len, mac);
+
+	/* constant time regardless of where the first mismatch is */
+	for (i = 0; i < SESSION_MAC_LEN; i++) {
+		int hi = g_ascii_xdigit_value(hex[i * 2]);
+		int lo = g_ascii_xdigit_value(hex[i * 2 + 1]);
+
+		diff |= (guint8)((hi | lo) >> 8); /* -1 for non hex digits */
+		diff |= mac[i] ^ (guint8)(((guint)hi << 4) | ((guint)lo & 0x0f));
+	}
+
+	if (diff)
+		return FALSE;
+
+	if (user)
+		*user = g_strndup(token, p - token);
+
+	return TRUE;
+}
@@ -21,23 +21,104 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <ifaddrs.h>
 #include <libsoup/soup.h>
 #include <service_app.h>
 #include <app_common.h>
 #include "http-server-log-private.h"
 #include "http-server-route.h"
+#include "http-server-route-table.h"
+#include "http-server-credential.h"
+#include "http-server-session.h"
+#include "http-server-metrics.h"
 
 #define SIGNAL_DEBUG 0
 #define HTDIGEST_FILE "/auth-data/auth-passwd.dat"
+#define SESSION_COOKIE_NAME "hs_session"
+#define SESSION_BEARER_PREFIX "Bearer "
+#define WORKER_THREAD_MAX 2
+#define WORKER_QUEUE_MAX 16 /* queued + running jobs */
+#define WORKER_RETRY_AFTER "1" /* sec */
+#define RESPONSE_CACHE_MAX 64
 
 struct route_callback_data {
 	http_server_route_callback callback;
 	gpointer user_data;
 	GDestroyNotify destroy_func;
+	route_metrics *metrics;
+	gboolean cache;
+	gboolean cache_by_query; /* FALSE if the callback ignores the query */
+	unsigned int cache_ttl; /* sec, 0 until invalidated */
+	char *cache_key;
+};
+
+struct websocket_callback_data {
+	http_server_websocket_callback callback;
+	gpointer user_data;
+	GDestroyNotify destroy_func;
+};
+
+struct cached_response {
+	char *cache_key;
+	gint64 expire_time; /* 0 if it never expires */
+	gint64 used_time; /* stored or last replayed, for the eviction */
+	guint status;
+	char *content_type;
+	SoupBuffer *body;
+};
+
+struct response_capture {
+	char *request_key;
+	char *cache_key;
+	unsigned int ttl;
+	guint generation;
+};
+
+struct request_timing {
+	gint64 read_time;
+	route_metrics *metrics; /* NULL until routed */
+};
+
+struct _http_server_response {
+	guint status;
+	char *content_type;
+	char *body;
+	gsize body_len;
+};
+
+struct worker_job {
+	SoupServer *server;
+	SoupMessage *msg;
+	GMainContext *context;
+	gulong finished_handler;
+	gboolean finished;
+
+	http_server_worker_func func;
+	gpointer user_data;
+	GDestroyNotify destroy;
+
+	http_server_response resp;
 };
 
 static SoupServer *g_server;
 static SoupAuthDomain *default_auth_domain;
+static route_table *g_routes;
+static credential_store *g_credentials;
+static session_key *g_session_key;
+static unsigned int g_session_ttl;
+static GThreadPool *g_worker_pool;
+static unsigned int g_worker_jobs; /* main context only */
+static GHashTable *g_clients; /* set of client SoupSocket, weak */
+static GHashTable *g_response_cache; /* request key -> cached_response */
+static guint g_response_cache_generation; /* bumped by each invalidation */
+static gint64 g_network_changed_time; /* 0 if no handover is pending */
+static gint64 g_handover_time_to_serve = -1;
+
+/* valid only while a route callback runs on the server's main context */
+static SoupMessage *dispatching_msg;
+static const route_match *dispatching_match;
 
 #if SIGNAL_DEBUG
 static void
@@ -69,46 +150,557 @@ request_started_cb(SoupServer *server, SoupMessage *message,
 }
 #endif /* SIGNAL_DEBUG */
 
+static GQuark request_timing_quark(void)
+{
+	static GQuark quark;
+
+	if (!quark)
+		quark = g_quark_from_static_string("http-server-request-timing");
+
+	return quark;
+}
+
+static void request_timing_free(gpointer data)
+{
+	g_slice_free(struct request_timing, data);
+}
+
+static void
+metrics_request_read_cb(SoupServer *server, SoupMessage *message,
+				SoupClientContext *client, gpointer user_data)
+{
+	struct request_timing *timing = g_slice_new(struct request_timing);
+
+	timing->read_time = g_get_monotonic_time();
+	timing->metrics = NULL;
+	g_object_set_qdata_full(G_OBJECT(message), request_timing_quark(),
+				timing, request_timing_free);
+}
+
+/* request-finished and request-aborted, paused handlers are included */
+static void
+metrics_request_done_cb(SoupServer *server, SoupMessage *message,
+				SoupClientContext *client, gpointer user_data)
+{
+	static route_metrics *unrouted;
+	struct request_timing *timing = NULL;
+
+	timing = g_object_steal_qdata(G_OBJECT(message), request_timing_quark());
+	if (!timing)
+		return;
+
+	if (!timing->metrics) {
+		if (!unrouted)
+			unrouted = route_metrics_get(NULL, NULL);
+		timing->metrics = unrouted;
+	}
+
+	route_metrics_record(timing->metrics, message->status_code,
+		message->response_body ? message->response_body->length : 0,
+		g_get_monotonic_time() - timing->read_time);
+	request_timing_free(timing);
+}
+
+static void cached_response_free(gpointer data)
+{
+	struct cached_response *cached = data;
+
+	g_free(cached->cache_key);
+	g_free(cached->content_type);
+	soup_buffer_free(cached->body);
+	g_free(cached);
+}
+
+static GQuark response_capture_quark(void)
+{
+	static GQuark quark;
+
+	if (!quark)
+		quark = g_quark_from_static_string("http-server-response-capture");
+
+	return quark;
+}
+
+static void response_capture_free(gpointer data)
+{
+	struct response_capture *capture = data;
+
+	g_free(capture->request_key);
+	g_free(capture->cache_key);
+	g_free(capture);
+}
+
+/* the method is not part of the key as only GET is cached */
+static char *response_cache_request_key(SoupMessage *msg, const char *path,
+				struct route_callback_data *cd)
+{
+	const char *query = soup_message_get_uri(msg)->query;
+
+	/* any query of a route that ignores it would only take another slot */
+	if (!cd->cache_by_query || !query)
+		return g_strdup(path);
+
+	return g_strconcat(path, "?", query, NULL);
+}
+
+static gboolean cached_response_is_expired(struct cached_response *cached, gint64 now)
+{
+	return cached->expire_time && cached->expire_time <= now;
+}
+
+static gboolean
+cached_response_expired_cb(gpointer key, gpointer value, gpointer user_data)
+{
+	return cached_response_is_expired(value, *(gint64 *)user_data);
+}
+
+/* makes room for one more response, the expired ones go first */
+static void response_cache_evict(gint64 now)
+{
+	GHashTableIter iter;
+	gpointer key = NULL;
+	gpointer value = NULL;
+	gpointer lru_key = NULL;
+	gint64 lru_time = G_MAXINT64;
+
+	if (g_hash_table_foreach_remove(g_response_cache,
+			cached_response_expired_cb, &now))
+		return;
+
+	g_hash_table_iter_init(&iter, g_response_cache);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		struct cached_response *cached = value;
+
+		if (cached->used_time < lru_time) {
+			lru_time = cached->used_time;
+			lru_key = key;
+		}
+	}
+
+	if (lru_key)
+		g_hash_table_remove(g_response_cache, lru_key);
+}
+
+/* answers msg from the cache, the route callback is not called on a hit */
+static gboolean response_cache_replay(SoupMessage *msg, const char *path,
+				struct route_callback_data *cd)
+{
+	struct cached_response *cached = NULL;
+	char *request_key = NULL;
+	gint64 now = g_get_monotonic_time();
+
+	request_key = response_cache_request_key(msg, path, cd);
+	cached = g_hash_table_lookup(g_response_cache, request_key);
+	if (cached && cached_response_is_expired(cached, now)) {
+		g_hash_table_remove(g_response_cache, request_key);
+		cached = NULL;
+	}
+	g_free(request_key);
+
+	if (!cached)
+		return FALSE;
+
+	cached->used_time = now;
+
+	if (cached->content_type)
+		soup_message_headers_set_content_type(msg->response_headers,
+				cached->content_type, NULL);
+	/* the buffer is not temporary, so this only takes a reference */
+	soup_message_body_append_buffer(msg->response_body, cached->body);
+	soup_message_set_status(msg, cached->status);
+
+	return TRUE;
+}
+
+static void response_cache_watch(SoupMessage *msg, const char *path,
+				struct route_callback_data *cd)
+{
+	struct response_capture *capture = NULL;
+
+	if (msg->method != SOUP_METHOD_GET)
+		return;
+
+	capture = g_new0(struct response_capture, 1);
+	capture->request_key = response_cache_request_key(msg, path, cd);
+	capture->cache_key = g_strdup(cd->cache_key);
+	capture->ttl = cd->cache_ttl;
+	capture->generation = g_response_cache_generation;
+	g_object_set_qdata_full(G_OBJECT(msg), response_capture_quark(),
+				capture, response_capture_free);
+}
+
+/* a watched response is stored once it is complete, deferred ones included */
+static void
+response_cache_request_finished_cb(SoupServer *server, SoupMessage *message,
+				SoupClientContext *client, gpointer user_data)
+{
+	struct response_capture *capture = NULL;
+	struct cached_response *cached = NULL;
+	gint64 now = 0;
+
+	capture = g_object_steal_qdata(G_OBJECT(message), response_capture_quark());
+	if (!capture)
+		return;
+
+	/* built before an invalidation, it may already be stale */
+	if (message->status_code != SOUP_STATUS_OK
+		|| capture->generation != g_response_cache_generation) {
+		response_capture_free(capture);
+		return;
+	}
+
+	now = g_get_monotonic_time();
+	if (g_hash_table_size(g_response_cache) >= RESPONSE_CACHE_MAX
+		&& !g_hash_table_contains(g_response_cache, capture->request_key))
+		response_cache_evict(now);
+
+	cached = g_new0(struct cached_response, 1);
+	cached->cache_key = g_steal_pointer(&capture->cache_key);
+	if (capture->ttl)
+		cached->expire_time = now + (gint64)capture->ttl * G_USEC_PER_SEC;
+	cached->used_time = now;
+	cached->status = message->status_code;
+	cached->content_type = g_strdup(soup_message_headers_get_content_type(
+				message->response_headers, NULL));
+	cached->body = soup_message_body_flatten(message->response_body);
+
+	g_hash_table_replace(g_response_cache,
+			g_steal_pointer(&capture->request_key), cached);
+	response_capture_free(capture);
+}
+
+static void
+response_cache_request_aborted_cb(SoupServer *server, SoupMessage *message,
+				SoupClientContext *client, gpointer user_data)
+{
+	g_object_set_qdata(G_OBJECT(message), response_capture_quark(), NULL);
+}
+
+static gboolean
+cached_response_has_key(gpointer key, gpointer value, gpointer user_data)
+{
+	struct cached_response *cached = value;
+
+	return !g_strcmp0(cached->cache_key, user_data);
+}
+
 static char *
 digest_auth_cb(SoupAuthDomain *domain, SoupMessage *msg,
 	const char *username, gpointer user_data)
 {
-	char *res_path = NULL;
-	char *digest_path = NULL;
-	GKeyFile *key_file = NULL;
-	char *password = NULL;
+	credential_store *store = user_data;
 
 	_D("requested user - [%s]", username);
 
-	res_path = app_get_resource_path();
-	digest_path = g_strdup_printf("%s%s", res_path, HTDIGEST_FILE);
-	g_clear_pointer(&res_path, g_free);
+	return credential_store_lookup(store,
+				soup_auth_domain_get_realm(domain), username);
+}
+
+static const char *
+session_token_get(SoupMessage *msg, gsize *len)
+{
+	const char *value = NULL;
+	const char *p = NULL;
+
+	value = soup_message_headers_get_one(msg->request_headers, "Authorization");
+	if (value && g_str_has_prefix(value, SESSION_BEARER_PREFIX)) {
+		value += strlen(SESSION_BEARER_PREFIX);
+		*len = strlen(value);
+		return value;
+	}
+
+	value = soup_message_headers_get_one(msg->request_headers, "Cookie");
+	for (p = value; p && *p; ) {
+		while (*p == ' ')
+			p++;
+
+		if (g_str_has_prefix(p, SESSION_COOKIE_NAME "=")) {
+			p += strlen(SESSION_COOKIE_NAME "=");
+			*len = strcspn(p, ";");
+			return p;
+		}
+
+		p = strchr(p, ';');
+		if (p)
+			p++;
+	}
+
+	return NULL;
+}
+
+/* the user of a valid token must still be in the htdigest file */
+static gboolean session_is_valid(SoupAuthDomain *domain, SoupMessage *msg)
+{
+	const char *token = NULL;
+	char *user = NULL;
+	char *ha1 = NULL;
+	gboolean known = FALSE;
+	gsize len = 0;
+
+	if (!g_session_key)
+		return FALSE;
+
+	token = session_token_get(msg, &len);
+	if (!token)
+		return FALSE;
+
+	if (!session_token_verify(g_session_key, token, len,
+				g_get_real_time() / G_USEC_PER_SEC, &user))
+		return FALSE;
+
+	ha1 = credential_store_lookup(g_credentials,
+				soup_auth_domain_get_realm(domain), user);
+	known = ha1 != NULL;
+	if (!known)
+		_D("session user [%s] is removed", user);
+	g_free(user);
+	g_free(ha1);
+
+	return known;
+}
+
+/* TRUE when the message still has to pass the digest auth */
+static gboolean
+session_auth_filter(SoupAuthDomain *domain, SoupMessage *msg, gpointer user_data)
+{
+	return !session_is_valid(domain, msg);
+}
+
+static void session_cookie_issue(SoupMessage *msg, const char *user)
+{
+	char *token = NULL;
+	char *cookie = NULL;
+
+	token = session_token_issue(g_session_key, user,
+			g_get_real_time() / G_USEC_PER_SEC + g_session_ttl);
+	ret_if(!token);
+
+	cookie = g_strdup_printf("%s=%s; Path=/; Max-Age=%u; HttpOnly; SameSite=Strict",
+				SESSION_COOKIE_NAME, token, g_session_ttl);
+	soup_message_headers_append(msg->response_headers, "Set-Cookie", cookie);
+
+	g_free(cookie);
+	g_free(token);
+}
+
+static void client_socket_weak_notify(gpointer data, GObject *where_the_object_was)
+{
+	if (g_clients)
+		g_hash_table_remove(g_clients, where_the_object_was);
+}
+
+static void
+client_request_started_cb(SoupServer *server, SoupMessage *message,
+				SoupClientContext *client, gpointer user_data)
+{
+	SoupSocket *sock = soup_client_context_get_socket(client);
+
+	if (!sock || g_hash_table_contains(g_clients, sock))
+		return;
+
+	g_hash_table_add(g_clients, sock);
+	g_object_weak_ref(G_OBJECT(sock), client_socket_weak_notify, NULL);
+}
+
+static void
+client_request_finished_cb(SoupServer *server, SoupMessage *message,
+				SoupClientContext *client, gpointer user_data)
+{
+	if (!g_network_changed_time)
+		return;
+
+	if (!SOUP_STATUS_IS_SUCCESSFUL(message->status_code))
+		return;
+
+	g_handover_time_to_serve = g_get_monotonic_time() - g_network_changed_time;
+	g_network_changed_time = 0;
+	_I("time to serve after network change : %" G_GINT64_FORMAT " us",
+		g_handover_time_to_serve);
+}
+
+static gboolean
+local_address_exists(const struct ifaddrs *ifaddrs, const struct sockaddr *sa)
+{
+	const struct ifaddrs *ifa = NULL;
+
+	for (ifa = ifaddrs; ifa; ifa = ifa->ifa_next) {
+		if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != sa->sa_family)
+			continue;
+
+		if (sa->sa_family == AF_INET) {
+			const struct sockaddr_in *a = (const struct sockaddr_in *)sa;
+			const struct sockaddr_in *b = (const struct sockaddr_in *)ifa->ifa_addr;
+			if (a->sin_addr.s_addr == b->sin_addr.s_addr)
+				return TRUE;
+		} else if (sa->sa_family == AF_INET6) {
+			const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)sa;
+			const struct sockaddr_in6 *b = (const struct sockaddr_in6 *)ifa->ifa_addr;
+			if (!memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)))
+				return TRUE;
+		} else {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void _route_callback_data_free(gpointer data)
+{
+	struct route_callback_data *cd = data;
+	if (cd->destroy_func)
+		cd->destroy_func(cd->user_data);
+
+	g_free(cd->cache_key);
+	g_free(cd);
+}
+
+static void
+_http_server_callback(SoupServer *server, SoupMessage *msg,
+					const char *path, GHashTable *query,
+					SoupClientContext *client, gpointer user_data)
+{
+	struct route_callback_data *cd = NULL;
+	struct request_timing *timing = NULL;
+	route_match match;
+	route_match_result result;
+
+	_D("client : %s", soup_client_context_get_host(client));
+	_D("METHOD(%s) PATH(%s) URI_PATH(%s) HTTP/1.%d",
+		msg->method, path, soup_message_get_uri(msg)->path,
+		soup_message_get_http_version(msg));
+
+	result = route_table_lookup(g_routes, msg->method, path, &match);
+	if (result == ROUTE_MATCH_METHOD_NOT_ALLOWED
+		&& msg->method == SOUP_METHOD_HEAD)
+		result = route_table_lookup(g_routes, SOUP_METHOD_GET, path, &match);
+
+	switch (result) {
+	case ROUTE_MATCH_OK:
+		break;
+	case ROUTE_MATCH_METHOD_NOT_ALLOWED: {
+		char *allow = route_table_match_allowed_methods(&match);
+		if (allow) {
+			soup_message_headers_replace(msg->response_headers, "Allow", allow);
+			g_free(allow);
+		}
+		soup_message_set_status(msg, SOUP_STATUS_METHOD_NOT_ALLOWED);
+		return;
+	}
+	case ROUTE_MATCH_NOT_FOUND:
+	default:
+		soup_message_set_status(msg, SOUP_STATUS_NOT_FOUND);
+		return;
+	}
+
+	cd = match.handler;
+	ret_if(!cd->callback);
+
+	timing = g_object_get_qdata(G_OBJECT(msg), request_timing_quark());
+	if (timing)
+		timing->metrics = cd->metrics;
+
+	/* only set when the digest auth has just passed, not for a valid session */
+	if (g_session_key && soup_client_context_get_auth_user(client))
+		session_cookie_issue(msg, soup_client_context_get_auth_user(client));
 
-	key_file = g_key_file_new();
-	if (!g_key_file_load_from_file(key_file,
-			digest_path, G_KEY_FILE_NONE, NULL)) {
-		_E("failed to load htdigest file");
-		return NULL;
+	if (cd->cache) {
+		if (response_cache_replay(msg, path, cd))
+			return;
+		response_cache_watch(msg, path, cd);
 	}
-	g_clear_pointer(&digest_path, g_free);
 
-	password = g_key_file_get_string(key_file,
-					soup_auth_domain_get_realm(domain), username, NULL);
+	dispatching_msg = msg;
+	dispatching_match = &match;
+
+	cd->callback(msg, path, query, client, cd->user_data);
+
+	dispatching_msg = NULL;
+	dispatching_match = NULL;
+}
+
+static void worker_job_free(struct worker_job *job)
+{
+	if (job->destroy)
+		job->destroy(job->user_data);
 
-	g_key_file_unref(key_file);
+	g_signal_handler_disconnect(job->msg, job->finished_handler);
+	g_object_unref(job->msg);
+	g_object_unref(job->server);
+	g_main_context_unref(job->context);
 
-	return password;
+	g_free(job->resp.content_type);
+	g_free(job->resp.body);
+	g_free(job);
+}
+
+static void worker_msg_finished_cb(SoupMessage *msg, gpointer user_data)
+{
+	struct worker_job *job = user_data;
+
+	/* client is gone while the job is queued or running */
+	job->finished = TRUE;
+}
+
+static gboolean worker_job_finish_cb(gpointer data)
+{
+	struct worker_job *job = data;
+	SoupMessage *msg = job->msg;
+
+	g_worker_jobs--;
+
+	if (!job->finished) {
+		soup_message_set_status(msg, job->resp.status);
+		if (job->resp.body) {
+			if (job->resp.content_type)
+				soup_message_headers_set_content_type(msg->response_headers,
+						job->resp.content_type, NULL);
+			soup_message_body_append(msg->response_body, SOUP_MEMORY_TAKE,
+						job->resp.body, job->resp.body_len);
+			job->resp.body = NULL;
+		}
+		soup_server_unpause_message(job->server, msg);
+	}
+	worker_job_free(job);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void worker_job_run(gpointer data, gpointer pool_data)
+{
+	struct worker_job *job = data;
+	GSource *source = NULL;
+
+	job->func(&job->resp, job->user_data);
+
+	source = g_idle_source_new();
+	g_source_set_callback(source, worker_job_finish_cb, job, NULL);
+	g_source_attach(source, job->context);
+	g_source_unref(source);
 }
 
 static int auth_domain_create(SoupServer *server)
 {
 	SoupAuthDomain *sad = NULL;
+	char *res_path = NULL;
+	char *digest_path = NULL;
 	retv_if(!server, -1);
 
+	if (!g_credentials) {
+		res_path = app_get_resource_path();
+		digest_path = g_strdup_printf("%s%s", res_path, HTDIGEST_FILE);
+		g_clear_pointer(&res_path, g_free);
+
+		g_credentials = credential_store_new(digest_path);
+		g_clear_pointer(&digest_path, g_free);
+		retvm_if(!g_credentials, -1, "failed to load credentials");
+	}
+
 	sad = soup_auth_domain_digest_new(SOUP_AUTH_DOMAIN_REALM, "default", NULL);
 	retvm_if(!sad, -1, "failed to soup_auth_domain_digest_new");
 
-	soup_auth_domain_digest_set_auth_callback(sad, digest_auth_cb, NULL, NULL);
+	soup_auth_domain_digest_set_auth_callback(sad, digest_auth_cb, g_credentials, NULL);
+	soup_auth_domain_set_filter(sad, session_auth_filter, NULL, NULL);
 	soup_server_add_auth_domain(server, sad);
 	default_auth_domain = sad;
 
@@ -118,12 +710,18 @@ static int auth_domain_create(SoupServer *server)
 int http_server_create(const char *name, unsigned int port)
 {
 	SoupServer *s = NULL;
+	SoupAddress *any = NULL;
 
 	retv_if(!name, -1);
 	retvm_if(g_server, -1, "server is already created");
 
+	/* wildcard listener stays valid whichever interface comes and goes */
+	any = soup_address_new_any(SOUP_ADDRESS_FAMILY_IPV4, port);
+	retvm_if(!any, -1, "failed to soup_address_new_any");
+
 	s = soup_server_new(SOUP_SERVER_SERVER_HEADER, name,
-						SOUP_SERVER_PORT, port, NULL);
+						SOUP_SERVER_INTERFACE, any, NULL);
+	g_object_unref(any);
 	retvm_if(!s, -1, "failed to soup_server_new");
 
 #if SIGNAL_DEBUG
@@ -133,12 +731,40 @@ int http_server_create(const char *name, unsigned int port)
 	g_signal_connect(s, "request-started", G_CALLBACK(request_started_cb), NULL);
 #endif /* SIGNAL_DEBUG */
 
+	g_worker_pool = g_thread_pool_new(worker_job_run, NULL,
+				WORKER_THREAD_MAX, FALSE, NULL);
+	if (!g_worker_pool) {
+		_E("failed to create worker pool");
+		g_object_unref(s);
+		return -1;
+	}
+
 	if (auth_domain_create(s)) {
 		_E("failed to auth_domain_create()");
+		g_thread_pool_free(g_worker_pool, TRUE, FALSE);
+		g_worker_pool = NULL;
 		g_object_unref(s);
 		return -1;
 	}
 
+	g_routes = route_table_new(_route_callback_data_free);
+	soup_server_add_handler(s, NULL, _http_server_callback, NULL, NULL);
+
+	g_clients = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_signal_connect(s, "request-started", G_CALLBACK(client_request_started_cb), NULL);
+	g_signal_connect(s, "request-finished", G_CALLBACK(client_request_finished_cb), NULL);
+
+	g_signal_connect(s, "request-read", G_CALLBACK(metrics_request_read_cb), NULL);
+	g_signal_connect(s, "request-finished", G_CALLBACK(metrics_request_done_cb), NULL);
+	g_signal_connect(s, "request-aborted", G_CALLBACK(metrics_request_done_cb), NULL);
+
+	g_response_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+				g_free, cached_response_free);
+	g_signal_connect(s, "request-finished",
+			G_CALLBACK(response_cache_request_finished_cb), NULL);
+	g_signal_connect(s, "request-aborted",
+			G_CALLBACK(response_cache_request_aborted_cb), NULL);
+
 	g_server = s;
 
 	return 0;
@@ -146,17 +772,35 @@ int http_server_create(const char *name, unsigned int port)
 
 void http_server_destroy(void)
 {
+	GHashTableIter iter;
+	gpointer sock = NULL;
+
 	if (!g_server)
 		return;
 
+	g_hash_table_iter_init(&iter, g_clients);
+	while (g_hash_table_iter_next(&iter, &sock, NULL))
+		g_object_weak_unref(G_OBJECT(sock), client_socket_weak_notify, NULL);
+	g_clear_pointer(&g_clients, g_hash_table_destroy);
+
 	soup_server_disconnect(g_server);
 
+	/* let queued jobs run, their results are dropped on the finished msg */
+	if (g_worker_pool) {
+		g_thread_pool_free(g_worker_pool, FALSE, TRUE);
+		g_worker_pool = NULL;
+	}
+
 	if (default_auth_domain)
 		g_object_unref(default_auth_domain);
 	default_auth_domain = NULL;
 
 	g_object_unref(g_server);
 	g_server = NULL;
+
+	g_clear_pointer(&g_routes, route_table_free);
+	g_clear_pointer(&g_response_cache, g_hash_table_destroy);
+	g_clear_pointer(&g_credentials, credential_store_free);
 }
 
 int http_server_start(void)
@@ -177,35 +821,85 @@ int http_server_stop(void)
 	return 0;
 }
 
-static void _route_callback_data_free(gpointer data)
+char *http_server_metrics_dump(void)
 {
-	struct route_callback_data *cd = data;
-	if (cd->destroy_func)
-		cd->destroy_func(cd->user_data);
+	return route_metrics_dump();
+}
 
-	g_free(cd);
+int http_server_network_changed(void)
+{
+	struct ifaddrs *ifaddrs = NULL;
+	GPtrArray *stale = NULL;
+	GHashTableIter iter;
+	gpointer sock = NULL;
+	guint i = 0;
+
+	retvm_if(!g_server, -1, "server is NOT created");
+
+	g_network_changed_time = g_get_monotonic_time();
+
+	retvm_if(getifaddrs(&ifaddrs) == -1, -1,
+		"failed to getifaddrs - %d", errno);
+
+	/* the listener is on the wildcard address, only clients can be stale */
+	stale = g_ptr_array_new_with_free_func(g_object_unref);
+	g_hash_table_iter_init(&iter, g_clients);
+	while (g_hash_table_iter_next(&iter, &sock, NULL)) {
+		SoupAddress *local = soup_socket_get_local_address(sock);
+		struct sockaddr *sa = NULL;
+		int len = 0;
+
+		if (!local)
+			continue;
+
+		sa = soup_address_get_sockaddr(local, &len);
+		if (sa && !local_address_exists(ifaddrs, sa))
+			g_ptr_array_add(stale, g_object_ref(sock));
+	}
+	freeifaddrs(ifaddrs);
+
+	for (i = 0; i < stale->len; i++)
+		soup_socket_disconnect(g_ptr_array_index(stale, i));
+
+	_D("network changed, %u of %u client(s) disconnected",
+		stale->len, g_hash_table_size(g_clients));
+	g_ptr_array_free(stale, TRUE);
+
+	return 0;
 }
 
-static void
-_http_server_callback(SoupServer *server, SoupMessage *msg,
-					const char *path, GHashTable *query,
-					SoupClientContext *client, gpointer user_data)
+gint64 http_server_handover_time_to_serve(void)
 {
-	struct route_callback_data *cd = user_data;
+	return g_handover_time_to_serve;
+}
 
-	ret_if(!cd);
-	ret_if(!cd->callback);
+int http_server_session_enable(const char *key, unsigned int ttl_sec)
+{
+	session_key *skey = NULL;
 
-	_D("client : %s", soup_client_context_get_host(client));
-	_D("METHOD(%s) PATH(%s) URI_PATH(%s) HTTP/1.%d",
-		msg->method, path, soup_message_get_uri(msg)->path,
-		soup_message_get_http_version(msg));
+	retvm_if(ttl_sec == 0, -1, "ttl_sec is 0");
 
-	cd->callback(msg, path, query, client, cd->user_data);
+	skey = session_key_new(key);
+	retv_if(!skey, -1);
+
+	g_clear_pointer(&g_session_key, session_key_free);
+	g_session_key = skey;
+	g_session_ttl = ttl_sec;
+
+	return 0;
 }
 
-int http_server_route_handler_add(const char *path, http_server_route_callback callback,
-						gpointer user_data, GDestroyNotify destroy)
+void http_server_session_disable(void)
+{
+	g_clear_pointer(&g_session_key, session_key_free);
+	g_session_ttl = 0;
+}
+
+static int
+_http_server_route_insert(const char *method, const char *pattern,
+			http_server_route_callback callback,
+			gpointer user_data, GDestroyNotify destroy,
+			struct route_callback_data **inserted)
 {
 	struct route_callback_data *cd = NULL;
 	retvm_if(!g_server, -1, "server is NOT created");
@@ -216,19 +910,154 @@ int http_server_route_handler_add(const char *path, http_server_route_callback c
 	cd->callback = callback;
 	cd->user_data = user_data;
 	cd->destroy_func = destroy;
+	cd->metrics = route_metrics_get(method, pattern);
+
+	if (route_table_insert(g_routes, method, pattern, cd)) {
+		g_free(cd);
+		return -1;
+	}
 
-	soup_server_add_handler(g_server, path,
-			_http_server_callback, cd, _route_callback_data_free);
+	if (inserted)
+		*inserted = cd;
 
 	return 0;
 }
 
+int http_server_route_handler_add(const char *path, http_server_route_callback callback,
+						gpointer user_data, GDestroyNotify destroy)
+{
+	int ret = 0;
+	char *pattern = NULL;
+
+	/* same as soup_server_add_handler() : any method, the path and below */
+	pattern = g_strdup_printf("%s/*", path ? path : "");
+	ret = _http_server_route_insert(NULL, pattern, callback, user_data, destroy, NULL);
+	g_free(pattern);
+
+	return ret;
+}
+
 int http_server_route_handler_remove(const char *path)
 {
+	int ret = 0;
+	char *pattern = NULL;
+
+	retvm_if(!g_server, -1, "server is NOT created");
+	retvm_if(!path, -1, "path is NULL");
+
+	pattern = g_strdup_printf("%s/*", path);
+	ret = route_table_remove(g_routes, NULL, pattern);
+	g_free(pattern);
+
+	return ret;
+}
+
+int http_server_route_add(const char *method, const char *route_path,
+				http_server_route_callback callback,
+				gpointer user_data, GDestroyNotify destroy)
+{
+	retvm_if(!method, -1, "method is NULL");
+	retvm_if(!route_path, -1, "route_path is NULL");
+
+	return _http_server_route_insert(method, route_path,
+				callback, user_data, destroy, NULL);
+}
+
+int http_server_route_add_cached(const char *route_path,
+				unsigned int ttl_sec, const char *cache_key, gboolean by_query,
+				http_server_route_callback callback,
+				gpointer user_data, GDestroyNotify destroy)
+{
+	struct route_callback_data *cd = NULL;
+	int ret = 0;
+
+	retvm_if(!route_path, -1, "route_path is NULL");
+
+	ret = _http_server_route_insert(SOUP_METHOD_GET, route_path,
+				callback, user_data, destroy, &cd);
+	retv_if(ret, ret);
+
+	cd->cache = TRUE;
+	cd->cache_by_query = by_query;
+	cd->cache_ttl = ttl_sec;
+	cd->cache_key = g_strdup(cache_key ? cache_key : route_path);
+
+	return 0;
+}
+
+void http_server_route_cache_invalidate(const char *cache_key)
+{
+	guint removed = 0;
+
+	ret_if(!g_response_cache);
+	ret_if(!cache_key);
+
+	g_response_cache_generation++;
+	removed = g_hash_table_foreach_remove(g_response_cache,
+				cached_response_has_key, (gpointer)cache_key);
+	if (removed)
+		_D("[%s] %u cached responses dropped", cache_key, removed);
+}
+
+int http_server_route_remove(const char *method, const char *route_path)
+{
+	retvm_if(!g_server, -1, "server is NOT created");
+	retvm_if(!method, -1, "method is NULL");
+	retvm_if(!route_path, -1, "route_path is NULL");
+
+	return route_table_remove(g_routes, method, route_path);
+}
+
+const char *http_server_route_param_get(SoupMessage *msg,
+				const char *name, gsize *len)
+{
+	retv_if(!msg, NULL);
+	retvm_if(msg != dispatching_msg, NULL, "msg is NOT in dispatch");
+
+	return route_match_param_get(dispatching_match, name, len);
+}
+
+static void _websocket_callback_data_free(gpointer data)
+{
+	struct websocket_callback_data *wd = data;
+
+	if (wd->destroy_func)
+		wd->destroy_func(wd->user_data);
+
+	g_free(wd);
+}
+
+static void
+_http_server_websocket_callback(SoupServer *server,
+					SoupWebsocketConnection *connection, const char *path,
+					SoupClientContext *client, gpointer user_data)
+{
+	struct websocket_callback_data *wd = user_data;
+
+	_D("websocket client : %s PATH(%s)", soup_client_context_get_host(client), path);
+
+	wd->callback(connection, path, client, wd->user_data);
+}
+
+int http_server_websocket_add(const char *path,
+				http_server_websocket_callback callback,
+				gpointer user_data, GDestroyNotify destroy)
+{
+	struct websocket_callback_data *wd = NULL;
+
 	retvm_if(!g_server, -1, "server is NOT created");
 	retvm_if(!path, -1, "path is NULL");
+	retvm_if(!callback, -1, "callback is NULL");
+
+	wd = g_new0(struct websocket_callback_data, 1);
+	wd->callback = callback;
+	wd->user_data = user_data;
+	wd->destroy_func = destroy;
+
+	/* any origin, the auth domain already guards the upgrade request */
+	soup_server_add_websocket_handler(g_server, path, NULL, NULL,
+			_http_server_websocket_callback, wd, _websocket_callback_data_free);
 
-	soup_server_remove_handler(g_server, path);
 	return 0;
 }
 
@@ -250,6 +1079,78 @@ int http_server_unpause_message(SoupMessage *msg)
 	return 0;
 }
 
+int http_server_defer_to_worker(SoupMessage *msg,
+				http_server_worker_func func,
+				gpointer user_data, GDestroyNotify destroy)
+{
+	struct worker_job *job = NULL;
+
+	retvm_if(!g_server, -1, "server is NOT created");
+	retvm_if(!g_worker_pool, -1, "worker pool is NOT created");
+	retvm_if(!msg, -1, "msg is NULL");
+	retvm_if(!func, -1, "func is NULL");
+
+	if (g_worker_jobs >= WORKER_QUEUE_MAX) {
+		_W("worker queue is full [%u]", g_worker_jobs);
+		soup_message_headers_replace(msg->response_headers,
+				"Retry-After", WORKER_RETRY_AFTER);
+		soup_message_set_status(msg, SOUP_STATUS_SERVICE_UNAVAILABLE);
+		return -1;
+	}
+
+	job = g_try_new0(struct worker_job, 1);
+	if (!job) {
+		_E("failed to alloc worker_job");
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		return -1;
+	}
+
+	job->server = g_object_ref(g_server);
+	job->msg = g_object_ref(msg);
+	job->context = g_main_context_ref_thread_default();
+	job->func = func;
+	job->user_data = user_data;
+	job->destroy = destroy;
+	job->resp.status = SOUP_STATUS_INTERNAL_SERVER_ERROR;
+	job->finished_handler = g_signal_connect(msg, "finished",
+				G_CALLBACK(worker_msg_finished_cb), job);
+
+	soup_server_pause_message(g_server, msg);
+	g_worker_jobs++;
+
+	if (!g_thread_pool_push(g_worker_pool, job, NULL)) {
+		_E("failed to push worker job");
+		g_worker_jobs--;
+		soup_server_unpause_message(g_server, msg);
+		soup_message_set_status(msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+		job->destroy = NULL;
+		worker_job_free(job);
+		return -1;
+	}
+
+	return 0;
+}
+
+void http_server_response_set_status(http_server_response *resp, guint status)
+{
+	ret_if(!resp);
+
+	resp->status = status;
+}
+
+void http_server_response_take_body(http_server_response *resp,
+				const char *content_type, char *body, gsize len)
+{
+	ret_if(!resp);
+
+	g_free(resp->content_type);
+	resp->content_type = g_strdup(content_type);
+
+	g_free(resp->body);
+	resp->body = body;
+	resp->body_len = len;
+}
+
 int http_server_auth_default_realm_path_add(const char *path)
 {
 	retvm_if(!g_server, -1, "server is NOT created");
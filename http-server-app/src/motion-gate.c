@@ -0,0 +1,110 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include "http-server-log-private.h"
+#include "pixel-kernels.h"
+#include "motion-gate.h"
+
+#define MOTION_GATE_SCALE 4 /* a cell is a 4x4 box of the plane */
+#define MOTION_GATE_BG_SHIFT 4 /* background takes 1/16 of every frame */
+#define MOTION_GATE_PIXEL_DEFAULT 12
+#define MOTION_GATE_AREA_DEFAULT 10 /* permille */
+
+struct _motion_gate {
+	unsigned int width; /* of the plane */
+	unsigned int height;
+	unsigned int cols; /* of the downscaled cells */
+	unsigned int rows;
+	unsigned int pixel_threshold;
+	unsigned int area_threshold; /* moving cells */
+	unsigned char *cells; /* current frame */
+	guint16 *background; /* luma << MOTION_GATE_BG_SHIFT */
+	bool primed;
+};
+
+motion_gate *motion_gate_new(unsigned int width, unsigned int height)
+{
+	motion_gate *gate = NULL;
+
+	retvm_if(width < MOTION_GATE_SCALE || height < MOTION_GATE_SCALE, NULL,
+		"plane is too small [%ux%u]", width, height);
+
+	gate = g_new0(motion_gate, 1);
+	gate->width = width;
+	gate->height = height;
+	gate->cols = width / MOTION_GATE_SCALE;
+	gate->rows = height / MOTION_GATE_SCALE;
+	gate->cells = g_malloc(gate->cols * gate->rows);
+	gate->background = g_new(guint16, gate->cols * gate->rows);
+	motion_gate_set_threshold(gate, MOTION_GATE_PIXEL_DEFAULT, MOTION_GATE_AREA_DEFAULT);
+
+	return gate;
+}
+
+void motion_gate_free(motion_gate *gate)
+{
+	ret_if(!gate);
+
+	g_free(gate->cells);
+	g_free(gate->background);
+	g_free(gate);
+}
+
+void motion_gate_set_threshold(motion_gate *gate, unsigned int pixel, unsigned int area_permille)
+{
+	ret_if(!gate);
+
+	gate->pixel_threshold = pixel;
+	gate->area_threshold = gate->cols * gate->rows * area_permille / 1000;
+	if (!gate->area_threshold)
+		gate->area_threshold = 1;
+}
+
+bool motion_gate_check(motion_gate *gate, const unsigned char *plane,
+		unsigned int width, unsigned int height)
+{
+	unsigned int n_cells = 0;
+	unsigned int moving = 0;
+	unsigned int i = 0;
+
+	retv_if(!gate || !plane, true);
+	retvm_if(width != gate->width || height != gate->height, true,
+		"plane [%ux%u] is not [%ux%u]", width, height, gate->width, gate->height);
+
+	n_cells = gate->cols * gate->rows;
+	pixel_downscale_4x(plane, gate->width, gate->cols * MOTION_GATE_SCALE,
+		gate->rows * MOTION_GATE_SCALE, gate->cells, gate->cols);
+
+	if (!gate->primed) {
+		for (i = 0; i < n_cells; i++)
+			gate->background[i] = gate->cells[i] << MOTION_GATE_BG_SHIFT;
+		gate->primed = true;
+		return true;
+	}
+
+	for (i = 0; i < n_cells; i++) {
+		unsigned int bg = gate->background[i];
+
+		if ((unsigned int)abs(gate->cells[i] - (int)(bg >> MOTION_GATE_BG_SHIFT)) > gate->pixel_threshold)
+			moving++;
+
+		gate->background[i] = bg + gate->cells[i] - (bg >> MOTION_GATE_BG_SHIFT);
+	}
+
+	return moving >= gate->area_threshold;
+}
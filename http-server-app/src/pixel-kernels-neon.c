@@ -0,0 +1,189 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include "pixel-kernels-internal.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+#if defined(__arm__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+/* 16 bit lanes take 128 pair sums of bytes before they may overflow */
+#define NEON_U16_RUN (128 * 16)
+
+static unsigned int sad_neon(const unsigned char *a, unsigned int a_stride,
+		const unsigned char *b, unsigned int b_stride,
+		unsigned int width, unsigned int height)
+{
+	unsigned int vec = width & ~15u;
+	const unsigned char *pa = a;
+	const unsigned char *pb = b;
+	uint32x4_t acc = vdupq_n_u32(0);
+	uint64x2_t total;
+	unsigned int sum = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, pa += a_stride, pb += b_stride) {
+		for (x = 0; x < vec; ) {
+			unsigned int end = MIN(vec, x + NEON_U16_RUN);
+			uint16x8_t run = vdupq_n_u16(0);
+
+			for (; x < end; x += 16)
+				run = vpadalq_u8(run, vabdq_u8(vld1q_u8(pa + x), vld1q_u8(pb + x)));
+			acc = vpadalq_u16(acc, run);
+		}
+	}
+
+	total = vpaddlq_u32(acc);
+	sum = vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1);
+	if (vec < width)
+		sum += pixel_sad_c(a + vec, a_stride, b + vec, b_stride, width - vec, height);
+
+	return sum;
+}
+
+static void downscale_2x_neon(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	unsigned int vec = width & ~15u;
+	const unsigned char *s = src;
+	unsigned char *d = dst;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height / 2; y++, s += 2 * src_stride, d += dst_stride) {
+		const unsigned char *r0 = s;
+		const unsigned char *r1 = s + src_stride;
+
+		for (x = 0; x < vec; x += 16) {
+			uint16x8_t box = vpaddlq_u8(vld1q_u8(r0 + x));
+
+			box = vpadalq_u8(box, vld1q_u8(r1 + x));
+			vst1_u8(d + x / 2, vrshrn_n_u16(box, 2));
+		}
+	}
+
+	if (vec < width)
+		pixel_downscale_2x_c(src + vec, src_stride, width - vec, height,
+			dst + vec / 2, dst_stride);
+}
+
+static void downscale_4x_neon(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	unsigned int vec = width & ~31u;
+	const unsigned char *s = src;
+	unsigned char *d = dst;
+	unsigned int x = 0;
+	unsigned int y = 0;
+	unsigned int i = 0;
+
+	for (y = 0; y < height / 4; y++, s += 4 * src_stride, d += dst_stride) {
+		for (x = 0; x < vec; x += 32) {
+			uint16x8_t lo = vdupq_n_u16(0);
+			uint16x8_t hi = vdupq_n_u16(0);
+			const unsigned char *p = s + x;
+
+			for (i = 0; i < 4; i++, p += src_stride) {
+				lo = vpadalq_u8(lo, vld1q_u8(p));
+				hi = vpadalq_u8(hi, vld1q_u8(p + 16));
+			}
+
+			/* pairs of 8 pixel sums make the 16 pixel boxes */
+			vst1_u8(d + x / 4, vrshrn_n_u16(vcombine_u16(
+				vpadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+				vpadd_u16(vget_low_u16(hi), vget_high_u16(hi))), 4));
+		}
+	}
+
+	if (vec < width)
+		pixel_downscale_4x_c(src + vec, src_stride, width - vec, height,
+			dst + vec / 4, dst_stride);
+}
+
+static void sum_sq_neon(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		guint64 *sum, guint64 *sum_sq)
+{
+	unsigned int vec = width & ~15u;
+	const unsigned char *s = src;
+	uint64x2_t total = vdupq_n_u64(0);
+	uint64x2_t total_sq = vdupq_n_u64(0);
+	guint64 tail = 0;
+	guint64 tail_sq = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, s += stride) {
+		for (x = 0; x < vec; ) {
+			unsigned int end = MIN(vec, x + NEON_U16_RUN);
+			uint16x8_t run = vdupq_n_u16(0);
+			uint32x4_t run_sq = vdupq_n_u32(0);
+
+			for (; x < end; x += 16) {
+				uint8x16_t v = vld1q_u8(s + x);
+
+				run = vpadalq_u8(run, v);
+				run_sq = vpadalq_u16(run_sq, vmull_u8(vget_low_u8(v), vget_low_u8(v)));
+				run_sq = vpadalq_u16(run_sq, vmull_u8(vget_high_u8(v), vget_high_u8(v)));
+			}
+			total = vpadalq_u32(total, vpaddlq_u16(run));
+			total_sq = vpadalq_u32(total_sq, run_sq);
+		}
+	}
+
+	if (vec < width)
+		pixel_sum_sq_c(src + vec, stride, width - vec, height, &tail, &tail_sq);
+
+	*sum = vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1) + tail;
+	*sum_sq = vgetq_lane_u64(total_sq, 0) + vgetq_lane_u64(total_sq, 1) + tail_sq;
+}
+
+static const pixel_kernels pixel_kernels_neon_table = {
+	.isa = PIXEL_ISA_NEON,
+	.sad = sad_neon,
+	.downscale_2x = downscale_2x_neon,
+	.downscale_4x = downscale_4x_neon,
+	.sum_sq = sum_sq_neon,
+};
+
+const pixel_kernels *pixel_kernels_neon(void)
+{
+#if defined(__arm__)
+	if (!(getauxval(AT_HWCAP) & HWCAP_NEON))
+		return NULL;
+#endif
+
+	return &pixel_kernels_neon_table;
+}
+
+#else
+
+const pixel_kernels *pixel_kernels_neon(void)
+{
+	return NULL;
+}
+
+#endif
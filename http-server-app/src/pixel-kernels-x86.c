@@ -0,0 +1,313 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include "pixel-kernels-internal.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+
+/* built with the target attribute, used only when the CPU reports it */
+#include <immintrin.h>
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+
+SSE2 static unsigned int sad_sse2(const unsigned char *a, unsigned int a_stride,
+		const unsigned char *b, unsigned int b_stride,
+		unsigned int width, unsigned int height)
+{
+	unsigned int vec = width & ~15u;
+	const unsigned char *pa = a;
+	const unsigned char *pb = b;
+	__m128i acc = _mm_setzero_si128();
+	unsigned int sum = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, pa += a_stride, pb += b_stride)
+		for (x = 0; x < vec; x += 16)
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(
+				_mm_loadu_si128((const __m128i *)(pa + x)),
+				_mm_loadu_si128((const __m128i *)(pb + x))));
+
+	sum = _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+	if (vec < width)
+		sum += pixel_sad_c(a + vec, a_stride, b + vec, b_stride, width - vec, height);
+
+	return sum;
+}
+
+/* 16 bit sums of each byte pair */
+SSE2 static inline __m128i pair_sum_sse2(__m128i v)
+{
+	return _mm_add_epi16(_mm_and_si128(v, _mm_set1_epi16(0xff)), _mm_srli_epi16(v, 8));
+}
+
+SSE2 static void downscale_2x_sse2(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	unsigned int vec = width & ~31u;
+	const unsigned char *s = src;
+	unsigned char *d = dst;
+	const __m128i two = _mm_set1_epi16(2);
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height / 2; y++, s += 2 * src_stride, d += dst_stride) {
+		const unsigned char *r0 = s;
+		const unsigned char *r1 = s + src_stride;
+
+		for (x = 0; x < vec; x += 32) {
+			__m128i lo = _mm_add_epi16(
+				pair_sum_sse2(_mm_loadu_si128((const __m128i *)(r0 + x))),
+				pair_sum_sse2(_mm_loadu_si128((const __m128i *)(r1 + x))));
+			__m128i hi = _mm_add_epi16(
+				pair_sum_sse2(_mm_loadu_si128((const __m128i *)(r0 + x + 16))),
+				pair_sum_sse2(_mm_loadu_si128((const __m128i *)(r1 + x + 16))));
+
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+			_mm_storeu_si128((__m128i *)(d + x / 2), _mm_packus_epi16(lo, hi));
+		}
+	}
+
+	if (vec < width)
+		pixel_downscale_2x_c(src + vec, src_stride, width - vec, height,
+			dst + vec / 2, dst_stride);
+}
+
+SSE2 static void downscale_4x_sse2(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	unsigned int vec = width & ~31u;
+	const unsigned char *s = src;
+	unsigned char *d = dst;
+	const __m128i ones = _mm_set1_epi16(1);
+	const __m128i eight = _mm_set1_epi32(8);
+	unsigned int x = 0;
+	unsigned int y = 0;
+	unsigned int i = 0;
+
+	for (y = 0; y < height / 4; y++, s += 4 * src_stride, d += dst_stride) {
+		for (x = 0; x < vec; x += 32) {
+			__m128i lo = _mm_setzero_si128();
+			__m128i hi = _mm_setzero_si128();
+			const unsigned char *p = s + x;
+
+			for (i = 0; i < 4; i++, p += src_stride) {
+				lo = _mm_add_epi16(lo, pair_sum_sse2(_mm_loadu_si128((const __m128i *)p)));
+				hi = _mm_add_epi16(hi, pair_sum_sse2(_mm_loadu_si128((const __m128i *)(p + 16))));
+			}
+
+			/* pairs of 8 pixel sums make the 16 pixel boxes */
+			lo = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(lo, ones), eight), 4);
+			hi = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(hi, ones), eight), 4);
+			lo = _mm_packs_epi32(lo, hi);
+			_mm_storel_epi64((__m128i *)(d + x / 4), _mm_packus_epi16(lo, lo));
+		}
+	}
+
+	if (vec < width)
+		pixel_downscale_4x_c(src + vec, src_stride, width - vec, height,
+			dst + vec / 4, dst_stride);
+}
+
+SSE2 static void sum_sq_sse2(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		guint64 *sum, guint64 *sum_sq)
+{
+	unsigned int vec = width & ~15u;
+	const unsigned char *s = src;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i total = _mm_setzero_si128();
+	__m128i total_sq = _mm_setzero_si128();
+	guint64 lanes[2];
+	guint64 tail = 0;
+	guint64 tail_sq = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, s += stride) {
+		__m128i row_sq = _mm_setzero_si128();
+
+		for (x = 0; x < vec; x += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *)(s + x));
+			__m128i lo = _mm_unpacklo_epi8(v, zero);
+			__m128i hi = _mm_unpackhi_epi8(v, zero);
+
+			total = _mm_add_epi64(total, _mm_sad_epu8(v, zero));
+			row_sq = _mm_add_epi32(row_sq,
+				_mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+		}
+		total_sq = _mm_add_epi64(total_sq, _mm_unpacklo_epi32(row_sq, zero));
+		total_sq = _mm_add_epi64(total_sq, _mm_unpackhi_epi32(row_sq, zero));
+	}
+
+	if (vec < width)
+		pixel_sum_sq_c(src + vec, stride, width - vec, height, &tail, &tail_sq);
+
+	_mm_storeu_si128((__m128i *)lanes, total);
+	*sum = lanes[0] + lanes[1] + tail;
+	_mm_storeu_si128((__m128i *)lanes, total_sq);
+	*sum_sq = lanes[0] + lanes[1] + tail_sq;
+}
+
+AVX2 static unsigned int sad_avx2(const unsigned char *a, unsigned int a_stride,
+		const unsigned char *b, unsigned int b_stride,
+		unsigned int width, unsigned int height)
+{
+	unsigned int vec = width & ~31u;
+	const unsigned char *pa = a;
+	const unsigned char *pb = b;
+	__m256i acc = _mm256_setzero_si256();
+	__m128i half;
+	unsigned int sum = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, pa += a_stride, pb += b_stride)
+		for (x = 0; x < vec; x += 32)
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(
+				_mm256_loadu_si256((const __m256i *)(pa + x)),
+				_mm256_loadu_si256((const __m256i *)(pb + x))));
+
+	half = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+	sum = _mm_cvtsi128_si32(half) + _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+	if (vec < width)
+		sum += pixel_sad_c(a + vec, a_stride, b + vec, b_stride, width - vec, height);
+
+	return sum;
+}
+
+AVX2 static inline __m256i pair_sum_avx2(__m256i v)
+{
+	return _mm256_add_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0xff)), _mm256_srli_epi16(v, 8));
+}
+
+AVX2 static void downscale_2x_avx2(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	unsigned int vec = width & ~63u;
+	const unsigned char *s = src;
+	unsigned char *d = dst;
+	const __m256i two = _mm256_set1_epi16(2);
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height / 2; y++, s += 2 * src_stride, d += dst_stride) {
+		const unsigned char *r0 = s;
+		const unsigned char *r1 = s + src_stride;
+
+		for (x = 0; x < vec; x += 64) {
+			__m256i lo = _mm256_add_epi16(
+				pair_sum_avx2(_mm256_loadu_si256((const __m256i *)(r0 + x))),
+				pair_sum_avx2(_mm256_loadu_si256((const __m256i *)(r1 + x))));
+			__m256i hi = _mm256_add_epi16(
+				pair_sum_avx2(_mm256_loadu_si256((const __m256i *)(r0 + x + 32))),
+				pair_sum_avx2(_mm256_loadu_si256((const __m256i *)(r1 + x + 32))));
+
+			lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+			hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+			/* the pack works per 128 bit lane, put the quarters back in order */
+			_mm256_storeu_si256((__m256i *)(d + x / 2),
+				_mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8));
+		}
+	}
+
+	if (vec < width)
+		downscale_2x_sse2(src + vec, src_stride, width - vec, height,
+			dst + vec / 2, dst_stride);
+}
+
+AVX2 static void sum_sq_avx2(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		guint64 *sum, guint64 *sum_sq)
+{
+	unsigned int vec = width & ~31u;
+	const unsigned char *s = src;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i total = _mm256_setzero_si256();
+	__m256i total_sq = _mm256_setzero_si256();
+	guint64 lanes[4];
+	guint64 tail = 0;
+	guint64 tail_sq = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, s += stride) {
+		__m256i row_sq = _mm256_setzero_si256();
+
+		for (x = 0; x < vec; x += 32) {
+			__m256i v = _mm256_loadu_si256((const __m256i *)(s + x));
+			__m256i lo = _mm256_unpacklo_epi8(v, zero);
+			__m256i hi = _mm256_unpackhi_epi8(v, zero);
+
+			total = _mm256_add_epi64(total, _mm256_sad_epu8(v, zero));
+			row_sq = _mm256_add_epi32(row_sq,
+				_mm256_add_epi32(_mm256_madd_epi16(lo, lo), _mm256_madd_epi16(hi, hi)));
+		}
+		total_sq = _mm256_add_epi64(total_sq, _mm256_unpacklo_epi32(row_sq, zero));
+		total_sq = _mm256_add_epi64(total_sq, _mm256_unpackhi_epi32(row_sq, zero));
+	}
+
+	if (vec < width)
+		sum_sq_sse2(src + vec, stride, width - vec, height, &tail, &tail_sq);
+
+	_mm256_storeu_si256((__m256i *)lanes, total);
+	*sum = lanes[0] + lanes[1] + lanes[2] + lanes[3] + tail;
+	_mm256_storeu_si256((__m256i *)lanes, total_sq);
+	*sum_sq = lanes[0] + lanes[1] + lanes[2] + lanes[3] + tail_sq;
+}
+
+static const pixel_kernels pixel_kernels_sse2 = {
+	.isa = PIXEL_ISA_SSE2,
+	.sad = sad_sse2,
+	.downscale_2x = downscale_2x_sse2,
+	.downscale_4x = downscale_4x_sse2,
+	.sum_sq = sum_sq_sse2,
+};
+
+/* no 4x, 32 columns make only 8 pixels of output and lose to SSE2 */
+static const pixel_kernels pixel_kernels_avx2 = {
+	.isa = PIXEL_ISA_AVX2,
+	.sad = sad_avx2,
+	.downscale_2x = downscale_2x_avx2,
+	.sum_sq = sum_sq_avx2,
+};
+
+const pixel_kernels *pixel_kernels_x86(pixel_isa_e isa)
+{
+	__builtin_cpu_init();
+
+	if (isa == PIXEL_ISA_SSE2 && __builtin_cpu_supports("sse2"))
+		return &pixel_kernels_sse2;
+	if (isa == PIXEL_ISA_AVX2 && __builtin_cpu_supports("avx2"))
+		return &pixel_kernels_avx2;
+
+	return NULL;
+}
+
+#else
+
+const pixel_kernels *pixel_kernels_x86(pixel_isa_e isa)
+{
+	return NULL;
+}
+
+#endif
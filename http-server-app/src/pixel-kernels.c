@@ -0,0 +1,307 @@
+ /*
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include "http-server-log-private.h"
+#include "pixel-kernels-internal.h"
+
+static const pixel_kernels pixel_kernels_c = {
+	.isa = PIXEL_ISA_SCALAR,
+	.sad = pixel_sad_c,
+	.downscale_2x = pixel_downscale_2x_c,
+	.downscale_4x = pixel_downscale_4x_c,
+	.sum_sq = pixel_sum_sq_c,
+};
+
+/* by the widest instruction set allowed, filled in on the first call */
+static pixel_kernels g_composed[PIXEL_ISA_MAX];
+static gboolean g_available[PIXEL_ISA_MAX];
+static const pixel_kernels *g_kernels;
+
+unsigned int pixel_sad_c(const unsigned char *a, unsigned int a_stride,
+		const unsigned char *b, unsigned int b_stride,
+		unsigned int width, unsigned int height)
+{
+	unsigned int sum = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, a += a_stride, b += b_stride)
+		for (x = 0; x < width; x++)
+			sum += abs(a[x] - b[x]);
+
+	return sum;
+}
+
+void pixel_downscale_2x_c(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height / 2; y++, src += 2 * src_stride, dst += dst_stride) {
+		const unsigned char *r0 = src;
+		const unsigned char *r1 = src + src_stride;
+
+		for (x = 0; x < width / 2; x++)
+			dst[x] = (r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2;
+	}
+}
+
+void pixel_downscale_4x_c(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	unsigned int x = 0;
+	unsigned int y = 0;
+	unsigned int i = 0;
+
+	for (y = 0; y < height / 4; y++, src += 4 * src_stride, dst += dst_stride) {
+		for (x = 0; x < width / 4; x++) {
+			const unsigned char *p = src + 4 * x;
+			unsigned int sum = 0;
+
+			for (i = 0; i < 4; i++, p += src_stride)
+				sum += p[0] + p[1] + p[2] + p[3];
+
+			dst[x] = (sum + 8) >> 4;
+		}
+	}
+}
+
+void pixel_sum_sq_c(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		guint64 *sum, guint64 *sum_sq)
+{
+	guint64 total = 0;
+	guint64 total_sq = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+
+	for (y = 0; y < height; y++, src += stride) {
+		unsigned int row = 0;
+		unsigned int row_sq = 0; /* fits up to 66051 columns */
+
+		for (x = 0; x < width; x++) {
+			row += src[x];
+			row_sq += src[x] * src[x];
+		}
+		total += row;
+		total_sq += row_sq;
+	}
+
+	*sum = total;
+	*sum_sq = total_sq;
+}
+
+/*
+ * Four tables so that runs of one value do not wait on the same counter.
+ * Scalar only, without a vector gather SIMD is no faster.
+ */
+static void histogram_c(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		unsigned int hist[256])
+{
+	unsigned int part[4][256];
+	unsigned int x = 0;
+	unsigned int y = 0;
+	unsigned int i = 0;
+
+	memset(part, 0, sizeof(part));
+
+	for (y = 0; y < height; y++, src += stride) {
+		for (x = 0; x + 4 <= width; x += 4) {
+			part[0][src[x]]++;
+			part[1][src[x + 1]]++;
+			part[2][src[x + 2]]++;
+			part[3][src[x + 3]]++;
+		}
+		for (; x < width; x++)
+			part[0][src[x]]++;
+	}
+
+	for (i = 0; i < 256; i++)
+		hist[i] = part[0][i] + part[1][i] + part[2][i] + part[3][i];
+}
+
+static const pixel_kernels *kernels_for_isa(pixel_isa_e isa)
+{
+	switch (isa) {
+	case PIXEL_ISA_SCALAR:
+		return &pixel_kernels_c;
+	case PIXEL_ISA_SSE2:
+	case PIXEL_ISA_AVX2:
+		return pixel_kernels_x86(isa);
+	case PIXEL_ISA_NEON:
+		return pixel_kernels_neon();
+	default:
+		return NULL;
+	}
+}
+
+static void kernels_overlay(pixel_kernels *composed, const pixel_kernels *kernels)
+{
+	if (kernels->sad)
+		composed->sad = kernels->sad;
+	if (kernels->downscale_2x)
+		composed->downscale_2x = kernels->downscale_2x;
+	if (kernels->downscale_4x)
+		composed->downscale_4x = kernels->downscale_4x;
+	if (kernels->sum_sq)
+		composed->sum_sq = kernels->sum_sq;
+}
+
+/* each kernel from the widest instruction set up to isa that has one */
+static void kernels_init(void)
+{
+	static gsize once = 0;
+	const pixel_kernels *kernels = NULL;
+	int isa = 0;
+	int narrower = 0;
+
+	if (!g_once_init_enter(&once))
+		return;
+
+	for (isa = PIXEL_ISA_SCALAR; isa < PIXEL_ISA_MAX; isa++) {
+		if (!kernels_for_isa(isa))
+			continue;
+
+		g_composed[isa] = pixel_kernels_c;
+		for (narrower = PIXEL_ISA_SCALAR + 1; narrower <= isa; narrower++) {
+			kernels = kernels_for_isa(narrower);
+			if (kernels)
+				kernels_overlay(&g_composed[isa], kernels);
+		}
+		g_composed[isa].isa = isa;
+		g_available[isa] = TRUE;
+	}
+
+	g_once_init_leave(&once, 1);
+}
+
+static const pixel_kernels *kernels_get(void)
+{
+	const pixel_kernels *kernels = g_atomic_pointer_get(&g_kernels);
+	int isa = 0;
+
+	if (G_LIKELY(kernels))
+		return kernels;
+
+	kernels_init();
+
+	/* later entries of pixel_isa_e are the wider ones */
+	for (isa = PIXEL_ISA_MAX - 1; isa > PIXEL_ISA_SCALAR; isa--)
+		if (g_available[isa])
+			break;
+	kernels = &g_composed[isa];
+	_D("pixel kernels use [%s]", pixel_kernels_isa_name(kernels->isa));
+
+	/* racing first callers pick the same table */
+	g_atomic_pointer_set(&g_kernels, kernels);
+
+	return kernels;
+}
+
+unsigned int pixel_sad(const unsigned char *a, unsigned int a_stride,
+		const unsigned char *b, unsigned int b_stride,
+		unsigned int width, unsigned int height)
+{
+	retv_if(!a || !b, 0);
+
+	return kernels_get()->sad(a, a_stride, b, b_stride, width, height);
+}
+
+void pixel_downscale_2x(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	ret_if(!src || !dst);
+
+	kernels_get()->downscale_2x(src, src_stride, width, height, dst, dst_stride);
+}
+
+void pixel_downscale_4x(const unsigned char *src, unsigned int src_stride,
+		unsigned int width, unsigned int height,
+		unsigned char *dst, unsigned int dst_stride)
+{
+	ret_if(!src || !dst);
+
+	kernels_get()->downscale_4x(src, src_stride, width, height, dst, dst_stride);
+}
+
+void pixel_mean_variance(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		double *mean, double *variance)
+{
+	guint64 sum = 0;
+	guint64 sum_sq = 0;
+	double n = (double)width * height;
+	double m = 0.0;
+
+	ret_if(!src || !width || !height);
+
+	kernels_get()->sum_sq(src, stride, width, height, &sum, &sum_sq);
+
+	m = sum / n;
+	if (mean)
+		*mean = m;
+	if (variance)
+		*variance = MAX(sum_sq / n - m * m, 0.0);
+}
+
+void pixel_histogram(const unsigned char *src, unsigned int stride,
+		unsigned int width, unsigned int height,
+		unsigned int hist[256])
+{
+	ret_if(!src || !hist);
+
+	histogram_c(src, stride, width, height, hist);
+}
+
+pixel_isa_e pixel_kernels_get_isa(void)
+{
+	return kernels_get()->isa;
+}
+
+int pixel_kernels_set_isa(pixel_isa_e isa)
+{
+	kernels_init();
+
+	/* callers probe, not finding one is no error */
+	if (isa < PIXEL_ISA_SCALAR || isa >= PIXEL_ISA_MAX || !g_available[isa])
+		return -1;
+
+	g_atomic_pointer_set(&g_kernels, &g_composed[isa]);
+
+	return 0;
+}
+
+const char *pixel_kernels_isa_name(pixel_isa_e isa)
+{
+	static const char *names[PIXEL_ISA_MAX] = {
+		[PIXEL_ISA_SCALAR] = "scalar",
+		[PIXEL_ISA_SSE2] = "sse2",
+		[PIXEL_ISA_AVX2] = "avx2",
+		[PIXEL_ISA_NEON] = "neon",
+	};
+
+	retv_if(isa < 0 || isa >= PIXEL_ISA_MAX, "unknown");
+
+	return names[isa];
+}
@@ -24,18 +24,47 @@
 
 #include "app.h"
 #include "http-server-log-private.h"
+#include "http-server-metrics.h"
 #include "face-detect.h"
+#include "frame-pool.h"
+#include "motion-gate.h"
 
-#define CAMERA_PREVIEW_INTERVAL_MIN 3000 // 1 sec
+#define CAMERA_DETECT_INTERVAL 3000 /* msec, on a still scene */
 #define IMAGE_WIDTH 320
 #define IMAGE_HEIGHT 240
+#define FRAME_POOL_SLOTS 3 /* filling, in the mailbox and detecting */
 
-struct _camdata {
+/* one per camera device, a preview frame only touches its own camera */
+struct _usb_camera {
     camera_h g_camera; /* Camera handle */
+    camera_device_e device;
+    void *data; /* app data the results are handed to */
+    frame_pool *pool; /* sized for the negotiated preview resolution */
+    face_detector *detector;
+    metrics_counter *preview;
+    metrics_counter *frames;
+    metrics_counter *dropped;
+    metrics_counter *still;
+
+    /* detection policy */
+    bool motion; /* detect on motion, not only every interval_ms */
+    unsigned int interval_ms;
+    motion_gate *gate;
+    long long int last_detect;
+
+    /* last recognized face, written by the detection worker */
+    GMutex lock;
+    face_recognize_result result;
+    bool has_result;
 };
-typedef struct _camdata camdata;
-static camdata cam_data;
 
+static struct {
+	bool motion;
+	unsigned int interval_ms;
+} g_policy = {
+	.motion = true,
+	.interval_ms = CAMERA_DETECT_INTERVAL,
+};
 
 static void _print_camera_state(camera_state_e previous, camera_state_e current, bool by_policy, void *user_data)
 {
@@ -83,15 +112,36 @@ static void _rotate_90(unsigned char *source, int width, int height, unsigned ch
 	}
 }
 
-static int _frame_to_source(camera_preview_data_s *frame, mv_source_h *source)
+static unsigned char *_frame_get_y(camera_preview_data_s *frame)
+{
+	unsigned char *buff_y = NULL;
+
+	// Image Plane : 3
+	//_D("Image Plane : %d", frame->num_of_planes);
+	switch (frame->num_of_planes) {
+	case 3:
+		buff_y = frame->data.triple_plane.y;
+		break;
+	case 2:
+		buff_y = frame->data.double_plane.y;
+		break;
+	case 1:
+		buff_y = frame->data.single_plane.yuv;
+		break;
+	default:
+		_E("default : %d", frame->num_of_planes);
+	}
+
+	return buff_y;
+}
+
+static int _frame_to_buffer(camera_preview_data_s *frame, frame_buffer *buffer)
 {
 	mv_colorspace_e colorspace = MEDIA_VISION_COLORSPACE_INVALID;
 	unsigned char *buff_y = NULL;
-	int image_plane = 0;
 	int size = 0;
 	int error_code = 0;
 
-	image_plane = frame->num_of_planes;
 	size = frame->width * frame->height;
 
 	switch (frame->format) {
@@ -133,118 +183,191 @@ static int _frame_to_source(camera_preview_data_s *frame, mv_source_h *source)
 	}
 	retv_if(colorspace == MEDIA_VISION_COLORSPACE_INVALID, -1);
 
-	if (*source) {
-		//_D("Clear the MV source");
-		mv_source_clear(*source);
-	} else {
-		//_D("Create a MV source");
-		error_code = mv_create_source(source);
-		retv_if(error_code != MEDIA_VISION_ERROR_NONE, -1);
-	}
-
-	// Image Plane : 3
-	//_D("Image Plane : %d", image_plane);
-	switch (image_plane) {
-	case 3:
-		buff_y = frame->data.triple_plane.y;
-		break;
-	case 2:
-		buff_y = frame->data.double_plane.y;
-		break;
-	case 1:
-		buff_y = frame->data.single_plane.yuv;
-		break;
-	default:
-		_E("default : %d", image_plane);
-	}
+	buff_y = _frame_get_y(frame);
+	retv_if(!buff_y, -1);
 
 	//_D("Filling the source");
-	error_code = mv_source_fill_by_buffer(*source, buff_y, size,
+	error_code = frame_buffer_fill(buffer, buff_y, size,
 			frame->width,
 			frame->height,
 			MEDIA_VISION_COLORSPACE_Y800);
 			//colorspace); /* FIXME : MEDIA_VISION_COLORSPACE_Y800 */
-	goto_if(error_code != MEDIA_VISION_ERROR_NONE, ERROR);
+	retv_if(error_code != 0, -1);
 
 	return 0;
-
-ERROR:
-	mv_destroy_source(*source);
-	*source = NULL;
-	return -1;
 }
 
 static void _camera_preview_cb(camera_preview_data_s *frame, void *user_data)
 {
-	static long long int last = 0;
+	usb_camera *camera = user_data;
 	long long int now = _get_monotonic_ms();
+	frame_buffer *buffer = NULL;
+	unsigned char *buff_y = NULL;
+	bool moved = false;
 	int error_code = 0;
-	app_data *ad = user_data;
 
-	if (now - last < CAMERA_PREVIEW_INTERVAL_MIN)
+	metrics_counter_add(camera->preview, 1);
+
+	/* runs on every frame, a still scene is only sampled every interval */
+	if (camera->gate) {
+		buff_y = _frame_get_y(frame);
+		moved = buff_y && motion_gate_check(camera->gate, buff_y, frame->width, frame->height);
+	}
+
+	if (!moved && now - camera->last_detect < camera->interval_ms) {
+		metrics_counter_add(camera->still, 1);
 		return;
+	}
 
-	error_code = _frame_to_source(frame, &ad->source);
-	if (error_code != 0) _E("FAIL : Frame to source");
+	metrics_counter_add(camera->frames, 1);
 
-	error_code = face_detect_with_source(ad->source, user_data);
+	/* every slot is still held by a later stage */
+	buffer = frame_pool_acquire(camera->pool);
+	if (!buffer) {
+		metrics_counter_add(camera->dropped, 1);
+		return;
+	}
+
+	error_code = _frame_to_buffer(frame, buffer);
+	if (error_code != 0) {
+		_E("FAIL : Frame to source");
+		frame_buffer_unref(buffer);
+		return;
+	}
+
+	error_code = face_detect_with_frame(camera->detector, buffer);
 	if (error_code < 0) _E("Failed to detect faces");
 
-	last = now;
+	frame_buffer_unref(buffer);
+
+	camera->last_detect = now;
+}
+
+/* runs on the detection worker of the camera */
+static void _camera_recognized_cb(const face_recognize_result *result, void *user_data)
+{
+	usb_camera *camera = user_data;
+
+	g_mutex_lock(&camera->lock);
+	camera->result = *result;
+	camera->has_result = true;
+	g_mutex_unlock(&camera->lock);
+
+	face_recognize_notify(camera->data, camera->device, result);
+}
+
+static void _camera_free(usb_camera *camera)
+{
+	if (camera->g_camera) {
+		camera_destroy(camera->g_camera);
+		camera->g_camera = NULL;
+	}
+
+	/* joins the worker, no result callback runs after this */
+	face_detect_stop(camera->detector);
+
+	/* a frame still referenced keeps the pool until it is released */
+	if (camera->pool)
+		frame_pool_free(camera->pool);
+	if (camera->gate)
+		motion_gate_free(camera->gate);
+	g_mutex_clear(&camera->lock);
+	g_free(camera);
 }
 
-int usb_camera_prepare(void *data)
+void usb_camera_set_detect_policy(bool motion, unsigned int interval_ms)
 {
+	g_policy.motion = motion;
+	g_policy.interval_ms = interval_ms;
+}
+
+usb_camera *usb_camera_prepare(camera_device_e device, void *data)
+{
+	usb_camera *camera = NULL;
+	char *label = NULL;
 	int error_code = 0;
 	camera_state_e state;
+	int width = 0;
+	int height = 0;
+
+	_D("Preparing your camera [%d].", device);
 
-	_D("Preparing your camera.");
+	camera = g_new0(usb_camera, 1);
+	camera->device = device;
+	camera->data = data;
+	camera->motion = g_policy.motion;
+	camera->interval_ms = g_policy.interval_ms;
+	g_mutex_init(&camera->lock);
 
 	/* Create the camera handle */
-	/* The CAMERA_DEVICE_CAMERA0 parameter means that the currently activated device camera is 0,
-	 * which is the primary camera. You can select between the primary (0) and secondary (1) camera.
+	/* The device parameter selects the camera, CAMERA_DEVICE_CAMERA0 is the primary camera.
 	 * These values are defined in the  camera_device_e enumeration (in mobile and wearable applications). */
-	error_code = camera_create(CAMERA_DEVICE_CAMERA0, &cam_data.g_camera);
-	retv_if(error_code != CAMERA_ERROR_NONE, -1);
+	error_code = camera_create(device, &camera->g_camera);
+	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 
 	/* Check the camera state after creating the camera */
 	/* The returned state is one of the values defined in the camera_state_e enumeration
 	 * (in mobile and wearable applications).
 	 * If the state is not CAMERA_STATE_CREATED, re-initialize the camera by recreating the handle. */
-	error_code = camera_get_state(cam_data.g_camera, &state);
+	error_code = camera_get_state(camera->g_camera, &state);
 	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 	goto_if(state != CAMERA_STATE_CREATED, ERROR);
 
 	/* The image quality value can range from 1 (lowest quality) to 100 (highest quality). */
-	error_code = camera_attr_set_image_quality(cam_data.g_camera, 100);
+	error_code = camera_attr_set_image_quality(camera->g_camera, 100);
+	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
+
+	error_code = camera_set_preview_resolution(camera->g_camera, IMAGE_WIDTH, IMAGE_HEIGHT);
 	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 
-	error_code = camera_set_preview_resolution(cam_data.g_camera, IMAGE_WIDTH, IMAGE_HEIGHT);
+	error_code = camera_set_capture_resolution(camera->g_camera, IMAGE_WIDTH, IMAGE_HEIGHT);
 	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 
-	error_code = camera_set_capture_resolution(cam_data.g_camera, IMAGE_WIDTH, IMAGE_HEIGHT);
+	/* the camera may settle on another resolution than the one asked for */
+	error_code = camera_get_preview_resolution(camera->g_camera, &width, &height);
 	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 
+	camera->pool = frame_pool_new(FRAME_POOL_SLOTS, width, height);
+	goto_if(!camera->pool, ERROR);
+
+	if (camera->motion) {
+		camera->gate = motion_gate_new(width, height);
+		goto_if(!camera->gate, ERROR);
+	}
+
+	label = g_strdup_printf("%d", device);
+	camera->preview = metrics_counter_get_labeled("camera_preview_frames_total", "camera", label,
+		"Camera preview frames delivered");
+	camera->frames = metrics_counter_get_labeled("camera_frames_total", "camera", label,
+		"Camera frames passed to face detection");
+	camera->dropped = metrics_counter_get_labeled("camera_frames_dropped_total", "camera", label,
+		"Camera frames dropped for lack of a free frame pool slot");
+	camera->still = metrics_counter_get_labeled("camera_frames_still_total", "camera", label,
+		"Camera frames skipped without motion between detection intervals");
+
 	/* CAMERA_PIXEL_FORMAT_RGBA : Not supported */
 	/* FIXME : CAMERA_PIXEL_FORMAT_JPEG */
-	error_code = camera_set_capture_format(cam_data.g_camera, CAMERA_PIXEL_FORMAT_JPEG);
+	error_code = camera_set_capture_format(camera->g_camera, CAMERA_PIXEL_FORMAT_JPEG);
 	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 
-	error_code = camera_set_state_changed_cb(cam_data.g_camera, _print_camera_state, NULL);
+	error_code = camera_set_state_changed_cb(camera->g_camera, _print_camera_state, NULL);
 	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 
-	error_code = camera_set_preview_cb(cam_data.g_camera, _camera_preview_cb, data);
+	camera->detector = face_detect_start(label, _camera_recognized_cb, camera);
+	goto_if(!camera->detector, ERROR);
+
+	error_code = camera_set_preview_cb(camera->g_camera, _camera_preview_cb, camera);
 	goto_if(error_code != CAMERA_ERROR_NONE, ERROR);
 
-	return 0;
+	g_free(label);
+
+	return camera;
 
 ERROR:
-	if (cam_data.g_camera) {
-		camera_destroy(cam_data.g_camera);
-		cam_data.g_camera = NULL;
-	}
+	g_free(label);
+	_camera_free(camera);
 
-	return -1;
+	return NULL;
 }
 
 static const char * _cam_err_to_str(camera_error_e err)
@@ -301,16 +424,16 @@ static const char * _cam_err_to_str(camera_error_e err)
 	return err_str;
 }
 
-int usb_camera_preview(void *data)
+int usb_camera_preview(usb_camera *camera)
 {
 	camera_state_e state;
 	int error_code = 0;
 
-	retv_if(!cam_data.g_camera, -1);
+	retv_if(!camera, -1);
 
 	_D("Start to preview with your camera.");
 
-	error_code = camera_get_state(cam_data.g_camera, &state);
+	error_code = camera_get_state(camera->g_camera, &state);
 	if (error_code != CAMERA_ERROR_NONE) {
 		_E("Failed to get camera state [%s]", _cam_err_to_str(error_code));
 		return -1;
@@ -322,7 +445,7 @@ int usb_camera_preview(void *data)
 	}
 
 	if (state != CAMERA_STATE_PREVIEW) {
-		error_code = camera_start_preview(cam_data.g_camera);
+		error_code = camera_start_preview(camera->g_camera);
 		if (error_code != CAMERA_ERROR_NONE) {
 			_E("Failed to start preview [%s]", _cam_err_to_str(error_code));
 			return -1;
@@ -344,30 +467,31 @@ static void __capturing_cb(camera_image_data_s *image, camera_image_data_s *post
 
 static void _completed_cb(void *user_data)
 {
+	usb_camera *camera = user_data;
 	int error_code = 0;
 
-	if (!cam_data.g_camera) {
+	if (!camera->g_camera) {
 		_E("Camera is NULL");
 		return;
 	}
 
-	error_code = camera_start_preview(cam_data.g_camera);
+	error_code = camera_start_preview(camera->g_camera);
 	if (error_code != CAMERA_ERROR_NONE) {
 		_E("Failed to start preview [%s]", _cam_err_to_str(error_code));
 		return;
 	}
 }
 
-int usb_camera_capture(void *user_data)
+int usb_camera_capture(usb_camera *camera)
 {
 	camera_state_e state;
 	int error_code = 0;
 
-	retv_if(!cam_data.g_camera, -1);
+	retv_if(!camera, -1);
 
 	_D("Try to capture the preview.");
 
-	error_code = camera_get_state(cam_data.g_camera, &state);
+	error_code = camera_get_state(camera->g_camera, &state);
 	if (error_code != CAMERA_ERROR_NONE) {
 		_E("Failed to get camera state [%s]", _cam_err_to_str(error_code));
 		return -1;
@@ -380,14 +504,14 @@ int usb_camera_capture(void *user_data)
 
 	if (state != CAMERA_STATE_PREVIEW) {
 		_I("Preview is not started [%d]", state);
-		error_code = camera_start_preview(cam_data.g_camera);
+		error_code = camera_start_preview(camera->g_camera);
 		if (error_code != CAMERA_ERROR_NONE) {
 			_E("Failed to start preview [%s]", _cam_err_to_str(error_code));
 			return -1;
 		}
 	}
 
-	error_code = camera_start_capture(cam_data.g_camera, __capturing_cb, _completed_cb, user_data);
+	error_code = camera_start_capture(camera->g_camera, __capturing_cb, _completed_cb, camera);
 	if (error_code != CAMERA_ERROR_NONE) {
 		_E("Failed to start capturing [%s]", _cam_err_to_str(error_code));
 		return -1;
@@ -396,14 +520,28 @@ int usb_camera_capture(void *user_data)
 	return 0;
 }
 
-void usb_camera_unprepare(void *data)
+bool usb_camera_get_result(usb_camera *camera, face_recognize_result *result)
+{
+	bool has_result = false;
+
+	retv_if(!camera || !result, false);
+
+	g_mutex_lock(&camera->lock);
+	has_result = camera->has_result;
+	if (has_result)
+		*result = camera->result;
+	g_mutex_unlock(&camera->lock);
+
+	return has_result;
+}
+
+void usb_camera_unprepare(usb_camera *camera)
 {
-	if (!cam_data.g_camera)
+	if (!camera)
 		return;
 
-	camera_unset_preview_cb(cam_data.g_camera);
-	camera_stop_preview(cam_data.g_camera);
+	camera_unset_preview_cb(camera->g_camera);
+	camera_stop_preview(camera->g_camera);
 
-	camera_destroy(cam_data.g_camera);
-	cam_data.g_camera = NULL;
+	_camera_free(camera);
 }